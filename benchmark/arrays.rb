@@ -0,0 +1,58 @@
+# frozen_string_literal: true
+
+require 'bundler/inline'
+
+gemfile(true, quiet: true) do
+  source 'https://rubygems.org'
+  gem 'benchmark'
+end
+
+require_relative '../lib/quickjs'
+
+# Array conversion at analytics-result sizes, both ways: JS -> Ruby is an
+# eval returning a prebuilt array, Ruby -> JS is a `call` taking one. The
+# JS side of each is O(1) (a global read, `.length`), so the times are
+# conversion. The packed rows do the same with Float64Array / Int32Array
+# on both sides.
+LENGTH = 1_000_000
+ITERATIONS = 5
+
+vm = Quickjs::VM.new(memory_limit: 1024 * 1024 * 1024, timeout_msec: 60_000)
+vm.eval_code(<<~JS)
+  globalThis.ints = Array.from({ length: #{LENGTH} }, (_, i) => i);
+  globalThis.floats = Array.from({ length: #{LENGTH} }, (_, i) => i + 0.5);
+  globalThis.strings = Array.from({ length: #{LENGTH} }, (_, i) => 'row-' + i);
+  globalThis.packedInts = Int32Array.from(ints);
+  globalThis.packedFloats = Float64Array.from(floats);
+  globalThis.take = (a) => a.length;
+  void 0;
+JS
+
+RUBY_ARRAYS = {
+  'ints'    => Array.new(LENGTH) { |i| i },
+  'floats'  => Array.new(LENGTH) { |i| i + 0.5 },
+  'strings' => Array.new(LENGTH) { |i| "row-#{i}" },
+}
+
+PACKED = {
+  'packedInts'   => Quickjs::Int32Array.new(RUBY_ARRAYS['ints']),
+  'packedFloats' => Quickjs::Float64Array.new(RUBY_ARRAYS['floats']),
+}
+
+puts "Ruby #{RUBY_VERSION} / quickjs.rb #{Quickjs::VERSION}"
+puts "#{LENGTH} elements, best of #{ITERATIONS}"
+puts
+
+def best(&block)
+  Array.new(ITERATIONS) { GC.start; Benchmark.realtime(&block) }.min
+end
+
+label_width = 29
+puts "#{'conversion'.ljust(label_width)}      ms   Melem/s"
+RUBY_ARRAYS.merge(PACKED).each do |kind, input|
+  [["JS -> Ruby (#{kind})", -> { vm.eval_code(kind) }],
+   ["Ruby -> JS (#{kind})", -> { vm.call(:take, input) }]].each do |label, work|
+    seconds = best(&work)
+    puts format('%s  %8.1f  %8.2f', label.ljust(label_width), seconds * 1000, LENGTH / seconds / 1e6)
+  end
+end
@@ -0,0 +1,91 @@
+# frozen_string_literal: true
+
+require_relative '../lib/quickjs'
+
+# Per-worker memory in a preforking setup, with and without
+# Quickjs.preload_for_fork in the master. Each worker builds VMs that load
+# a registered polyfill and run a bundle, then reports its
+# /proc/self/smaps_rollup: Shared_* pages are still the master's,
+# Private_* pages are the worker's own. Linux only.
+abort 'benchmark/fork_rss.rb needs /proc/self/smaps_rollup (Linux)' unless File.exist?('/proc/self/smaps_rollup')
+
+WORKERS = 4
+VMS_PER_WORKER = 8
+
+# Stand-ins for a large polyfill and an SSR bundle: many small functions,
+# so the bytecode is a few MB.
+def synthetic_bundle(prefix, count)
+  fns = Array.new(count) { |i| "function #{prefix}#{i}(a, b) { return [a, b, '#{prefix}-#{i}'].join(':'); }" }
+  "#{fns.join("\n")}\nglobalThis.#{prefix}Count = #{count}; #{prefix}#{count - 1}(1, 2);"
+end
+
+POLYFILL_SOURCE = synthetic_bundle('poly', 20_000)
+BUNDLE_SOURCE = synthetic_bundle('ssr', 40_000)
+
+def smaps_kb
+  File.foreach('/proc/self/smaps_rollup').each_with_object({}) do |line, kb|
+    key, value = line.split(':', 2)
+    kb[key] = value.to_i if value&.include?('kB')
+  end
+end
+
+def run_workers(bundle)
+  readers = Array.new(WORKERS) do
+    reader, writer = IO.pipe
+    pid = fork do
+      reader.close
+      bundle ||= Quickjs.compile(BUNDLE_SOURCE, timeout_msec: 60_000)
+      vms = Array.new(VMS_PER_WORKER) do
+        vm = Quickjs::VM.new(features: [:polyfill_fork_rss], timeout_msec: 10_000)
+        bundle.run(on: vm)
+        vm
+      end
+      GC.start
+      writer.write(Marshal.dump(smaps_kb))
+      writer.close
+      vms.each(&:dispose!)
+      exit!(0)
+    end
+    writer.close
+    [pid, reader]
+  end
+
+  readers.map do |pid, reader|
+    kb = Marshal.load(reader.read)
+    reader.close
+    Process.wait(pid)
+    kb
+  end
+end
+
+def report(label, samples)
+  avg = ->(key) { samples.sum { |kb| kb.fetch(key, 0) } / samples.length }
+  shared = avg.('Shared_Clean') + avg.('Shared_Dirty')
+  private_kb = avg.('Private_Clean') + avg.('Private_Dirty')
+  puts format('%-34s %12d %12d %12d', label, avg.('Rss'), shared, private_kb)
+end
+
+puts "Ruby #{RUBY_VERSION} / quickjs.rb #{Quickjs::VERSION}"
+puts "#{WORKERS} workers x #{VMS_PER_WORKER} VMs; per-worker averages in kB"
+puts
+puts format('%-34s %12s %12s %12s', 'master setup', 'RSS', 'shared', 'private')
+
+# Each mode runs in its own master so the registry starts uncompiled.
+[false, true].each do |preload|
+  reader, writer = IO.pipe
+  pid = fork do
+    reader.close
+    Quickjs.register_polyfill(:polyfill_fork_rss, source: POLYFILL_SOURCE)
+    bundle = Quickjs.preload_for_fork(features: [:polyfill_fork_rss], sources: {ssr: BUNDLE_SOURCE})[:ssr] if preload
+    writer.write(Marshal.dump([run_workers(bundle), Quickjs.preload_stats[:sealed_bytes]]))
+    writer.close
+    exit!(0)
+  end
+  writer.close
+  samples, sealed_bytes = Marshal.load(reader.read)
+  reader.close
+  Process.wait(pid)
+
+  label = preload ? "preload_for_fork (#{sealed_bytes / 1024} kB sealed)" : 'no preload'
+  report(label, samples)
+end
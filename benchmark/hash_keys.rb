@@ -0,0 +1,65 @@
+# frozen_string_literal: true
+
+require 'bundler/inline'
+
+gemfile(true, quiet: true) do
+  source 'https://rubygems.org'
+  gem 'benchmark'
+end
+
+require_relative '../lib/quickjs'
+
+# GC pressure of converting an array of records: objects allocated, GC
+# runs, and time per conversion, with String keys and with
+# symbolize_names. Before keys were interned, each record allocated one
+# String per property on top of its values; compare against an older
+# checkout to see the difference.
+#
+# The last two rows go the other way, passing records into a call: there
+# the VM's key atom cache saves re-interning each property name.
+RECORDS = 50_000
+FIELDS = 10
+ITERATIONS = 5
+
+vm = Quickjs::VM.new(memory_limit: 1024 * 1024 * 1024, timeout_msec: 60_000)
+vm.eval_code(<<~JS)
+  globalThis.records = Array.from({ length: #{RECORDS} }, (_, i) => {
+    const row = {};
+    for (let f = 0; f < #{FIELDS}; f++) row['field_' + f] = i + f;
+    return row;
+  });
+  globalThis.getRecords = () => records;
+  globalThis.countRecords = (rows) => rows.length;
+  void 0;
+JS
+
+string_rows = Array.new(RECORDS) { |i| Array.new(FIELDS) { |f| ["field_#{f}", i + f] }.to_h }
+symbol_rows = string_rows.map { |row| row.transform_keys(&:to_sym) }
+
+puts "Ruby #{RUBY_VERSION} / quickjs.rb #{Quickjs::VERSION}"
+puts "#{RECORDS} records x #{FIELDS} keys, best of #{ITERATIONS}"
+puts
+
+CASES = {
+  'eval_code'                       => -> { vm.eval_code('records') },
+  'eval_code symbolize_names: true' => -> { vm.eval_code('records', symbolize_names: true) },
+  'call'                            => -> { vm.call('getRecords') },
+  'call symbolize_names: true'      => -> { vm.call('getRecords', symbolize_names: true) },
+  'call with String-keyed records'  => -> { vm.call('countRecords', string_rows) },
+  'call with Symbol-keyed records'  => -> { vm.call('countRecords', symbol_rows) },
+}
+
+label_width = CASES.keys.map(&:length).max
+puts "#{''.ljust(label_width)}        ms   objects/record   GC runs"
+CASES.each do |label, run|
+  run.call # warm up: interns the keys once
+  samples = Array.new(ITERATIONS) do
+    GC.start
+    before = GC.stat
+    elapsed = Benchmark.realtime(&run)
+    after = GC.stat
+    [elapsed, after[:total_allocated_objects] - before[:total_allocated_objects], after[:count] - before[:count]]
+  end
+  elapsed, allocated, gc_runs = samples.min_by(&:first)
+  puts format('%s  %8.1f  %15.1f  %8d', label.ljust(label_width), elapsed * 1000, allocated.fdiv(RECORDS), gc_runs)
+end
@@ -0,0 +1,42 @@
+# frozen_string_literal: true
+
+require 'bundler/inline'
+
+gemfile(true, quiet: true) do
+  source 'https://rubygems.org'
+  gem 'benchmark'
+end
+
+require_relative '../lib/quickjs'
+
+# A large request context of which the script reads a handful of fields:
+# passing the Hash copies all of it into JS on every call, a Quickjs::Ref
+# only looks up the four properties the script touches.
+ITEMS = 100_000
+ITERATIONS = 5
+
+vm = Quickjs::VM.new(memory_limit: 1024 * 1024 * 1024, timeout_msec: 60_000)
+vm.eval_code(<<~JS)
+  globalThis.price = (c, i) => c.flags.sale ? c.items[i].price * 0.9 : c.items[i].price;
+  void 0;
+JS
+
+catalog = {
+  'flags' => { 'sale' => true },
+  'items' => Array.new(ITEMS) { |i| { 'sku' => "sku-#{i}", 'name' => "Item #{i}", 'price' => i, 'tags' => %w[a b] } },
+}
+
+puts "Ruby #{RUBY_VERSION} / quickjs.rb #{Quickjs::VERSION}"
+puts "#{ITEMS} catalog items, best of #{ITERATIONS}"
+puts
+
+def best(&block)
+  Array.new(ITERATIONS) { GC.start; Benchmark.realtime(&block) }.min
+end
+
+label_width = 20
+puts "#{'argument'.ljust(label_width)}          ms"
+[['Hash (eager copy)', -> { vm.call(:price, catalog, 42) }],
+ ['Quickjs::Ref', -> { vm.call(:price, Quickjs::Ref.new(catalog), 42) }]].each do |label, work|
+  puts format('%s  %10.3f', label.ljust(label_width), best(&work) * 1000)
+end
@@ -0,0 +1,53 @@
+# frozen_string_literal: true
+
+require 'bundler/inline'
+
+gemfile(true, quiet: true) do
+  source 'https://rubygems.org'
+  gem 'benchmark'
+end
+
+require 'json'
+require_relative '../lib/quickjs'
+
+# "JSON in, JSON out" calls at 10KB to 10MB: the object path (JSON.parse,
+# call converting the Hash in and the result out, JSON.generate) against
+# call_json, which hands JSON text across as-is. The JS side returns its
+# argument with a field added, so the times are mostly conversion.
+SIZES = {'10KB' => 10 * 1024, '100KB' => 100 * 1024, '1MB' => 1024 * 1024, '10MB' => 10 * 1024 * 1024}
+ITERATIONS = 5
+
+def payload(bytes)
+  row = {'id' => 0, 'title' => 'Lorem ipsum dolor sit amet', 'tags' => %w[a b c], 'price' => 12.5, 'active' => true}
+  rows = Array.new([bytes / JSON.generate(row).bytesize, 1].max) { |i| row.merge('id' => i) }
+  JSON.generate({'rows' => rows})
+end
+
+vm = Quickjs::VM.new(memory_limit: 1024 * 1024 * 1024, timeout_msec: 60_000)
+vm.eval_code('globalThis.render = (props) => ({ ...props, rendered: true }); void 0')
+
+puts "Ruby #{RUBY_VERSION} / quickjs.rb #{Quickjs::VERSION}"
+puts "best of #{ITERATIONS}"
+puts
+
+def best(&block)
+  Array.new(ITERATIONS) { GC.start; Benchmark.realtime(&block) }.min
+end
+
+puts "payload      objects ms   call_json ms   speedup"
+SIZES.each do |label, bytes|
+  json = payload(bytes)
+  objects = best { JSON.generate(vm.call('render', JSON.parse(json))) }
+  json_mode = best { vm.call_json('render', json) }
+  puts format('%-8s  %12.2f  %13.2f  %7.1fx', label, objects * 1000, json_mode * 1000, objects / json_mode)
+end
+
+puts
+puts "eval_code result of the same size:"
+puts "payload      objects ms   result: :json ms"
+SIZES.each do |label, bytes|
+  vm.eval_code("globalThis.built = #{payload(bytes)}; void 0")
+  objects = best { JSON.generate(vm.eval_code('built')) }
+  json_mode = best { vm.eval_code('built', result: :json) }
+  puts format('%-8s  %12.2f  %17.2f', label, objects * 1000, json_mode * 1000)
+end
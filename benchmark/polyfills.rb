@@ -22,6 +22,8 @@ CASES = [
   ['VM instantiation (POLYFILL_URL)',   -> { Quickjs::VM.new(features: [Quickjs::POLYFILL_URL]) }],
   ['VM instantiation (POLYFILL_CRYPTO)', -> { Quickjs::VM.new(features: [Quickjs::POLYFILL_CRYPTO]) }],
   ['VM instantiation (all polyfills)',  -> { Quickjs::VM.new(features: [Quickjs::POLYFILL_ENCODING, Quickjs::POLYFILL_FILE, Quickjs::POLYFILL_URL, Quickjs::POLYFILL_CRYPTO]) }],
+  ['VM instantiation (all polyfills, lazy)', -> { Quickjs::VM.new(features: [Quickjs::POLYFILL_ENCODING, Quickjs::POLYFILL_FILE, Quickjs::POLYFILL_URL, Quickjs::POLYFILL_CRYPTO], lazy_polyfills: true) }],
+  ['VM instantiation + new URL() (all polyfills, lazy)', -> { Quickjs::VM.new(features: [Quickjs::POLYFILL_ENCODING, Quickjs::POLYFILL_FILE, Quickjs::POLYFILL_URL, Quickjs::POLYFILL_CRYPTO], lazy_polyfills: true).eval_code("new URL('https://example.com/').hostname") }],
   nil,
   ['eval simple expr (no polyfill)',    -> { vm = Quickjs::VM.new; -> { vm.eval_code('1 + 1') } }],
   nil,
@@ -0,0 +1,85 @@
+# frozen_string_literal: true
+
+require 'bundler/inline'
+
+gemfile(true, quiet: true) do
+  source 'https://rubygems.org'
+  gem 'benchmark'
+end
+
+require 'etc'
+require_relative '../lib/quickjs'
+
+# VM construction throughput and latency per configuration, then where
+# the time goes (VM#init_profile). Complements benchmark/polyfills.rb,
+# which times single-threaded construction only.
+CONFIGS = {
+  'none'                => {},
+  'intrinsics: [:json]' => {intrinsics: [:json]},
+  'MODULE_STD'          => {features: [Quickjs::MODULE_STD]},
+  'POLYFILL_ENCODING'   => {features: [Quickjs::POLYFILL_ENCODING]},
+  'POLYFILL_FILE'       => {features: [Quickjs::POLYFILL_FILE]},
+  'POLYFILL_URL'        => {features: [Quickjs::POLYFILL_URL]},
+  'all polyfills'       => {features: [Quickjs::POLYFILL_ENCODING, Quickjs::POLYFILL_FILE, Quickjs::POLYFILL_URL, Quickjs::POLYFILL_CRYPTO]},
+}
+
+THREAD_COUNTS = [1, 2, 4, 8]
+VMS_PER_THREAD = 50
+PROFILE_SAMPLES = 20
+
+def build(opts, count)
+  Array.new(count) do
+    started = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+    Quickjs::VM.new(**opts).dispose!
+    Process.clock_gettime(Process::CLOCK_MONOTONIC) - started
+  end
+end
+
+def percentile(sorted, p)
+  sorted[((sorted.length - 1) * p).round]
+end
+
+puts "Ruby #{RUBY_VERSION} / quickjs.rb #{Quickjs::VERSION}"
+puts "#{VMS_PER_THREAD} VMs/thread; latency covers VM.new + dispose!"
+puts "Cores reported: #{Etc.nprocessors}"
+puts
+
+# Warm up: load the extension and compile registered polyfills.
+CONFIGS.each_value { |opts| build(opts, 2) }
+
+label_width = CONFIGS.keys.map(&:length).max
+puts "#{'VM.new options'.ljust(label_width)}  threads      VMs/sec   p50 ms   p99 ms"
+CONFIGS.each do |label, opts|
+  THREAD_COUNTS.each do |n|
+    latencies = []
+    elapsed = Benchmark.realtime do
+      Array.new(n) { Thread.new { build(opts, VMS_PER_THREAD) } }.each { |t| latencies.concat(t.value) }
+    end
+    latencies.sort!
+    puts format('%s  %7d  %11.1f  %7.3f  %7.3f',
+                label.ljust(label_width), n, latencies.length / elapsed,
+                percentile(latencies, 0.50) * 1000, percentile(latencies, 0.99) * 1000)
+  end
+  puts
+end
+
+puts "Construction phases (single thread, mean of #{PROFILE_SAMPLES} VMs):"
+CONFIGS.each do |label, opts|
+  rows = Hash.new { |h, k| h[k] = {msec: 0.0, allocations: 0} }
+  heap_bytes = 0
+  PROFILE_SAMPLES.times do
+    vm = Quickjs::VM.new(**opts, profile_init: true)
+    heap_bytes += vm.heap_bytes
+    vm.init_profile.each do |row|
+      rows[row[:phase]][:msec] += row[:msec]
+      rows[row[:phase]][:allocations] += row[:allocations]
+    end
+    vm.dispose!
+  end
+
+  puts "  #{label} (#{heap_bytes / PROFILE_SAMPLES} heap bytes after construction)"
+  rows.each do |phase, totals|
+    puts format('    %-28s %8.3f ms  %8d allocations',
+                phase, totals[:msec] / PROFILE_SAMPLES, totals[:allocations] / PROFILE_SAMPLES)
+  end
+end
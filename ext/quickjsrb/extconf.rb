@@ -19,6 +19,15 @@ $srcs = [
   'quickjsrb_file.c',
   'quickjsrb_crypto.c',
   'quickjsrb_crypto_subtle.c',
+  'quickjsrb_runtime.c',
+  'quickjsrb_arena.c',
+  'quickjsrb_heap.c',
+  'quickjsrb_reaper.c',
+  'quickjsrb_preload.c',
+  'quickjsrb_bytes.c',
+  'quickjsrb_object_ref.c',
+  'quickjsrb_typed_array.c',
+  'quickjsrb_ref.c',
 ]
 
 append_cflags('-g')
@@ -48,6 +57,14 @@ abort('could not find quickjs.h') unless find_header('quickjs.h')
 abort('could not find cutils.h') unless find_header('cutils.h')
 abort('could not find quickjs-libc.h') unless find_header('quickjs-libc.h')
 
+# JS_NewArrayFrom builds an array from a C buffer in one allocation; older
+# QuickJS checkouts fall back to appending elements one at a time. A
+# compile check, not have_func: quickjs.c is linked into this extension,
+# not a library mkmf could link a probe against.
+if checking_for('JS_NewArrayFrom in quickjs.h') { try_compile("#include \"quickjs.h\"\nint main(void) { return JS_NewArrayFrom != 0; }") }
+  $defs << '-DHAVE_JS_NEWARRAYFROM'
+end
+
 # Makes all symbols private by default to avoid unintended conflict
 # with other gems. To explicitly export symbols you can use RUBY_FUNC_EXPORTED
 # selectively, or entirely remove this flag.
@@ -1,6 +1,13 @@
 #include "quickjsrb.h"
 #include "quickjsrb_file.h"
 #include "quickjsrb_crypto.h"
+#include "quickjsrb_runtime.h"
+#include "quickjsrb_reaper.h"
+#include "quickjsrb_preload.h"
+#include "quickjsrb_bytes.h"
+#include "quickjsrb_object_ref.h"
+#include "quickjsrb_typed_array.h"
+#include "quickjsrb_ref.h"
 
 const char *featureStdId = "feature_std";
 const char *featureOsId = "feature_os";
@@ -30,13 +37,66 @@ static void run_gvl_release_region(VMData *data, void *(*job_run)(void *), void
 
 JSValue to_js_value(JSContext *ctx, VALUE r_value);
 VALUE to_rb_value(JSContext *ctx, JSValue j_val);
-static VALUE to_rb_value_inner(JSContext *ctx, JSValue j_val, VALUE r_visited);
+
+// JS object pointers a conversion has entered, to break cycles: an
+// open-addressing set with linear probing, sized on first use and doubled
+// at half full. Entries are never removed, as a later visit to the same
+// object converts to nil.
+typedef struct VisitedSet
+{
+  uintptr_t *slots; // 0 marks an empty slot
+  size_t capacity;  // a power of two
+  size_t count;
+} VisitedSet;
+
+// Per-conversion state, threaded through to_rb_value_inner.
+typedef struct RbConversion
+{
+  JSContext *ctx;
+  VisitedSet visited;
+  // JSAtom -> Ruby key (js_atom_to_rb_key), created on first use. Each
+  // atom in it holds a reference until the conversion ends, so getters or
+  // toJSON running mid-conversion can't free one and hand its number to
+  // another name.
+  VALUE r_keys;
+  // JS values a converter still reads from while it recurses (the entries
+  // of a Map or Set). rb_conversion_cleanup frees them, so a raise part way
+  // through doesn't leak them.
+  JSValue *held;
+  size_t held_len;
+  size_t held_cap;
+  // eval_code / call(symbolize_names: true): object keys become Symbols.
+  bool symbolize_names;
+  // eval_code(materialize: :lazy): objects stop at a Quickjs::ObjectRef on
+  // this VM instead of being converted. Qnil for eager conversion.
+  VALUE r_lazy_vm;
+} RbConversion;
+
+// Options of an eval_code / call whose result is being handed back. NULL
+// means the defaults: String keys, eager conversion.
+typedef struct ResultOpts
+{
+  bool symbolize_names;
+  VALUE r_lazy_vm;
+  // eval_code(result: :json) / call_json: JSON text instead of objects.
+  bool json;
+} ResultOpts;
+
+static VALUE to_rb_value_inner(JSContext *ctx, JSValue j_val, RbConversion *conv);
 static VALUE vm_m_memoryUsage(VALUE r_self);
 static VALUE vm_m_runGC(VALUE r_self);
+static VALUE vm_m_heapBytes(VALUE r_self);
+static VALUE vm_m_initProfile(VALUE r_self);
+static VALUE vm_m_initPhase(VALUE r_self, VALUE r_phase);
 static VALUE vm_m_memoryPoisoned(VALUE r_self);
+static VALUE vm_m_interrupted(VALUE r_self);
 static VALUE vm_m_dispose(VALUE r_self);
+static VALUE vm_m_disposeLater(VALUE r_self);
 static VALUE vm_m_disposed(VALUE r_self);
 static VALUE vm_m_drainJobs(VALUE r_self);
+static VALUE vm_m_runtime(VALUE r_self);
+static VALUE vm_m_resetContext(VALUE r_self, VALUE r_features);
+static VALUE vm_m_rebuildRuntime(VALUE r_self, VALUE r_features);
 
 JSValue j_error_from_ruby_error(JSContext *ctx, VALUE r_error)
 {
@@ -63,27 +123,138 @@ typedef struct
   JSValue j_obj;
 } RbHashToJsArg;
 
-static int rb_hash_entry_to_js(VALUE r_key, VALUE r_val, VALUE extra)
+// Every row of an Array of Hashes repeats the same keys, so their atoms
+// are kept on the VM instead of re-interned per property. Only Symbols
+// and frozen Strings (which Hash#[]= makes of String keys) are cached,
+// up to QUICKJSRB_ATOM_CACHE_MAX: each entry keeps its atom alive until
+// the context goes. *cached tells the caller whether to free the atom;
+// JS_ATOM_NULL means interning failed.
+#define QUICKJSRB_ATOM_CACHE_MAX 4096
+
+static JSAtom atom_cache_insert(JSContext *ctx, VMData *data, st_table **table, st_data_t key,
+                                const char *name, bool *cached)
 {
-  RbHashToJsArg *arg = (RbHashToJsArg *)extra;
-  const char *key_cstr;
+  JSAtom atom = JS_NewAtom(ctx, name);
+  if (atom == JS_ATOM_NULL || data->cached_atoms >= QUICKJSRB_ATOM_CACHE_MAX)
+    return atom;
+
+  if (*table == NULL)
+    *table = table == &data->sym_atoms ? st_init_numtable() : st_init_strtable();
+  if (table == &data->str_atoms)
+  {
+    char *copy = strdup(name);
+    if (copy == NULL)
+      return atom;
+    key = (st_data_t)copy;
+  }
+  st_insert(*table, key, (st_data_t)atom);
+  data->cached_atoms++;
+  *cached = true;
+  return atom;
+}
+
+// r_key is a Symbol or a String rb_hash_entry_to_js has already checked
+// with StringValueCStr, so nothing here raises.
+static JSAtom rb_hash_key_atom(JSContext *ctx, VALUE r_key, bool *cached)
+{
+  VMData *data = JS_GetContextOpaque(ctx);
+  st_data_t j_atom;
+  *cached = false;
   if (SYMBOL_P(r_key))
   {
-    key_cstr = rb_id2name(SYM2ID(r_key));
+    ID id = SYM2ID(r_key);
+    if (data->sym_atoms != NULL && st_lookup(data->sym_atoms, (st_data_t)id, &j_atom))
+    {
+      *cached = true;
+      return (JSAtom)j_atom;
+    }
+    return atom_cache_insert(ctx, data, &data->sym_atoms, (st_data_t)id, rb_id2name(id), cached);
   }
-  else if (RB_TYPE_P(r_key, T_STRING))
+
+  const char *key_cstr = RSTRING_PTR(r_key);
+  if (!OBJ_FROZEN(r_key))
+    return JS_NewAtom(ctx, key_cstr);
+  if (data->str_atoms != NULL && st_lookup(data->str_atoms, (st_data_t)key_cstr, &j_atom))
   {
-    key_cstr = StringValueCStr(r_key);
+    *cached = true;
+    return (JSAtom)j_atom;
   }
-  else
+  return atom_cache_insert(ctx, data, &data->str_atoms, (st_data_t)key_cstr, key_cstr, cached);
+}
+
+// Defines rather than sets, as JSON.parse does: a "__proto__" key becomes
+// an own property instead of swapping the prototype. The key is checked
+// before the value converts and interned after, so a raise in either
+// leaves nothing held.
+static int rb_hash_entry_to_js(VALUE r_key, VALUE r_val, VALUE extra)
+{
+  RbHashToJsArg *arg = (RbHashToJsArg *)extra;
+  if (!SYMBOL_P(r_key))
+  {
+    if (!RB_TYPE_P(r_key, T_STRING))
+      r_key = rb_funcall(r_key, rb_intern("to_s"), 0);
+    StringValueCStr(r_key);
+  }
+  JSValue j_val = to_js_value(arg->ctx, r_val);
+
+  bool cached;
+  JSAtom atom = rb_hash_key_atom(arg->ctx, r_key, &cached);
+  if (atom == JS_ATOM_NULL)
   {
-    VALUE r_key_str = rb_funcall(r_key, rb_intern("to_s"), 0);
-    key_cstr = StringValueCStr(r_key_str);
+    JS_FreeValue(arg->ctx, j_val);
+    return ST_CONTINUE;
   }
-  JS_SetPropertyStr(arg->ctx, arg->j_obj, key_cstr, to_js_value(arg->ctx, r_val));
+  JS_DefinePropertyValue(arg->ctx, arg->j_obj, atom, j_val, JS_PROP_C_W_E);
+  if (!cached)
+    JS_FreeAtom(arg->ctx, atom);
+  RB_GC_GUARD(r_key);
   return ST_CONTINUE;
 }
 
+// Converts element by element into a C buffer, then builds the array in
+// one go: JS_NewArrayFrom sizes the fast array's storage once instead of
+// growing it per element. Element conversion can run Ruby code (inspect,
+// to_s) that shrinks the Array, so its length is re-read as we go.
+static JSValue rb_array_to_js(JSContext *ctx, VALUE r_value)
+{
+  long len = RARRAY_LEN(r_value);
+#ifdef HAVE_JS_NEWARRAYFROM
+  VALUE r_tmp;
+  JSValue *j_values = ALLOCV_N(JSValue, r_tmp, len);
+  long count = 0;
+  for (; count < len && count < RARRAY_LEN(r_value); count++)
+    j_values[count] = to_js_value(ctx, RARRAY_AREF(r_value, count));
+  // Takes ownership of the values, on failure too.
+  JSValue j_arr = JS_NewArrayFrom(ctx, (int)count, j_values);
+  ALLOCV_END(r_tmp);
+  return j_arr;
+#else
+  // Defining (rather than setting) each index appends to the fast array
+  // directly, without consulting setters on Array.prototype.
+  JSValue j_arr = JS_NewArray(ctx);
+  for (long i = 0; i < len && i < RARRAY_LEN(r_value); i++)
+    JS_DefinePropertyValueUint32(ctx, j_arr, (uint32_t)i, to_js_value(ctx, RARRAY_AREF(r_value, i)), JS_PROP_C_W_E);
+  return j_arr;
+#endif
+}
+
+// ASCII-8BIT Strings are bytes, not text: they become a Uint8Array over
+// one copy, so binary payloads (images, protobuf) survive the trip. A
+// context built without the typed array intrinsics gets a string instead.
+static JSValue rb_binary_str_to_js(JSContext *ctx, VALUE r_value)
+{
+  VMData *data = JS_GetContextOpaque(ctx);
+  if (!JS_IsObject(data->j_uint8array_ctor))
+    return JS_NewStringLen(ctx, RSTRING_PTR(r_value), RSTRING_LEN(r_value));
+
+  JSValue j_buf = JS_NewArrayBufferCopy(ctx, (const uint8_t *)RSTRING_PTR(r_value), (size_t)RSTRING_LEN(r_value));
+  if (JS_IsException(j_buf))
+    return j_buf;
+  JSValue j_bytes = JS_CallConstructor(ctx, data->j_uint8array_ctor, 1, (JSValueConst *)&j_buf);
+  JS_FreeValue(ctx, j_buf);
+  return j_bytes;
+}
+
 JSValue to_js_value(JSContext *ctx, VALUE r_value)
 {
   switch (TYPE(r_value))
@@ -98,27 +269,21 @@ JSValue to_js_value(JSContext *ctx, VALUE r_value)
   {
     VALUE r_str = rb_funcall(r_value, rb_intern("to_s"), 0);
     JSValue j_str = JS_NewStringLen(ctx, RSTRING_PTR(r_str), RSTRING_LEN(r_str));
-    JSValue j_global = JS_GetGlobalObject(ctx);
-    JSValue j_numberClass = JS_GetPropertyStr(ctx, j_global, "Number");
-    JSValue j_num = JS_Call(ctx, j_numberClass, JS_UNDEFINED, 1, (JSValueConst *)&j_str);
+    VMData *data = JS_GetContextOpaque(ctx);
+    JSValue j_num = JS_Call(ctx, data->j_number_ctor, JS_UNDEFINED, 1, (JSValueConst *)&j_str);
     JS_FreeValue(ctx, j_str);
-    JS_FreeValue(ctx, j_numberClass);
-    JS_FreeValue(ctx, j_global);
     return j_num;
   }
   case T_STRING:
+    if (rb_enc_get_index(r_value) == rb_ascii8bit_encindex())
+      return rb_binary_str_to_js(ctx, r_value);
     return JS_NewStringLen(ctx, RSTRING_PTR(r_value), RSTRING_LEN(r_value));
   case T_SYMBOL:
   {
     if (r_value == QUICKJSRB_SYM(undefinedId))
       return JS_UNDEFINED;
     if (r_value == QUICKJSRB_SYM(nanId))
-    {
-      JSValue j_global = JS_GetGlobalObject(ctx);
-      JSValue j_nan = JS_GetPropertyStr(ctx, j_global, "NaN");
-      JS_FreeValue(ctx, j_global);
-      return j_nan;
-    }
+      return JS_NewFloat64(ctx, NAN);
     const char *name = rb_id2name(SYM2ID(r_value));
     return JS_NewString(ctx, name);
   }
@@ -127,15 +292,7 @@ JSValue to_js_value(JSContext *ctx, VALUE r_value)
   case T_FALSE:
     return JS_FALSE;
   case T_ARRAY:
-  {
-    int len = RARRAY_LEN(r_value);
-    JSValue j_arr = JS_NewArray(ctx);
-    for (int i = 0; i < len; i++)
-    {
-      JS_SetPropertyUint32(ctx, j_arr, (uint32_t)i, to_js_value(ctx, RARRAY_AREF(r_value, i)));
-    }
-    return j_arr;
-  }
+    return rb_array_to_js(ctx, r_value);
   case T_HASH:
   {
     JSValue j_obj = JS_NewObject(ctx);
@@ -145,6 +302,12 @@ JSValue to_js_value(JSContext *ctx, VALUE r_value)
   }
   default:
   {
+    if (rb_obj_is_kind_of(r_value, quickjsrb_class_bytes))
+      return quickjsrb_bytes_to_js(ctx, r_value);
+    if (rb_obj_is_kind_of(r_value, quickjsrb_class_float64_array) || rb_obj_is_kind_of(r_value, quickjsrb_class_int32_array))
+      return quickjsrb_typed_array_to_js(ctx, r_value);
+    if (rb_obj_is_kind_of(r_value, quickjsrb_class_ref))
+      return quickjsrb_ref_to_js(ctx, r_value);
     if (rb_obj_is_kind_of(r_value, rb_cFile))
     {
       VMData *data = JS_GetContextOpaque(ctx);
@@ -239,65 +402,406 @@ VALUE to_r_json(JSContext *ctx, JSValue j_val)
   return r_str;
 }
 
-static int js_is_plain_object(JSContext *ctx, JSValue j_val)
+static size_t visited_slot(uintptr_t ptr, size_t mask)
+{
+  // Object pointers are at least 8-aligned; Fibonacci hashing spreads
+  // the rest.
+  return (size_t)(((uint64_t)(ptr >> 3) * UINT64_C(0x9E3779B97F4A7C15)) >> 32) & mask;
+}
+
+static void visited_grow(VisitedSet *set)
+{
+  size_t capacity = set->capacity == 0 ? 64 : set->capacity * 2;
+  uintptr_t *slots = ZALLOC_N(uintptr_t, capacity);
+  for (size_t i = 0; i < set->capacity; i++)
+  {
+    uintptr_t ptr = set->slots[i];
+    if (ptr == 0)
+      continue;
+    size_t j = visited_slot(ptr, capacity - 1);
+    while (slots[j] != 0)
+      j = (j + 1) & (capacity - 1);
+    slots[j] = ptr;
+  }
+  xfree(set->slots);
+  set->slots = slots;
+  set->capacity = capacity;
+}
+
+// Adds the object behind j_val; false if the conversion already entered it.
+static bool visited_add(VisitedSet *set, JSValueConst j_val)
+{
+  uintptr_t ptr = (uintptr_t)JS_VALUE_GET_PTR(j_val);
+  if ((set->count + 1) * 2 > set->capacity)
+    visited_grow(set);
+  size_t mask = set->capacity - 1;
+  for (size_t i = visited_slot(ptr, mask);; i = (i + 1) & mask)
+  {
+    if (set->slots[i] == ptr)
+      return false;
+    if (set->slots[i] == 0)
+    {
+      set->slots[i] = ptr;
+      set->count++;
+      return true;
+    }
+  }
+}
+
+// Hands j_val to the conversion to free when it ends.
+static JSValue rb_conversion_hold(RbConversion *conv, JSValue j_val)
+{
+  if (conv->held_len == conv->held_cap)
+  {
+    size_t cap = conv->held_cap == 0 ? 8 : conv->held_cap * 2;
+    JSValue *grown = realloc(conv->held, cap * sizeof(JSValue));
+    if (grown == NULL)
+    {
+      JS_FreeValue(conv->ctx, j_val);
+      rb_memerror();
+    }
+    conv->held = grown;
+    conv->held_cap = cap;
+  }
+  conv->held[conv->held_len++] = j_val;
+  return j_val;
+}
+
+// Deeper than any chain the kinds above sit on; also where a Proxy whose
+// getPrototypeOf keeps returning fresh Proxies stops being followed.
+#define QUICKJSRB_OBJECT_KIND_MAX_DEPTH 64
+
+static inline bool js_same_object(JSValueConst j_a, JSValueConst j_b)
+{
+  return JS_IsObject(j_a) && JS_IsObject(j_b) && JS_VALUE_GET_PTR(j_a) == JS_VALUE_GET_PTR(j_b);
+}
+
+// Classifies j_val with one walk up its prototype chain, compared by
+// identity against the builtins' prototypes captured in vm_setup_context.
+// Unlike instanceof, nothing user-defined (Symbol.hasInstance) runs; a
+// Proxy's getPrototypeOf trap can, and whatever it throws is dropped and
+// the object left as OTHER. Subclass instances take their builtin's kind.
+// Plain is an Object.prototype or null prototype at the first link.
+static QuickjsrbObjectKind js_object_kind(JSContext *ctx, JSValueConst j_val)
 {
+  VMData *data = JS_GetContextOpaque(ctx);
+  QuickjsrbObjectKind kind = QUICKJSRB_OBJECT_OTHER;
   JSValue j_proto = JS_GetPrototype(ctx, j_val);
-  if (JS_IsNull(j_proto))
-    return 1; // Object.create(null)
-  JSValue j_global = JS_GetGlobalObject(ctx);
-  JSValue j_Object = JS_GetPropertyStr(ctx, j_global, "Object");
-  JSValue j_Object_proto = JS_GetPropertyStr(ctx, j_Object, "prototype");
-  int result = JS_StrictEq(ctx, j_proto, j_Object_proto);
+  for (int depth = 0; depth < QUICKJSRB_OBJECT_KIND_MAX_DEPTH; depth++)
+  {
+    if (JS_IsException(j_proto))
+    {
+      JS_FreeValue(ctx, JS_GetException(ctx));
+      return QUICKJSRB_OBJECT_OTHER;
+    }
+    if (!JS_IsObject(j_proto))
+    {
+      // Object.create(null) is plain; the end of any longer chain isn't.
+      kind = depth == 0 ? QUICKJSRB_OBJECT_PLAIN : QUICKJSRB_OBJECT_OTHER;
+      break;
+    }
+    if (js_same_object(j_proto, data->j_object_prototype))
+    {
+      kind = depth == 0 ? QUICKJSRB_OBJECT_PLAIN : QUICKJSRB_OBJECT_OTHER;
+      break;
+    }
+    if (js_same_object(j_proto, data->j_arraybuffer_prototype))
+    {
+      kind = QUICKJSRB_OBJECT_ARRAY_BUFFER;
+      break;
+    }
+    if (js_same_object(j_proto, data->j_float64array_prototype))
+    {
+      kind = QUICKJSRB_OBJECT_FLOAT64_ARRAY;
+      break;
+    }
+    if (js_same_object(j_proto, data->j_int32array_prototype))
+    {
+      kind = QUICKJSRB_OBJECT_INT32_ARRAY;
+      break;
+    }
+    if (js_same_object(j_proto, data->j_typedarray_prototype))
+    {
+      kind = QUICKJSRB_OBJECT_TYPED_ARRAY;
+      break;
+    }
+    if (js_same_object(j_proto, data->j_date_prototype))
+    {
+      kind = QUICKJSRB_OBJECT_DATE;
+      break;
+    }
+    if (js_same_object(j_proto, data->j_map_prototype))
+    {
+      kind = QUICKJSRB_OBJECT_MAP;
+      break;
+    }
+    if (js_same_object(j_proto, data->j_set_prototype))
+    {
+      kind = QUICKJSRB_OBJECT_SET;
+      break;
+    }
+    if (js_same_object(j_proto, data->j_array_prototype))
+      break;
+    JSValue j_next = JS_GetPrototype(ctx, j_proto);
+    JS_FreeValue(ctx, j_proto);
+    j_proto = j_next;
+  }
   JS_FreeValue(ctx, j_proto);
-  JS_FreeValue(ctx, j_global);
-  JS_FreeValue(ctx, j_Object);
-  JS_FreeValue(ctx, j_Object_proto);
-  return result;
+  return kind;
 }
 
-static VALUE js_array_to_rb(JSContext *ctx, JSValue j_val, VALUE r_visited)
+static VALUE js_array_to_rb(JSContext *ctx, JSValue j_val, RbConversion *conv)
 {
   JSValue j_length = JS_GetPropertyStr(ctx, j_val, "length");
   uint32_t length = 0;
   JS_ToUint32(ctx, &length, j_length);
   JS_FreeValue(ctx, j_length);
 
+  // QuickJS has no public accessor for a fast array's backing store, but
+  // an integer index already takes its fast-array path internally. What's
+  // left per element is conversion: numbers, booleans and nil are done
+  // inline here, and only strings and objects go through the full
+  // to_rb_value_inner dispatch.
   VALUE r_array = rb_ary_new_capa(length);
   for (uint32_t i = 0; i < length; i++)
   {
     JSValue j_elem = JS_GetPropertyUint32(ctx, j_val, i);
-    rb_ary_push(r_array, to_rb_value_inner(ctx, j_elem, r_visited));
-    JS_FreeValue(ctx, j_elem);
+    VALUE r_elem;
+    switch (JS_VALUE_GET_NORM_TAG(j_elem))
+    {
+    case JS_TAG_INT:
+      r_elem = INT2NUM(JS_VALUE_GET_INT(j_elem));
+      break;
+    case JS_TAG_FLOAT64:
+      r_elem = JS_VALUE_IS_NAN(j_elem) ? QUICKJSRB_SYM(nanId) : DBL2NUM(JS_VALUE_GET_FLOAT64(j_elem));
+      break;
+    case JS_TAG_BOOL:
+      r_elem = JS_VALUE_GET_BOOL(j_elem) ? Qtrue : Qfalse;
+      break;
+    case JS_TAG_NULL:
+      r_elem = Qnil;
+      break;
+    default:
+      r_elem = to_rb_value_inner(ctx, j_elem, conv);
+      JS_FreeValue(ctx, j_elem);
+      break;
+    }
+    rb_ary_push(r_array, r_elem);
   }
   return r_array;
 }
 
-static VALUE js_plain_object_to_rb(JSContext *ctx, JSValue j_val, VALUE r_visited)
+// Map → Hash and Set → Set, through Array.from: one JS call yields the
+// entries as a dense array, read back like js_array_to_rb does. Keys are
+// converted like any value (a Map's keys needn't be strings). Qundef when
+// j_val only inherits from Map.prototype and Array.from rejects it.
+static VALUE js_collection_to_rb(JSContext *ctx, JSValue j_val, bool is_map, RbConversion *conv)
+{
+  VMData *data = JS_GetContextOpaque(ctx);
+  JSValue j_entries = JS_Call(ctx, data->j_array_from, JS_UNDEFINED, 1, (JSValueConst *)&j_val);
+  if (JS_IsException(j_entries))
+  {
+    JS_FreeValue(ctx, JS_GetException(ctx));
+    return Qundef;
+  }
+  rb_conversion_hold(conv, j_entries);
+
+  JSValue j_length = JS_GetPropertyStr(ctx, j_entries, "length");
+  uint32_t length = 0;
+  JS_ToUint32(ctx, &length, j_length);
+  JS_FreeValue(ctx, j_length);
+
+  if (!is_map)
+  {
+    VALUE r_values = js_array_to_rb(ctx, j_entries, conv);
+    return rb_funcall(rb_path2class("Set"), rb_intern("new"), 1, r_values);
+  }
+
+  // A key or value has to outlive its own conversion, which can run user
+  // JS (getters, toJSON) that empties the entry it came from; the
+  // conversion holds both, so they're freed when it ends, raise or not.
+  VALUE r_hash = rb_hash_new_capa(length);
+  for (uint32_t i = 0; i < length; i++)
+  {
+    JSValue j_entry = JS_GetPropertyUint32(ctx, j_entries, i);
+    JSValue j_key = rb_conversion_hold(conv, JS_GetPropertyUint32(ctx, j_entry, 0));
+    JSValue j_value = rb_conversion_hold(conv, JS_GetPropertyUint32(ctx, j_entry, 1));
+    JS_FreeValue(ctx, j_entry);
+    VALUE r_key = to_rb_value_inner(ctx, j_key, conv);
+    rb_hash_aset(r_hash, r_key, to_rb_value_inner(ctx, j_value, conv));
+  }
+  return r_hash;
+}
+
+// Date → a UTC Time at the same millisecond; an invalid Date is nil, as
+// its toJSON would give. Qundef when j_val isn't a real Date.
+static VALUE js_date_to_rb(JSContext *ctx, JSValue j_val)
+{
+  VMData *data = JS_GetContextOpaque(ctx);
+  JSValue j_time = JS_Call(ctx, data->j_date_get_time, j_val, 0, NULL);
+  if (JS_IsException(j_time))
+  {
+    JS_FreeValue(ctx, JS_GetException(ctx));
+    return Qundef;
+  }
+  double ms = NAN;
+  JS_ToFloat64(ctx, &ms, j_time);
+  JS_FreeValue(ctx, j_time);
+  if (isnan(ms))
+    return Qnil;
+
+  double sec = floor(ms / 1000);
+  long nsec = (long)((ms - sec * 1000) * 1000000);
+  return rb_funcall(rb_time_nano_new((time_t)sec, nsec), rb_intern("utc"), 0);
+}
+
+// quickjsrb_js_buffer_to_rb_str for an object already classified by
+// js_object_kind.
+static VALUE js_buffer_to_rb_str(JSContext *ctx, JSValueConst j_val, QuickjsrbObjectKind kind)
+{
+  if (kind != QUICKJSRB_OBJECT_ARRAY_BUFFER && !quickjsrb_object_kind_typed_array_p(kind))
+    return Qnil;
+  bool is_typed_array = kind != QUICKJSRB_OBJECT_ARRAY_BUFFER;
+
+  size_t byte_offset = 0, byte_length = 0, bytes_per_element = 0;
+  JSValue j_buf = is_typed_array ? JS_GetTypedArrayBuffer(ctx, j_val, &byte_offset, &byte_length, &bytes_per_element)
+                                 : JS_DupValue(ctx, j_val);
+  if (JS_IsException(j_buf))
+  {
+    // An ordinary object given a typed array prototype.
+    JS_FreeValue(ctx, JS_GetException(ctx));
+    return Qnil;
+  }
+  size_t buf_size = 0;
+  uint8_t *buf = JS_GetArrayBuffer(ctx, &buf_size, j_buf);
+  JS_FreeValue(ctx, j_buf);
+  if (buf == NULL)
+  {
+    // Detached: no bytes left to copy.
+    JS_FreeValue(ctx, JS_GetException(ctx));
+    return rb_str_new(NULL, 0);
+  }
+
+  if (!is_typed_array)
+  {
+    byte_offset = 0;
+    byte_length = buf_size;
+  }
+  else if (byte_offset > buf_size || byte_length > buf_size - byte_offset)
+  {
+    byte_length = 0;
+  }
+  return rb_str_new((const char *)buf + byte_offset, (long)byte_length);
+}
+
+VALUE quickjsrb_js_buffer_to_rb_str(JSContext *ctx, JSValueConst j_val)
+{
+  if (!JS_IsObject(j_val))
+    return Qnil;
+  return js_buffer_to_rb_str(ctx, j_val, js_object_kind(ctx, j_val));
+}
+
+// Ruby key for a property atom. Records from one result usually share
+// their keys, so each distinct atom is converted once per conversion and
+// every Hash gets the same object: a frozen, interned String (or, with
+// symbolize_names, a Symbol) rather than a fresh String per property.
+static VALUE js_atom_to_rb_key(JSContext *ctx, JSAtom atom, RbConversion *conv)
+{
+  if (NIL_P(conv->r_keys))
+    conv->r_keys = rb_hash_new();
+  VALUE r_atom = UINT2NUM(atom);
+  VALUE r_key = rb_hash_lookup2(conv->r_keys, r_atom, Qundef);
+  if (r_key != Qundef)
+    return r_key;
+
+  const char *key = JS_AtomToCString(ctx, atom);
+  if (key == NULL)
+    return Qnil;
+  size_t len = strlen(key);
+  r_key = conv->symbolize_names
+              ? ID2SYM(rb_intern3(key, (long)len, rb_utf8_encoding()))
+              : rb_enc_interned_str(key, (long)len, rb_utf8_encoding());
+  JS_FreeCString(ctx, key);
+  JS_DupAtom(ctx, atom);
+  rb_hash_aset(conv->r_keys, r_atom, r_key);
+  return r_key;
+}
+
+static VALUE js_plain_object_to_rb(JSContext *ctx, JSValue j_val, RbConversion *conv)
 {
   JSPropertyEnum *ptab;
   uint32_t plen;
   if (JS_GetOwnPropertyNames(ctx, &ptab, &plen, j_val, JS_GPN_STRING_MASK | JS_GPN_ENUM_ONLY) < 0)
     return rb_hash_new();
 
-  VALUE r_hash = rb_hash_new();
+  VALUE r_hash = rb_hash_new_capa(plen);
   for (uint32_t i = 0; i < plen; i++)
   {
-    const char *key = JS_AtomToCString(ctx, ptab[i].atom);
+    VALUE r_key = js_atom_to_rb_key(ctx, ptab[i].atom, conv);
     JSValue j_prop = JS_GetProperty(ctx, j_val, ptab[i].atom);
-    rb_hash_aset(r_hash, rb_str_new2(key), to_rb_value_inner(ctx, j_prop, r_visited));
-    JS_FreeCString(ctx, key);
+    rb_hash_aset(r_hash, r_key, to_rb_value_inner(ctx, j_prop, conv));
     JS_FreeValue(ctx, j_prop);
   }
   JS_FreePropertyEnum(ctx, ptab, plen);
   return r_hash;
 }
 
+struct rb_conversion_run
+{
+  RbConversion *conv;
+  JSValue j_val;
+};
+
+static VALUE rb_conversion_run(VALUE p)
+{
+  struct rb_conversion_run *run = (struct rb_conversion_run *)p;
+  return to_rb_value_inner(run->conv->ctx, run->j_val, run->conv);
+}
+
+static int rb_conversion_free_atom(VALUE r_atom, VALUE r_key, VALUE p)
+{
+  JS_FreeAtom((JSContext *)p, (JSAtom)NUM2UINT(r_atom));
+  return ST_CONTINUE;
+}
+
+static VALUE rb_conversion_cleanup(VALUE p)
+{
+  RbConversion *conv = ((struct rb_conversion_run *)p)->conv;
+  if (!NIL_P(conv->r_keys))
+    rb_hash_foreach(conv->r_keys, rb_conversion_free_atom, (VALUE)conv->ctx);
+  for (size_t i = 0; i < conv->held_len; i++)
+    JS_FreeValue(conv->ctx, conv->held[i]);
+  free(conv->held);
+  xfree(conv->visited.slots);
+  return Qnil;
+}
+
+static VALUE to_rb_value_with(JSContext *ctx, JSValue j_val, const ResultOpts *opts)
+{
+  RbConversion conv = {ctx, {NULL, 0, 0}, Qnil, NULL, 0, 0, opts != NULL && opts->symbolize_names,
+                       opts != NULL ? opts->r_lazy_vm : Qnil};
+  // Primitives never reach the visited set or key cache; skip the rb_ensure.
+  if (JS_VALUE_GET_NORM_TAG(j_val) != JS_TAG_OBJECT)
+    return to_rb_value_inner(ctx, j_val, &conv);
+
+  struct rb_conversion_run run = {&conv, j_val};
+  VALUE r_result = rb_ensure(rb_conversion_run, (VALUE)&run, rb_conversion_cleanup, (VALUE)&run);
+  RB_GC_GUARD(conv.r_keys);
+  return r_result;
+}
+
 VALUE to_rb_value(JSContext *ctx, JSValue j_val)
 {
-  return to_rb_value_inner(ctx, j_val, Qnil);
+  return to_rb_value_with(ctx, j_val, NULL);
+}
+
+VALUE quickjsrb_to_rb_value_lazy(JSContext *ctx, JSValue j_val, VALUE r_vm)
+{
+  ResultOpts opts = {false, r_vm};
+  return to_rb_value_with(ctx, j_val, &opts);
 }
 
-static VALUE to_rb_value_inner(JSContext *ctx, JSValue j_val, VALUE r_visited)
+static VALUE to_rb_value_inner(JSContext *ctx, JSValue j_val, RbConversion *conv)
 {
   switch (JS_VALUE_GET_NORM_TAG(j_val))
   {
@@ -363,6 +867,22 @@ static VALUE to_rb_value_inner(JSContext *ctx, JSValue j_val, VALUE r_visited)
       // will support other errors like just returning an instance of Error
     }
 
+    {
+      // A Quickjs::Ref handed back: the Ruby object itself, not a copy.
+      VALUE r_host = quickjsrb_ref_from_js(j_val);
+      if (r_host != Qundef)
+        return r_host;
+    }
+
+    // Classified once here; the buffer and plain-object paths below both
+    // dispatch on it.
+    QuickjsrbObjectKind kind = js_object_kind(ctx, j_val);
+    {
+      VALUE r_bytes = js_buffer_to_rb_str(ctx, j_val, kind);
+      if (!NIL_P(r_bytes))
+        return quickjsrb_typed_array_from_js(r_bytes, kind);
+    }
+
     // Check for Ruby object proxy (e.g., File proxy with rb_object_id on target)
     {
       JSValue j_rb_id = JS_GetPropertyStr(ctx, j_val, "rb_object_id");
@@ -392,23 +912,34 @@ static VALUE to_rb_value_inner(JSContext *ctx, JSValue j_val, VALUE r_visited)
         return r_maybe_file;
     }
 
+    if (!NIL_P(conv->r_lazy_vm))
+      return quickjsrb_object_ref_new(conv->r_lazy_vm, JS_GetContextOpaque(ctx), JS_DupValue(ctx, j_val));
+
     // Below this point, conversion recurses into own properties / elements
     // via to_rb_value_inner. Track JS object pointers to break cycles —
     // re-entering the same object returns nil instead of blowing the stack.
-    if (NIL_P(r_visited))
-      r_visited = rb_hash_new();
-    VALUE r_visit_key = ULL2NUM((uintptr_t)JS_VALUE_GET_PTR(j_val));
-    if (RTEST(rb_hash_lookup(r_visited, r_visit_key)))
+    if (!visited_add(&conv->visited, j_val))
       return Qnil;
-    rb_hash_aset(r_visited, r_visit_key, Qtrue);
 
     if (JS_IsArray(ctx, j_val))
-      return js_array_to_rb(ctx, j_val, r_visited);
+      return js_array_to_rb(ctx, j_val, conv);
+
+    if (kind == QUICKJSRB_OBJECT_PLAIN)
+      return js_plain_object_to_rb(ctx, j_val, conv);
 
-    if (js_is_plain_object(ctx, j_val))
-      return js_plain_object_to_rb(ctx, j_val, r_visited);
+    {
+      VALUE r_native = Qundef;
+      if (kind == QUICKJSRB_OBJECT_DATE)
+        r_native = js_date_to_rb(ctx, j_val);
+      else if (kind == QUICKJSRB_OBJECT_MAP)
+        r_native = js_collection_to_rb(ctx, j_val, true, conv);
+      else if (kind == QUICKJSRB_OBJECT_SET)
+        r_native = js_collection_to_rb(ctx, j_val, false, conv);
+      if (r_native != Qundef)
+        return r_native;
+    }
 
-    // Non-plain objects (Date, RegExp, Map, class instances, etc.).
+    // Other non-plain objects (RegExp, class instances, etc.).
     // If the object opts in to a JSON representation via toJSON (e.g. Date),
     // honour it — recurse on the returned value. Otherwise dump own enumerable
     // string-keyed properties; this is faster than the JSON round-trip and
@@ -418,12 +949,12 @@ static VALUE to_rb_value_inner(JSContext *ctx, JSValue j_val, VALUE r_visited)
     {
       JSValue j_jsonValue = JS_Call(ctx, j_toJSON, j_val, 0, NULL);
       JS_FreeValue(ctx, j_toJSON);
-      VALUE r_result = to_rb_value_inner(ctx, j_jsonValue, r_visited);
+      VALUE r_result = to_rb_value_inner(ctx, j_jsonValue, conv);
       JS_FreeValue(ctx, j_jsonValue);
       return r_result;
     }
     JS_FreeValue(ctx, j_toJSON);
-    return js_plain_object_to_rb(ctx, j_val, r_visited);
+    return js_plain_object_to_rb(ctx, j_val, conv);
   }
   case JS_TAG_NULL:
     return Qnil;
@@ -476,6 +1007,18 @@ static VALUE to_rb_value_inner(JSContext *ctx, JSValue j_val, VALUE r_visited)
       {
         r_error_class = QUICKJSRB_ERROR_FOR(QUICKJSRB_INTERRUPTED_ERROR);
       }
+      else if (strcmp(errorClassName, "InternalError") == 0 && strstr(errorClassMessage, "out of memory") != NULL &&
+               vm_heap(data)->global_refused)
+      {
+        // The process-wide budget refused, not this runtime's own limit.
+        // It's still a failed QuickJS allocation, which can leave the same
+        // half-built state as any other, so the VM is poisoned all the same
+        // (`recycle: { on_poison: :rebuild }` recovers it); only the error
+        // class says the cause was other VMs' usage.
+        vm_heap(data)->global_refused = false;
+        data->oom_poisoned = true;
+        r_error_class = QUICKJSRB_ERROR_FOR(QUICKJSRB_GLOBAL_MEMORY_LIMIT_ERROR);
+      }
       else if (strcmp(errorClassName, "InternalError") == 0 && strstr(errorClassMessage, "out of memory") != NULL)
       {
         // Once OOM has fired, the QuickJS heap is in a state where another
@@ -572,9 +1115,62 @@ static VALUE r_module_loader_call(VALUE r_args_val)
 // Source is stashed in `module_source_cache` keyed by canonical so the
 // load hook can pick it up. The resolution cache memoizes the call so
 // the Proc fires at most once per `(specifier, importer)` pair.
+// QuickJS's own normalize (js_default_module_normalize_name) isn't
+// exported, and on a shared runtime the hooks are runtime-wide while
+// module_loader is per context, so contexts without a loader need the
+// default behavior from here: bare specifiers pass through, and leading
+// "./" / "../" segments resolve against the importer's directory.
+static char *quickjsrb_default_module_normalize(JSContext *ctx, const char *base_name, const char *name)
+{
+  if (name[0] != '.')
+    return js_strdup(ctx, name);
+
+  const char *slash = strrchr(base_name, '/');
+  size_t len = slash ? (size_t)(slash - base_name) : 0;
+  size_t cap = len + strlen(name) + 2;
+  char *filename = js_malloc(ctx, cap);
+  if (filename == NULL)
+    return NULL;
+  memcpy(filename, base_name, len);
+  filename[len] = '\0';
+
+  const char *r = name;
+  for (;;)
+  {
+    if (r[0] == '.' && r[1] == '/')
+    {
+      r += 2;
+    }
+    else if (r[0] == '.' && r[1] == '.' && r[2] == '/')
+    {
+      if (filename[0] == '\0')
+        break;
+      char *p = strrchr(filename, '/');
+      p = p ? p + 1 : filename;
+      if (strcmp(p, ".") == 0 || strcmp(p, "..") == 0)
+        break;
+      if (p > filename)
+        p--;
+      *p = '\0';
+      r += 3;
+    }
+    else
+    {
+      break;
+    }
+  }
+  size_t used = strlen(filename);
+  if (used > 0)
+    filename[used++] = '/';
+  memcpy(filename + used, r, strlen(r) + 1);
+  return filename;
+}
+
 static char *quickjsrb_module_normalize(JSContext *ctx, const char *base_name, const char *name, void *opaque)
 {
   VMData *data = JS_GetContextOpaque(ctx);
+  if (NIL_P(data->module_loader))
+    return quickjsrb_default_module_normalize(ctx, base_name, name);
 
   VALUE r_specifier = rb_str_new_cstr(name);
   VALUE r_importer = rb_str_new_cstr(base_name);
@@ -639,6 +1235,8 @@ static char *quickjsrb_module_normalize(JSContext *ctx, const char *base_name, c
 static JSModuleDef *quickjsrb_module_loader(JSContext *ctx, const char *module_name, void *opaque, JSValueConst attributes)
 {
   VMData *data = JS_GetContextOpaque(ctx);
+  if (NIL_P(data->module_loader))
+    return js_module_loader(ctx, module_name, opaque, attributes);
 
   VALUE r_canonical = rb_str_new_cstr(module_name);
   VALUE r_source = rb_hash_aref(data->module_source_cache, r_canonical);
@@ -666,8 +1264,13 @@ static JSModuleDef *quickjsrb_module_loader(JSContext *ctx, const char *module_n
 // When no Ruby loader is set we hand resolution back to QuickJS's defaults
 // (URL-style normalize + filesystem load). When a loader is set we own both
 // phases so we can thread (specifier, importer) through and honor `as:`.
+// A shared runtime keeps our hooks installed for good (see
+// quickjsrb_install_runtime_hooks); they fall back per context.
 static void register_module_loader_funcs(VMData *data)
 {
+  if (data->context == NULL || data->disposed || data->shared_runtime != NULL)
+    return;
+
   JSRuntime *runtime = JS_GetRuntime(data->context);
   if (NIL_P(data->module_loader))
     JS_SetModuleLoaderFunc2(runtime, NULL, js_module_loader, js_module_check_attributes, NULL);
@@ -1194,58 +1797,262 @@ static void finish_polyfill_load(VMData *data, JSValue j_result)
   JS_FreeValue(data->context, j_result);
 }
 
-static VALUE vm_m_initialize(int argc, VALUE *argv, VALUE r_self)
+void quickjsrb_install_runtime_hooks(JSRuntime *runtime)
 {
-  VALUE r_opts;
-  rb_scan_args(argc, argv, ":", &r_opts);
-  if (NIL_P(r_opts))
-    r_opts = rb_hash_new();
-
-  VALUE r_memory_limit = rb_hash_aref(r_opts, ID2SYM(rb_intern("memory_limit")));
-  if (NIL_P(r_memory_limit))
-    r_memory_limit = UINT2NUM(1024 * 1024 * 128);
-  VALUE r_max_stack_size = rb_hash_aref(r_opts, ID2SYM(rb_intern("max_stack_size")));
-  if (NIL_P(r_max_stack_size))
-    r_max_stack_size = UINT2NUM(1024 * 1024 * 4);
-  VALUE r_features = rb_hash_aref(r_opts, ID2SYM(rb_intern("features")));
-  if (NIL_P(r_features))
-    r_features = rb_ary_new();
-  VALUE r_timeout_msec = rb_hash_aref(r_opts, ID2SYM(rb_intern("timeout_msec")));
-  if (NIL_P(r_timeout_msec))
-    r_timeout_msec = UINT2NUM(100);
-
-  VMData *data;
-  TypedData_Get_Struct(r_self, VMData, &vm_type, data);
-
-  data->eval_time->limit_ms = (int64_t)NUM2UINT(r_timeout_msec);
-  JS_SetContextOpaque(data->context, data);
-  JSRuntime *runtime = JS_GetRuntime(data->context);
-
-  JS_SetMemoryLimit(runtime, NUM2UINT(r_memory_limit));
-  JS_SetMaxStackSize(runtime, NUM2UINT(r_max_stack_size));
-
-  register_module_loader_funcs(data);
+  JS_SetModuleLoaderFunc2(runtime, quickjsrb_module_normalize, quickjsrb_module_loader, js_module_check_attributes, NULL);
   JS_SetHostPromiseRejectionTracker(runtime, quickjsrb_promise_rejection_tracker, NULL);
   js_std_init_handlers(runtime);
+}
 
-  JSValue j_global = JS_GetGlobalObject(data->context);
+// lazy_polyfills: true turns each bytecode polyfill into configurable
+// accessor stubs on globalThis, one per global the polyfill defines. The
+// first get or set of any of them deletes the whole group's stubs, runs
+// the bytecode, and forwards the access to the property the polyfill
+// left behind. Stub func_data:
+//   [0] the bytecode, as an ArrayBuffer
+//   [1] the group's names — emptied before the load runs, so a stub
+//       captured earlier (Object.getOwnPropertyDescriptor) can't reload
+//   [2] this stub's own name
+// The load runs inside whatever eval touched the global, so unlike an
+// eager load it counts against that eval's timeout_msec, and failures
+// surface as that eval's JS exception. Nothing here touches Ruby: a
+// GVL-released eval can trigger a load.
+static int lazy_polyfill_load(JSContext *ctx, JSValueConst j_global, JSValue *func_data)
+{
+  uint32_t names_len = 0;
+  JSValue j_len = JS_GetPropertyStr(ctx, func_data[1], "length");
+  JS_ToUint32(ctx, &names_len, j_len);
+  JS_FreeValue(ctx, j_len);
+  if (names_len == 0)
+    return 0;
 
-  if (RTEST(rb_funcall(r_features, rb_intern("include?"), 1, QUICKJSRB_SYM(featureStdId))))
+  for (uint32_t i = 0; i < names_len; i++)
   {
-    js_init_module_std(data->context, "std");
-    const char *enableStd = "import * as std from 'std';\n"
-                            "globalThis.std = std;\n";
-    JSValue j_stdEval = JS_Eval(data->context, enableStd, strlen(enableStd), vmInternalFilename, JS_EVAL_TYPE_MODULE);
-    JS_FreeValue(data->context, j_stdEval);
+    JSValue j_name = JS_GetPropertyUint32(ctx, func_data[1], i);
+    JSAtom atom = JS_ValueToAtom(ctx, j_name);
+    JS_FreeValue(ctx, j_name);
+    if (atom == JS_ATOM_NULL)
+      return -1;
+    JS_DeleteProperty(ctx, j_global, atom, 0);
+    JS_FreeAtom(ctx, atom);
   }
+  JS_SetPropertyStr(ctx, func_data[1], "length", JS_NewUint32(ctx, 0));
+  // Whichever group this is, File and Blob may be about to appear (or
+  // have lost their stubs); have quickjsrb_file_ctors look again.
+  ((VMData *)JS_GetContextOpaque(ctx))->file_ctors_cached = false;
 
-  if (RTEST(rb_funcall(r_features, rb_intern("include?"), 1, QUICKJSRB_SYM(featureOsId))))
-  {
-    js_init_module_os(data->context, "os");
-    const char *enableOs = "import * as os from 'os';\n"
+  size_t buf_len;
+  uint8_t *buf = JS_GetArrayBuffer(ctx, &buf_len, func_data[0]);
+  if (buf == NULL)
+    return -1;
+  JSValue j_obj = JS_ReadObject(ctx, buf, buf_len, JS_READ_OBJ_BYTECODE);
+  if (JS_IsException(j_obj))
+    return -1;
+  JSValue j_result = JS_EvalFunction(ctx, j_obj); // frees j_obj
+  if (JS_IsException(j_result))
+    return -1;
+
+  // Same settle rules as finish_polyfill_load, reported as JS exceptions.
+  JSPromiseStateEnum state = JS_PromiseState(ctx, j_result);
+  if (state == JS_PROMISE_REJECTED)
+  {
+    JSValue j_reason = JS_PromiseResult(ctx, j_result);
+    JS_FreeValue(ctx, j_result);
+    JS_Throw(ctx, j_reason);
+    return -1;
+  }
+  JS_FreeValue(ctx, j_result);
+  if (state == JS_PROMISE_PENDING)
+  {
+    JS_ThrowTypeError(ctx, "polyfill top level must settle synchronously");
+    return -1;
+  }
+  return 0;
+}
+
+// magic 0: getter, 1: setter.
+static JSValue js_lazy_polyfill_stub(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv, int magic, JSValue *func_data)
+{
+  JSValue j_global = JS_GetGlobalObject(ctx);
+  if (lazy_polyfill_load(ctx, j_global, func_data) < 0)
+  {
+    JS_FreeValue(ctx, j_global);
+    return JS_EXCEPTION;
+  }
+
+  JSAtom atom = JS_ValueToAtom(ctx, func_data[2]);
+  JSValue j_ret;
+  if (magic == 0)
+  {
+    j_ret = JS_GetProperty(ctx, j_global, atom);
+  }
+  else
+  {
+    JSValue j_value = argc > 0 ? JS_DupValue(ctx, argv[0]) : JS_UNDEFINED;
+    j_ret = JS_SetProperty(ctx, j_global, atom, j_value) < 0 ? JS_EXCEPTION : JS_UNDEFINED;
+  }
+  JS_FreeAtom(ctx, atom);
+  JS_FreeValue(ctx, j_global);
+  return j_ret;
+}
+
+// Consumes j_bytecode. names must be non-empty.
+static void install_lazy_polyfill(JSContext *ctx, JSValue j_bytecode, const char *const *names, long names_len)
+{
+  JSValue j_global = JS_GetGlobalObject(ctx);
+  JSValue j_names = JS_NewArray(ctx);
+  for (long i = 0; i < names_len; i++)
+    JS_SetPropertyUint32(ctx, j_names, (uint32_t)i, JS_NewString(ctx, names[i]));
+
+  for (long i = 0; i < names_len; i++)
+  {
+    JSValueConst func_data[3] = {j_bytecode, j_names, JS_UNDEFINED};
+    JSValue j_name = JS_NewString(ctx, names[i]);
+    func_data[2] = j_name;
+    JSAtom atom = JS_NewAtom(ctx, names[i]);
+    JS_DefinePropertyGetSet(
+        ctx, j_global, atom,
+        JS_NewCFunctionData(ctx, js_lazy_polyfill_stub, 0, 0, 3, func_data),
+        JS_NewCFunctionData(ctx, js_lazy_polyfill_stub, 1, 1, 3, func_data),
+        JS_PROP_CONFIGURABLE);
+    JS_FreeAtom(ctx, atom);
+    JS_FreeValue(ctx, j_name);
+  }
+
+  JS_FreeValue(ctx, j_names);
+  JS_FreeValue(ctx, j_bytecode);
+  JS_FreeValue(ctx, j_global);
+}
+
+// Bundled polyfills: the ArrayBuffer points straight at the static
+// bytecode, so a stub that never fires costs no copy.
+static void install_lazy_bundled_polyfill(VMData *data, const uint8_t *buf, size_t buf_len, const char *const *names, long names_len)
+{
+  JSValue j_bytecode = JS_NewArrayBuffer(data->context, (uint8_t *)buf, buf_len, NULL, NULL, false);
+  install_lazy_polyfill(data->context, j_bytecode, names, names_len);
+}
+
+static const char *const polyfill_file_globals[] = {"Blob", "File"};
+static const char *const polyfill_encoding_globals[] = {"TextEncoder", "TextDecoder"};
+static const char *const polyfill_url_globals[] = {"URL", "URLSearchParams"};
+
+// VM.new(profile_init: true). Both ends are no-ops unless data is still
+// recording; the heap is passed in because VM#initialize starts timing
+// before data->shared_runtime points at the one being joined.
+typedef struct InitPhase
+{
+  QuickjsrbHeap *heap;
+  struct timespec started_at;
+  size_t allocations;
+  size_t bytes;
+} InitPhase;
+
+static inline bool init_profile_recording(VMData *data)
+{
+  return !NIL_P(data->init_profile) && !OBJ_FROZEN(data->init_profile);
+}
+
+static void init_phase_begin(VMData *data, QuickjsrbHeap *heap, InitPhase *phase)
+{
+  if (!init_profile_recording(data))
+    return;
+  phase->heap = heap;
+  phase->allocations = heap->allocations;
+  phase->bytes = heap->bytes;
+  clock_gettime(CLOCK_MONOTONIC, &phase->started_at);
+}
+
+// `bytes` is the net heap growth over the phase, so it can be negative
+// when a phase frees more than it keeps (e.g. a polyfill's bytecode).
+static void init_phase_end(VMData *data, InitPhase *phase, VALUE r_phase)
+{
+  if (!init_profile_recording(data))
+    return;
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  double msec = (double)(now.tv_sec - phase->started_at.tv_sec) * 1000.0 + (double)(now.tv_nsec - phase->started_at.tv_nsec) / 1e6;
+
+  VALUE r_row = rb_hash_new();
+  rb_hash_aset(r_row, ID2SYM(rb_intern("phase")), r_phase);
+  rb_hash_aset(r_row, ID2SYM(rb_intern("msec")), DBL2NUM(msec));
+  rb_hash_aset(r_row, ID2SYM(rb_intern("allocations")), SIZET2NUM(phase->heap->allocations - phase->allocations));
+  rb_hash_aset(r_row, ID2SYM(rb_intern("bytes")), LL2NUM((long long)phase->heap->bytes - (long long)phase->bytes));
+  rb_ary_push(data->init_profile, r_row);
+}
+
+// Installs the per-context half of VM#initialize — features, built-in
+// polyfills, console — on data->context. VM#reset! re-runs it on the fresh
+// context it swaps in.
+static void vm_setup_context(VMData *data, VALUE r_features, bool lazy_polyfills)
+{
+  JSValue j_global = JS_GetGlobalObject(data->context);
+  InitPhase phase;
+
+  // Captured before any polyfill or user code can shadow the globals.
+  JSValue j_object_ctor = JS_GetPropertyStr(data->context, j_global, "Object");
+  data->j_object_prototype = JS_GetPropertyStr(data->context, j_object_ctor, "prototype");
+  JS_FreeValue(data->context, j_object_ctor);
+  data->j_number_ctor = JS_GetPropertyStr(data->context, j_global, "Number");
+  data->j_uint8array_ctor = JS_GetPropertyStr(data->context, j_global, "Uint8Array");
+  {
+    JSValue j_arraybuffer_ctor = JS_GetPropertyStr(data->context, j_global, "ArrayBuffer");
+    if (JS_IsObject(j_arraybuffer_ctor))
+      data->j_arraybuffer_prototype = JS_GetPropertyStr(data->context, j_arraybuffer_ctor, "prototype");
+    JS_FreeValue(data->context, j_arraybuffer_ctor);
+  }
+  if (JS_IsObject(data->j_uint8array_ctor))
+  {
+    JSValue j_uint8array_prototype = JS_GetPropertyStr(data->context, data->j_uint8array_ctor, "prototype");
+    data->j_typedarray_prototype = JS_GetPrototype(data->context, j_uint8array_prototype);
+    JS_FreeValue(data->context, j_uint8array_prototype);
+  }
+  {
+    const char *names[] = {"Date", "Map", "Set"};
+    JSValue *prototypes[] = {&data->j_date_prototype, &data->j_map_prototype, &data->j_set_prototype};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+    {
+      JSValue j_ctor = JS_GetPropertyStr(data->context, j_global, names[i]);
+      if (JS_IsObject(j_ctor))
+        *prototypes[i] = JS_GetPropertyStr(data->context, j_ctor, "prototype");
+      JS_FreeValue(data->context, j_ctor);
+    }
+  }
+  if (JS_IsObject(data->j_date_prototype))
+    data->j_date_get_time = JS_GetPropertyStr(data->context, data->j_date_prototype, "getTime");
+  {
+    JSValue j_array_ctor = JS_GetPropertyStr(data->context, j_global, "Array");
+    data->j_array_from = JS_GetPropertyStr(data->context, j_array_ctor, "from");
+    data->j_array_prototype = JS_GetPropertyStr(data->context, j_array_ctor, "prototype");
+    JS_FreeValue(data->context, j_array_ctor);
+  }
+  data->j_float64array_ctor = JS_GetPropertyStr(data->context, j_global, "Float64Array");
+  if (JS_IsObject(data->j_float64array_ctor))
+    data->j_float64array_prototype = JS_GetPropertyStr(data->context, data->j_float64array_ctor, "prototype");
+  data->j_int32array_ctor = JS_GetPropertyStr(data->context, j_global, "Int32Array");
+  if (JS_IsObject(data->j_int32array_ctor))
+    data->j_int32array_prototype = JS_GetPropertyStr(data->context, data->j_int32array_ctor, "prototype");
+  data->file_ctors_cached = !RTEST(rb_funcall(r_features, rb_intern("include?"), 1, QUICKJSRB_SYM(featurePolyfillFileId)));
+
+  if (RTEST(rb_funcall(r_features, rb_intern("include?"), 1, QUICKJSRB_SYM(featureStdId))))
+  {
+    init_phase_begin(data, vm_heap(data), &phase);
+    js_init_module_std(data->context, "std");
+    const char *enableStd = "import * as std from 'std';\n"
+                            "globalThis.std = std;\n";
+    JSValue j_stdEval = JS_Eval(data->context, enableStd, strlen(enableStd), vmInternalFilename, JS_EVAL_TYPE_MODULE);
+    JS_FreeValue(data->context, j_stdEval);
+    init_phase_end(data, &phase, QUICKJSRB_SYM(featureStdId));
+  }
+
+  if (RTEST(rb_funcall(r_features, rb_intern("include?"), 1, QUICKJSRB_SYM(featureOsId))))
+  {
+    init_phase_begin(data, vm_heap(data), &phase);
+    js_init_module_os(data->context, "os");
+    const char *enableOs = "import * as os from 'os';\n"
                            "globalThis.os = os;\n";
     JSValue j_osEval = JS_Eval(data->context, enableOs, strlen(enableOs), vmInternalFilename, JS_EVAL_TYPE_MODULE);
     JS_FreeValue(data->context, j_osEval);
+    init_phase_end(data, &phase, QUICKJSRB_SYM(featureOsId));
   }
   else if (RTEST(rb_funcall(r_features, rb_intern("include?"), 1, QUICKJSRB_SYM(featureTimeoutId))))
   {
@@ -1269,26 +2076,47 @@ static VALUE vm_m_initialize(int argc, VALUE *argv, VALUE r_self)
 
   if (RTEST(rb_funcall(r_features, rb_intern("include?"), 1, QUICKJSRB_SYM(featurePolyfillFileId))))
   {
-    finish_polyfill_load(data, load_polyfill_bytecode(data, &qjsc_polyfill_file_min, qjsc_polyfill_file_min_size, false));
+    init_phase_begin(data, vm_heap(data), &phase);
+    if (lazy_polyfills)
+      install_lazy_bundled_polyfill(data, &qjsc_polyfill_file_min, qjsc_polyfill_file_min_size, polyfill_file_globals, 2);
+    else
+      finish_polyfill_load(data, load_polyfill_bytecode(data, &qjsc_polyfill_file_min, qjsc_polyfill_file_min_size, false));
+    init_phase_end(data, &phase, QUICKJSRB_SYM(featurePolyfillFileId));
 
+    // The proxy factory only reads File.prototype when a Ruby File is
+    // converted, which is what triggers a lazy File load.
+    init_phase_begin(data, vm_heap(data), &phase);
     quickjsrb_init_file_proxy(data);
+    init_phase_end(data, &phase, ID2SYM(rb_intern("file_proxy")));
   }
 
   if (RTEST(rb_funcall(r_features, rb_intern("include?"), 1, QUICKJSRB_SYM(featurePolyfillEncodingId))))
   {
-    finish_polyfill_load(data, load_polyfill_bytecode(data, &qjsc_polyfill_encoding_min, qjsc_polyfill_encoding_min_size, false));
+    init_phase_begin(data, vm_heap(data), &phase);
+    if (lazy_polyfills)
+      install_lazy_bundled_polyfill(data, &qjsc_polyfill_encoding_min, qjsc_polyfill_encoding_min_size, polyfill_encoding_globals, 2);
+    else
+      finish_polyfill_load(data, load_polyfill_bytecode(data, &qjsc_polyfill_encoding_min, qjsc_polyfill_encoding_min_size, false));
+    init_phase_end(data, &phase, QUICKJSRB_SYM(featurePolyfillEncodingId));
   }
 
   if (RTEST(rb_funcall(r_features, rb_intern("include?"), 1, QUICKJSRB_SYM(featurePolyfillUrlId))))
   {
-    finish_polyfill_load(data, load_polyfill_bytecode(data, &qjsc_polyfill_url_min, qjsc_polyfill_url_min_size, false));
+    init_phase_begin(data, vm_heap(data), &phase);
+    if (lazy_polyfills)
+      install_lazy_bundled_polyfill(data, &qjsc_polyfill_url_min, qjsc_polyfill_url_min_size, polyfill_url_globals, 2);
+    else
+      finish_polyfill_load(data, load_polyfill_bytecode(data, &qjsc_polyfill_url_min, qjsc_polyfill_url_min_size, false));
+    init_phase_end(data, &phase, QUICKJSRB_SYM(featurePolyfillUrlId));
   }
 
   j_global = JS_GetGlobalObject(data->context);
 
   if (RTEST(rb_funcall(r_features, rb_intern("include?"), 1, QUICKJSRB_SYM(featurePolyfillCryptoId))))
   {
+    init_phase_begin(data, vm_heap(data), &phase);
     quickjsrb_init_crypto(data->context, j_global);
+    init_phase_end(data, &phase, QUICKJSRB_SYM(featurePolyfillCryptoId));
   }
 
   // console and the remaining host callbacks are registered below this
@@ -1296,6 +2124,7 @@ static VALUE vm_m_initialize(int argc, VALUE *argv, VALUE r_self)
   // polyfill loads only under the audit described at
   // run_bytecode_release_gvl — re-read it before reordering this function
   // or registering anything else above the loads.
+  init_phase_begin(data, vm_heap(data), &phase);
   JSValue j_console = JS_NewObject(data->context);
   JS_SetPropertyStr(
       data->context, j_console, "log",
@@ -1315,6 +2144,214 @@ static VALUE vm_m_initialize(int argc, VALUE *argv, VALUE r_self)
 
   JS_SetPropertyStr(data->context, j_global, "console", j_console);
   JS_FreeValue(data->context, j_global);
+  init_phase_end(data, &phase, ID2SYM(rb_intern("console")));
+}
+
+static const struct
+{
+  const char *name;
+  unsigned int bit;
+} intrinsic_names[] = {
+    // Always installed; accepted so a list can spell them out.
+    {"base", 0},
+    {"eval", 0},
+    {"promise", 0},
+    {"date", QUICKJSRB_INTRINSIC_DATE},
+    {"string_normalize", QUICKJSRB_INTRINSIC_STRING_NORMALIZE},
+    {"regexp", QUICKJSRB_INTRINSIC_REGEXP},
+    {"json", QUICKJSRB_INTRINSIC_JSON},
+    {"proxy", QUICKJSRB_INTRINSIC_PROXY},
+    {"map_set", QUICKJSRB_INTRINSIC_MAP_SET},
+    {"typed_arrays", QUICKJSRB_INTRINSIC_TYPED_ARRAYS},
+    {"weak_ref", QUICKJSRB_INTRINSIC_WEAK_REF},
+};
+
+static unsigned int intrinsics_from_option(VALUE r_intrinsics)
+{
+  if (!RB_TYPE_P(r_intrinsics, T_ARRAY))
+    rb_raise(rb_eTypeError, "intrinsics: must be an Array of Symbols, got %s", rb_obj_classname(r_intrinsics));
+
+  unsigned int intrinsics = 0;
+  for (long i = 0; i < RARRAY_LEN(r_intrinsics); i++)
+  {
+    VALUE r_name = RARRAY_AREF(r_intrinsics, i);
+    size_t j = 0;
+    if (SYMBOL_P(r_name))
+    {
+      const char *name = rb_id2name(SYM2ID(r_name));
+      for (; j < sizeof(intrinsic_names) / sizeof(intrinsic_names[0]); j++)
+        if (strcmp(name, intrinsic_names[j].name) == 0)
+          break;
+    }
+    if (!SYMBOL_P(r_name) || j == sizeof(intrinsic_names) / sizeof(intrinsic_names[0]))
+      rb_raise(rb_eArgError, "unknown intrinsic %" PRIsVALUE, rb_inspect(r_name));
+    intrinsics |= intrinsic_names[j].bit;
+  }
+  return intrinsics;
+}
+
+// What the bundled features use, added to an explicit intrinsics: list so
+// e.g. POLYFILL_URL keeps working without the caller spelling out :regexp.
+// Registered polyfills are on the caller.
+static unsigned int intrinsics_for_features(VALUE r_features)
+{
+  static const struct
+  {
+    const char **feature;
+    unsigned int needs;
+  } deps[] = {
+      {&featureStdId, QUICKJSRB_INTRINSIC_TYPED_ARRAYS},
+      {&featureOsId, QUICKJSRB_INTRINSIC_TYPED_ARRAYS},
+      {&featurePolyfillFileId, QUICKJSRB_INTRINSIC_TYPED_ARRAYS | QUICKJSRB_INTRINSIC_DATE},
+      {&featurePolyfillEncodingId, QUICKJSRB_INTRINSIC_TYPED_ARRAYS},
+      {&featurePolyfillUrlId, QUICKJSRB_INTRINSIC_REGEXP | QUICKJSRB_INTRINSIC_JSON},
+      {&featurePolyfillCryptoId, QUICKJSRB_INTRINSIC_TYPED_ARRAYS},
+  };
+
+  unsigned int intrinsics = 0;
+  for (size_t i = 0; i < sizeof(deps) / sizeof(deps[0]); i++)
+    if (RTEST(rb_funcall(r_features, rb_intern("include?"), 1, QUICKJSRB_SYM(*deps[i].feature))))
+      intrinsics |= deps[i].needs;
+  return intrinsics;
+}
+
+// Runtime-wide setup for a VM's private runtime: limits, module hooks,
+// the rejection tracker, quickjs-libc's handlers. Shared runtimes get
+// theirs from Quickjs::Runtime.new.
+static void vm_setup_private_runtime(VMData *data)
+{
+  JSRuntime *runtime = JS_GetRuntime(data->context);
+  JS_SetMemoryLimit(runtime, data->memory_limit);
+  JS_SetMaxStackSize(runtime, data->max_stack_size);
+
+  register_module_loader_funcs(data);
+  JS_SetHostPromiseRejectionTracker(runtime, quickjsrb_promise_rejection_tracker, NULL);
+  js_std_init_handlers(runtime);
+  if (data->arena_fast_teardown)
+  {
+    // quickjs-libc allocates SharedArrayBuffer storage with plain malloc
+    // so workers can share it; without os there are no workers, and
+    // clearing the hooks puts that storage in the arena too.
+    JSSharedArrayBufferFunctions sab_funcs;
+    memset(&sab_funcs, 0, sizeof(sab_funcs));
+    JS_SetSharedArrayBufferFunctions(runtime, &sab_funcs);
+  }
+}
+
+static VALUE vm_m_initialize(int argc, VALUE *argv, VALUE r_self)
+{
+  VALUE r_opts;
+  rb_scan_args(argc, argv, ":", &r_opts);
+  if (NIL_P(r_opts))
+    r_opts = rb_hash_new();
+
+  VALUE r_memory_limit = rb_hash_aref(r_opts, ID2SYM(rb_intern("memory_limit")));
+  VALUE r_max_stack_size = rb_hash_aref(r_opts, ID2SYM(rb_intern("max_stack_size")));
+  VALUE r_runtime = rb_hash_aref(r_opts, ID2SYM(rb_intern("runtime")));
+  VALUE r_features = rb_hash_aref(r_opts, ID2SYM(rb_intern("features")));
+  if (NIL_P(r_features))
+    r_features = rb_ary_new();
+  VALUE r_timeout_msec = rb_hash_aref(r_opts, ID2SYM(rb_intern("timeout_msec")));
+  if (NIL_P(r_timeout_msec))
+    r_timeout_msec = UINT2NUM(100);
+
+  VMData *data;
+  TypedData_Get_Struct(r_self, VMData, &vm_type, data);
+
+  if (data->context != NULL)
+    rb_raise(rb_eArgError, "Quickjs::VM is already initialized");
+
+  VALUE r_allocator = rb_hash_aref(r_opts, ID2SYM(rb_intern("allocator")));
+  bool use_arena = r_allocator == ID2SYM(rb_intern("arena"));
+  if (!use_arena && !NIL_P(r_allocator) && r_allocator != ID2SYM(rb_intern("default")))
+    rb_raise(rb_eArgError, "allocator: must be :default or :arena, got %" PRIsVALUE, rb_inspect(r_allocator));
+
+  data->eval_time->limit_ms = (int64_t)NUM2UINT(r_timeout_msec);
+  data->lazy_polyfills = RTEST(rb_hash_aref(r_opts, ID2SYM(rb_intern("lazy_polyfills"))));
+  if (RTEST(rb_hash_aref(r_opts, ID2SYM(rb_intern("profile_init")))))
+    data->init_profile = rb_ary_new();
+  VALUE r_intrinsics = rb_hash_aref(r_opts, ID2SYM(rb_intern("intrinsics")));
+  if (!NIL_P(r_intrinsics))
+    data->intrinsics = intrinsics_from_option(r_intrinsics) | intrinsics_for_features(r_features);
+  InitPhase phase;
+  quickjsrb_global_await_headroom();
+
+  if (NIL_P(r_runtime))
+  {
+    if (NIL_P(r_memory_limit))
+      r_memory_limit = UINT2NUM(1024 * 1024 * 128);
+    if (NIL_P(r_max_stack_size))
+      r_max_stack_size = UINT2NUM(1024 * 1024 * 4);
+    size_t memory_limit = NUM2UINT(r_memory_limit);
+    size_t max_stack_size = NUM2UINT(r_max_stack_size);
+
+    // JSRuntime / JSContext creation is pure QuickJS C work — no Ruby state
+    // touched. Release the GVL so a background warmer thread can run this in
+    // parallel with the main thread on multi-core hosts.
+    struct vm_create_args args = {NULL, data->heap, data->intrinsics, NULL};
+    init_phase_begin(data, data->heap, &phase);
+    if (use_arena && (args.arena = quickjsrb_arena_new(data->heap)) == NULL)
+      rb_raise(rb_eNoMemError, "failed to allocate a QuickJS context");
+    rb_thread_call_without_gvl(vm_create_no_gvl, &args, NULL, NULL);
+    if (args.context == NULL)
+    {
+      quickjsrb_arena_destroy(args.arena);
+      rb_raise(rb_eNoMemError, "failed to allocate a QuickJS context");
+    }
+    init_phase_end(data, &phase, ID2SYM(rb_intern("runtime")));
+    data->context = args.context;
+    data->arena = args.arena;
+    // std / os objects own FILEs, pipes, and timers outside the arena;
+    // their finalizers have to run.
+    data->arena_fast_teardown =
+        use_arena &&
+        !RTEST(rb_funcall(r_features, rb_intern("include?"), 1, QUICKJSRB_SYM(featureStdId))) &&
+        !RTEST(rb_funcall(r_features, rb_intern("include?"), 1, QUICKJSRB_SYM(featureOsId)));
+    JS_SetContextOpaque(data->context, data);
+    data->memory_limit = memory_limit;
+    data->max_stack_size = max_stack_size;
+
+    init_phase_begin(data, data->heap, &phase);
+    vm_setup_private_runtime(data);
+    init_phase_end(data, &phase, ID2SYM(rb_intern("runtime_hooks")));
+  }
+  else
+  {
+    // Limits, module hooks, the rejection tracker, and quickjs-libc's
+    // handlers are runtime-wide and were set up by Quickjs::Runtime.new.
+    // MODULE_OS timers live in that per-runtime state too and would fire
+    // against whichever context happens to be awaiting, so they stay
+    // exclusive to private runtimes.
+    if (!NIL_P(r_memory_limit) || !NIL_P(r_max_stack_size))
+      rb_raise(rb_eArgError, "memory_limit: and max_stack_size: belong to the Quickjs::Runtime when runtime: is given");
+    if (use_arena)
+      rb_raise(rb_eArgError, "allocator: :arena needs a private runtime; it can't be combined with runtime:");
+    if (RTEST(rb_funcall(r_features, rb_intern("include?"), 1, QUICKJSRB_SYM(featureOsId))))
+      rb_raise(rb_eArgError, "MODULE_OS is not supported on a shared Quickjs::Runtime");
+
+    QuickjsrbRuntime *shared = quickjsrb_runtime_from_value(r_runtime);
+    init_phase_begin(data, &shared->heap, &phase);
+    JSContext *context = quickjsrb_new_context(shared->runtime, data->intrinsics);
+    if (context == NULL)
+      rb_raise(rb_eNoMemError, "failed to allocate a QuickJS context");
+    init_phase_end(data, &phase, ID2SYM(rb_intern("context")));
+    data->context = context;
+    data->shared_runtime = shared;
+    data->r_runtime = r_runtime;
+    JS_SetContextOpaque(data->context, data);
+    quickjsrb_runtime_attach(shared, r_self);
+
+    // A sibling's timer may still be installed, and possibly lapsed; the
+    // polyfill loads below are unbudgeted (see vm_m_loadPolyfillBytecode).
+    if (shared->active_depth == 0)
+    {
+      JS_SetInterruptHandler(shared->runtime, NULL, NULL);
+      shared->interrupt_opaque = NULL;
+    }
+  }
+
+  vm_setup_context(data, r_features, data->lazy_polyfills);
+  quickjsrb_heap_sync(vm_heap(data));
 
   return r_self;
 }
@@ -1326,10 +2363,38 @@ static int interrupt_handler(JSRuntime *runtime, void *opaque)
   clock_gettime(CLOCK_MONOTONIC, &now);
   int64_t elapsed_ms = (int64_t)(now.tv_sec - eval_time->started_at.tv_sec) * 1000
                      + (now.tv_nsec - eval_time->started_at.tv_nsec) / 1000000;
-  return elapsed_ms >= eval_time->limit_ms ? 1 : 0;
+  if (elapsed_ms < eval_time->limit_ms)
+    return 0;
+  eval_time->fired = true;
+  return 1;
 }
 
-static VALUE to_rb_return_value(JSContext *ctx, JSValue j_val)
+// JSON.stringify(j_val) as one UTF-8 String, skipping the Ruby object
+// graph; nil where JSON.stringify gives undefined (undefined itself,
+// functions). Frees j_val; raises what stringify throws (cycles, BigInt).
+static VALUE to_rb_json_result(JSContext *ctx, JSValue j_val)
+{
+  JSValue j_json = JS_JSONStringify(ctx, j_val, JS_UNDEFINED, JS_UNDEFINED);
+  JS_FreeValue(ctx, j_val);
+  if (JS_IsException(j_json))
+    return to_rb_value(ctx, j_json); // raises
+  if (!JS_IsString(j_json))
+  {
+    JS_FreeValue(ctx, j_json);
+    return Qnil;
+  }
+
+  size_t len;
+  const char *json = JS_ToCStringLen(ctx, &len, j_json);
+  JS_FreeValue(ctx, j_json);
+  if (json == NULL)
+    return to_rb_value(ctx, JS_EXCEPTION); // raises
+  VALUE r_json = rb_utf8_str_new(json, (long)len);
+  JS_FreeCString(ctx, json);
+  return r_json;
+}
+
+static VALUE to_rb_return_value(JSContext *ctx, JSValue j_val, const ResultOpts *opts)
 {
   if (JS_VALUE_GET_NORM_TAG(j_val) == JS_TAG_OBJECT && JS_PromiseState(ctx, j_val) != -1)
   {
@@ -1338,7 +2403,9 @@ static VALUE to_rb_return_value(JSContext *ctx, JSValue j_val)
     rb_exc_raise(rb_funcall(QUICKJSRB_ERROR_FOR(QUICKJSRB_NO_AWAIT_ERROR), rb_intern("new"), 2, r_error_message, Qnil));
     return Qnil;
   }
-  VALUE result = to_rb_value(ctx, j_val);
+  if (opts != NULL && opts->json && !JS_IsException(j_val))
+    return to_rb_json_result(ctx, j_val);
+  VALUE result = to_rb_value_with(ctx, j_val, opts);
   JS_FreeValue(ctx, j_val);
   return result;
 }
@@ -1359,6 +2426,11 @@ static void check_disposed(VMData *data)
     VALUE r_msg = rb_str_new2("VM has been disposed; create a new Quickjs::VM");
     rb_exc_raise(rb_funcall(QUICKJSRB_ERROR_FOR(QUICKJSRB_ROOT_RUNTIME_ERROR), rb_intern("new"), 2, r_msg, Qnil));
   }
+  if (data->context == NULL)
+  {
+    VALUE r_msg = rb_str_new2("VM is not initialized");
+    rb_exc_raise(rb_funcall(QUICKJSRB_ERROR_FOR(QUICKJSRB_ROOT_RUNTIME_ERROR), rb_intern("new"), 2, r_msg, Qnil));
+  }
 }
 
 // Validate that r_code is a String and resolve the :filename option (default "<code>")
@@ -1384,6 +2456,8 @@ static void arm_eval_timer(VMData *data)
 {
   clock_gettime(CLOCK_MONOTONIC, &data->eval_time->started_at);
   JS_SetInterruptHandler(JS_GetRuntime(data->context), interrupt_handler, data->eval_time);
+  if (data->shared_runtime != NULL)
+    data->shared_runtime->interrupt_opaque = data->eval_time;
 }
 
 // Pure-path predicate: true when no JS→Ruby bridge can fire during eval
@@ -1402,9 +2476,14 @@ static void arm_eval_timer(VMData *data)
 // race when multiple VMs run those APIs concurrently. Gating the whole
 // feature would re-serialize os.sleep / os.setTimeout across threads, so
 // the constraint is documented in the README instead.
+//
+// Contexts on a shared Quickjs::Runtime never qualify: sibling contexts
+// run on other threads under the GVL, and one JSRuntime can't be entered
+// from two threads at once.
 static bool can_eval_gvl_free(VMData *data)
 {
-  return RHASH_SIZE(data->defined_functions) == 0
+  return data->shared_runtime == NULL
+      && RHASH_SIZE(data->defined_functions) == 0
       && NIL_P(data->module_loader)
       && NIL_P(data->on_unhandled_rejection)
       && !data->has_native_ruby_bridge;
@@ -1465,12 +2544,26 @@ struct gvl_release_region
   void *owned_bufs[2];
   bool prev_gvl_released;
   bool completed;
+  // Contexts on a shared Quickjs::Runtime run the job with the GVL held
+  // (see can_eval_gvl_free) but keep the rest of the region's handshake;
+  // `entered` records that quickjsrb_runtime_enter succeeded.
+  bool hold_gvl;
+  bool entered;
 };
 
 static VALUE gvl_release_region_run(VALUE p)
 {
   struct gvl_release_region *region = (struct gvl_release_region *)p;
-  rb_thread_call_without_gvl(region->job_run, region->job, NULL, NULL);
+  if (region->hold_gvl)
+  {
+    quickjsrb_runtime_enter(region->data->shared_runtime);
+    region->entered = true;
+    region->job_run(region->job);
+  }
+  else
+  {
+    rb_thread_call_without_gvl(region->job_run, region->job, NULL, NULL);
+  }
   region->completed = true;
   return Qnil;
 }
@@ -1479,9 +2572,23 @@ static VALUE gvl_release_region_cleanup(VALUE p)
 {
   struct gvl_release_region *region = (struct gvl_release_region *)p;
   VMData *data = region->data;
-  data->gvl_released_js = region->prev_gvl_released;
   data->evals_in_flight--;
-  data->gvl_release_regions--;
+  if (region->hold_gvl)
+  {
+    if (region->entered)
+      quickjsrb_runtime_leave(data->shared_runtime);
+  }
+  else
+  {
+    data->gvl_released_js = region->prev_gvl_released;
+    data->gvl_release_regions--;
+    if (data->gvl_release_regions == 0)
+    {
+      quickjsrb_object_refs_drain(data);
+      quickjsrb_refs_sweep(data);
+    }
+  }
+  quickjsrb_heap_sync(vm_heap(data));
   free(region->owned_bufs[0]);
   free(region->owned_bufs[1]);
   // Frees the result when the interrupt landed after the job ran but
@@ -1493,6 +2600,24 @@ static VALUE gvl_release_region_cleanup(VALUE p)
   return Qnil;
 }
 
+// Prepares the outermost JS entry into a VM. A private runtime keeps the
+// native stack top of the thread that built it, so a VM built on one
+// thread (a VMPool warmer) and evaluated on another would be checked
+// against the wrong stack; re-anchor it, as quickjsrb_runtime_enter does
+// for shared runtimes. Only at the outermost entry, since a nested one
+// would move the top down the stack and let JS recurse past the thread's
+// real limit. The heap's global_refused is cleared here too: a refusal
+// that JS caught and handled itself must not label a later, unrelated
+// out-of-memory error as the global budget's.
+static void js_entry_prepare(VMData *data)
+{
+  if (data->evals_in_flight > 0 || (data->shared_runtime != NULL && data->shared_runtime->active_depth > 0))
+    return;
+  vm_heap(data)->global_refused = false;
+  if (data->shared_runtime == NULL)
+    JS_UpdateStackTop(JS_GetRuntime(data->context));
+}
+
 // Run job_run(job) with the GVL released. owned_buf0/1 are malloc'd
 // buffers backing the job's inputs; ownership transfers to the region,
 // which frees them on every exit path — including the disposed bail-out
@@ -1518,11 +2643,17 @@ static void run_gvl_release_region(VMData *data, void *(*job_run)(void *), void
       .owned_bufs = {owned_buf0, owned_buf1},
       .prev_gvl_released = data->gvl_released_js,
       .completed = false,
+      .hold_gvl = data->shared_runtime != NULL,
+      .entered = false,
   };
 
+  js_entry_prepare(data);
   data->evals_in_flight++;
-  data->gvl_release_regions++;
-  data->gvl_released_js = true;
+  if (!region.hold_gvl)
+  {
+    data->gvl_release_regions++;
+    data->gvl_released_js = true;
+  }
   rb_ensure(gvl_release_region_run, (VALUE)&region, gvl_release_region_cleanup, (VALUE)&region);
 }
 
@@ -1540,9 +2671,32 @@ static void check_no_gvl_release_in_flight(VMData *data)
     rb_raise(rb_eThreadError, "cannot install a JS-to-Ruby bridge on a Quickjs::VM while it is evaluating with the GVL released");
 }
 
+struct held_js_entry
+{
+  VMData *data;
+  VALUE (*body)(VALUE);
+  VALUE arg;
+  bool entered;
+};
+
+static VALUE held_js_entry_run(VALUE p)
+{
+  struct held_js_entry *entry = (struct held_js_entry *)p;
+  if (entry->data->shared_runtime != NULL)
+  {
+    quickjsrb_runtime_enter(entry->data->shared_runtime);
+    entry->entered = true;
+  }
+  return entry->body(entry->arg);
+}
+
 static VALUE evals_in_flight_release(VALUE p)
 {
-  ((VMData *)p)->evals_in_flight--;
+  struct held_js_entry *entry = (struct held_js_entry *)p;
+  entry->data->evals_in_flight--;
+  if (entry->entered)
+    quickjsrb_runtime_leave(entry->data->shared_runtime);
+  quickjsrb_heap_sync(vm_heap(entry->data));
   return Qnil;
 }
 
@@ -1563,8 +2717,18 @@ static VALUE evals_in_flight_release(VALUE p)
 static VALUE run_held_js_entry(VMData *data, VALUE (*body)(VALUE), VALUE arg)
 {
   check_disposed(data);
+  struct held_js_entry entry = {data, body, arg, false};
+  js_entry_prepare(data);
   data->evals_in_flight++;
-  return rb_ensure(body, arg, evals_in_flight_release, (VALUE)data);
+  return rb_ensure(held_js_entry_run, (VALUE)&entry, evals_in_flight_release, (VALUE)&entry);
+}
+
+VALUE quickjsrb_run_js_entry(VMData *data, VALUE (*body)(VALUE), VALUE arg)
+{
+  check_disposed(data);
+  check_oom_poisoned(data);
+  arm_eval_timer(data);
+  return run_held_js_entry(data, body, arg);
 }
 
 static VALUE eval_code_job_run_body(VALUE p)
@@ -1614,10 +2778,25 @@ static char *copy_rstring_to_owned_buffer(VALUE r_str, size_t *out_len, bool nul
   return buf;
 }
 
+// Bytecode for a GVL-released run: sealed bytecode (preload_for_fork) is
+// read in place, anything else copied as above. *owned says which, i.e.
+// whether the region must free the buffer.
+static uint8_t *bytecode_buffer_for_release(VALUE r_bytecode, size_t *out_len, bool *owned)
+{
+  if (quickjsrb_sealed_p(RSTRING_PTR(r_bytecode), (size_t)RSTRING_LEN(r_bytecode)))
+  {
+    *out_len = (size_t)RSTRING_LEN(r_bytecode);
+    *owned = false;
+    return (uint8_t *)RSTRING_PTR(r_bytecode);
+  }
+  *owned = true;
+  return (uint8_t *)copy_rstring_to_owned_buffer(r_bytecode, out_len, false);
+}
+
 // Run the eval core without the GVL. Inputs are copied to malloc'd buffers
 // because RSTRING_PTR can be invalidated by GC compaction while we're
 // released.
-static VALUE eval_code_release_gvl(VMData *data, VALUE r_code, const char *filename, bool async_mode)
+static VALUE eval_code_release_gvl(VMData *data, VALUE r_code, const char *filename, bool async_mode, const ResultOpts *opts)
 {
   size_t code_len;
   char *code_buf = copy_rstring_to_owned_buffer(r_code, &code_len, true);
@@ -1639,7 +2818,7 @@ static VALUE eval_code_release_gvl(VMData *data, VALUE r_code, const char *filen
   };
   run_gvl_release_region(data, eval_code_job_run, &job, &job.result, code_buf, filename_buf);
 
-  return to_rb_return_value(data->context, job.result);
+  return to_rb_return_value(data->context, job.result, opts);
 }
 
 static VALUE vm_m_evalCode(int argc, VALUE *argv, VALUE r_self)
@@ -1655,11 +2834,27 @@ static VALUE vm_m_evalCode(int argc, VALUE *argv, VALUE r_self)
   const char *filename = parse_code_and_filename(r_code, r_opts);
 
   bool async_mode = true;
+  ResultOpts opts = {false, Qnil, false};
   if (!NIL_P(r_opts))
   {
     VALUE r_async = rb_hash_aref(r_opts, ID2SYM(rb_intern("async")));
     if (r_async == Qfalse)
       async_mode = false;
+    opts.symbolize_names = RTEST(rb_hash_aref(r_opts, ID2SYM(rb_intern("symbolize_names"))));
+
+    VALUE r_materialize = rb_hash_aref(r_opts, ID2SYM(rb_intern("materialize")));
+    if (r_materialize == ID2SYM(rb_intern("lazy")))
+      opts.r_lazy_vm = r_self;
+    else if (!NIL_P(r_materialize) && r_materialize != ID2SYM(rb_intern("eager")))
+      rb_raise(rb_eArgError, "materialize: must be :eager or :lazy");
+
+    VALUE r_result = rb_hash_aref(r_opts, ID2SYM(rb_intern("result")));
+    if (r_result == ID2SYM(rb_intern("json")))
+      opts.json = true;
+    else if (!NIL_P(r_result) && r_result != ID2SYM(rb_intern("ruby")))
+      rb_raise(rb_eArgError, "result: must be :ruby or :json");
+    if (opts.json && !NIL_P(opts.r_lazy_vm))
+      rb_raise(rb_eArgError, "result: :json can't be combined with materialize: :lazy");
   }
 
   arm_eval_timer(data);
@@ -1667,7 +2862,7 @@ static VALUE vm_m_evalCode(int argc, VALUE *argv, VALUE r_self)
   StringValue(r_code);
 
   if (can_eval_gvl_free(data))
-    return eval_code_release_gvl(data, r_code, filename, async_mode);
+    return eval_code_release_gvl(data, r_code, filename, async_mode, &opts);
 
   // Bridged path: a JS→Ruby bridge (define_function / module loader /
   // setTimeout / File / crypto) may fire mid-eval, so keep the GVL held and
@@ -1682,7 +2877,7 @@ static VALUE vm_m_evalCode(int argc, VALUE *argv, VALUE r_self)
       .result = JS_UNDEFINED,
   };
   run_held_js_entry(data, eval_code_job_run_body, (VALUE)&job);
-  return to_rb_return_value(data->context, job.result);
+  return to_rb_return_value(data->context, job.result, &opts);
 }
 
 static VALUE vm_m_compile(int argc, VALUE *argv, VALUE r_self)
@@ -1747,10 +2942,11 @@ static VALUE vm_m_evalBytecode(VALUE r_self, VALUE r_bytecode)
     // executing one compiled bundle across per-thread VMs recover
     // multi-core scaling instead of serializing every run through the
     // GVL. The bytecode is copied because RSTRING_PTR is GC-movable
-    // while the GVL is released.
+    // while the GVL is released, unless it's sealed.
     size_t buf_len;
-    uint8_t *buf = (uint8_t *)copy_rstring_to_owned_buffer(r_bytecode, &buf_len, false);
-    j_result = run_bytecode_release_gvl(data, bytecode_eval_await_job_run, buf, buf_len, true);
+    bool owned;
+    uint8_t *buf = bytecode_buffer_for_release(r_bytecode, &buf_len, &owned);
+    j_result = run_bytecode_release_gvl(data, bytecode_eval_await_job_run, buf, buf_len, owned);
   }
   else
   {
@@ -1771,7 +2967,7 @@ static VALUE vm_m_evalBytecode(VALUE r_self, VALUE r_bytecode)
 
   JSValue j_returnedValue = JS_GetPropertyStr(data->context, j_result, "value");
   JS_FreeValue(data->context, j_result);
-  return to_rb_return_value(data->context, j_returnedValue);
+  return to_rb_return_value(data->context, j_returnedValue, NULL);
 }
 
 // Loads pre-compiled polyfill bytecode without arming the eval timer.
@@ -1816,15 +3012,20 @@ static VALUE vm_m_loadPolyfillBytecode(VALUE r_self, VALUE r_bytecode)
   // when this load is the outermost JS activity, though: a load issued
   // from inside a bridge callback (e.g. an on_log listener) must stay
   // under the in-flight eval's budget, not erase it.
-  if (data->evals_in_flight == 0)
+  if (data->evals_in_flight == 0 && (data->shared_runtime == NULL || data->shared_runtime->active_depth == 0))
+  {
     JS_SetInterruptHandler(JS_GetRuntime(data->context), NULL, NULL);
+    if (data->shared_runtime != NULL)
+      data->shared_runtime->interrupt_opaque = NULL;
+  }
 
   size_t buf_len = (size_t)RSTRING_LEN(r_bytecode);
   JSValue j_result;
   if (can_eval_gvl_free(data))
   {
-    uint8_t *buf = (uint8_t *)copy_rstring_to_owned_buffer(r_bytecode, &buf_len, false);
-    j_result = load_polyfill_bytecode(data, buf, buf_len, true);
+    bool owned;
+    uint8_t *buf = bytecode_buffer_for_release(r_bytecode, &buf_len, &owned);
+    j_result = load_polyfill_bytecode(data, buf, buf_len, owned);
   }
   else
   {
@@ -1845,6 +3046,228 @@ static VALUE vm_m_loadPolyfillBytecode(VALUE r_self, VALUE r_bytecode)
   return Qnil;
 }
 
+// Lazy counterpart of _load_polyfill_bytecode for register_polyfill
+// entries that declare their globals:. The bytecode is copied into the
+// context's heap — the Ruby String may move or be replaced by a
+// re-registration before the stub fires.
+static VALUE vm_m_installLazyPolyfill(VALUE r_self, VALUE r_bytecode, VALUE r_globals)
+{
+  VMData *data;
+  TypedData_Get_Struct(r_self, VMData, &vm_type, data);
+
+  StringValue(r_bytecode);
+  Check_Type(r_globals, T_ARRAY);
+  long names_len = RARRAY_LEN(r_globals);
+  if (names_len == 0)
+    rb_raise(rb_eArgError, "a lazy polyfill needs at least one global");
+
+  VALUE r_names = rb_ary_new_capa(names_len);
+  const char **names = ALLOCA_N(const char *, names_len);
+  for (long i = 0; i < names_len; i++)
+  {
+    VALUE r_name = rb_String(RARRAY_AREF(r_globals, i));
+    rb_ary_push(r_names, r_name);
+    names[i] = StringValueCStr(r_name);
+  }
+
+  check_disposed(data);
+  check_oom_poisoned(data);
+
+  // Sealed bytecode (preload_for_fork) is wrapped in place like the bundled
+  // polyfills' static data: sealed regions are never unmapped, and a copy
+  // per VM would undo the pages forked workers share.
+  const uint8_t *buf = (const uint8_t *)RSTRING_PTR(r_bytecode);
+  size_t buf_len = (size_t)RSTRING_LEN(r_bytecode);
+  JSValue j_bytecode = quickjsrb_sealed_p(buf, buf_len) ? JS_NewArrayBuffer(data->context, (uint8_t *)buf, buf_len, NULL, NULL, false)
+                                                        : JS_NewArrayBufferCopy(data->context, buf, buf_len);
+  if (JS_IsException(j_bytecode))
+    return to_rb_value(data->context, j_bytecode); // raises
+  install_lazy_polyfill(data->context, j_bytecode, names, names_len);
+
+  RB_GC_GUARD(r_names);
+  return Qnil;
+}
+
+static VALUE raise_vm_runtime_error(const char *message)
+{
+  VALUE r_msg = rb_str_new2(message);
+  rb_exc_raise(rb_funcall(QUICKJSRB_ERROR_FOR(QUICKJSRB_ROOT_RUNTIME_ERROR), rb_intern("new"), 2, r_msg, Qnil));
+  return Qnil;
+}
+
+// Own string-keyed property names of the global object, non-enumerable
+// ones included — i.e. everything a fresh VM with the same options
+// already has, which VM#snapshot_to leaves out of the state it stores.
+static VALUE vm_m_globalNames(VALUE r_self)
+{
+  VMData *data;
+  TypedData_Get_Struct(r_self, VMData, &vm_type, data);
+  check_disposed(data);
+
+  JSContext *ctx = data->context;
+  JSValue j_global = JS_GetGlobalObject(ctx);
+  JSPropertyEnum *props;
+  uint32_t len;
+  if (JS_GetOwnPropertyNames(ctx, &props, &len, j_global, JS_GPN_STRING_MASK) < 0)
+  {
+    JS_FreeValue(ctx, j_global);
+    return to_rb_value(ctx, JS_EXCEPTION); // raises
+  }
+
+  VALUE r_names = rb_ary_new_capa(len);
+  for (uint32_t i = 0; i < len; i++)
+  {
+    const char *name = JS_AtomToCString(ctx, props[i].atom);
+    if (name == NULL)
+      continue;
+    rb_ary_push(r_names, rb_str_new2(name));
+    JS_FreeCString(ctx, name);
+  }
+  JS_FreePropertyEnum(ctx, props, len);
+  JS_FreeValue(ctx, j_global);
+  return r_names;
+}
+
+// Serializes the data-valued globals not named in r_exclude into one
+// JS_WriteObject blob. JS_WRITE_OBJ_REFERENCE keeps objects shared between
+// globals (and cycles) shared on the way back in. Accessor properties are
+// skipped without being read, and so is any global whose value graph
+// JS_WriteObject refuses — functions/closures, class instances with host
+// state, Promises — so one unserializable global doesn't cost the rest.
+// Nothing here runs user JS, so the GVL stays held without the in-flight
+// bookkeeping. Returns nil when there's nothing to carry.
+static VALUE vm_m_dumpGlobals(VALUE r_self, VALUE r_exclude)
+{
+  VMData *data;
+  TypedData_Get_Struct(r_self, VMData, &vm_type, data);
+  Check_Type(r_exclude, T_ARRAY);
+  check_disposed(data);
+  check_oom_poisoned(data);
+
+  VALUE r_excluded = rb_hash_new();
+  for (long i = 0; i < RARRAY_LEN(r_exclude); i++)
+    rb_hash_aset(r_excluded, rb_String(RARRAY_AREF(r_exclude, i)), Qtrue);
+
+  JSContext *ctx = data->context;
+  JSValue j_global = JS_GetGlobalObject(ctx);
+  JSPropertyEnum *props;
+  uint32_t len;
+  if (JS_GetOwnPropertyNames(ctx, &props, &len, j_global, JS_GPN_STRING_MASK) < 0)
+  {
+    JS_FreeValue(ctx, j_global);
+    return to_rb_value(ctx, JS_EXCEPTION); // raises
+  }
+
+  JSValue j_bag = JS_NewObject(ctx);
+  uint32_t carried = 0;
+  for (uint32_t i = 0; i < len; i++)
+  {
+    const char *name = JS_AtomToCString(ctx, props[i].atom);
+    if (name == NULL)
+    {
+      JS_FreeValue(ctx, JS_GetException(ctx));
+      continue;
+    }
+    bool excluded = RTEST(rb_hash_lookup(r_excluded, rb_str_new2(name)));
+    JS_FreeCString(ctx, name);
+    if (excluded)
+      continue;
+
+    JSPropertyDescriptor desc;
+    int found = JS_GetOwnProperty(ctx, &desc, j_global, props[i].atom);
+    if (found <= 0)
+    {
+      if (found < 0)
+        JS_FreeValue(ctx, JS_GetException(ctx));
+      continue;
+    }
+    JS_FreeValue(ctx, desc.getter);
+    JS_FreeValue(ctx, desc.setter);
+    if ((desc.flags & JS_PROP_GETSET) || JS_IsFunction(ctx, desc.value))
+    {
+      JS_FreeValue(ctx, desc.value);
+      continue;
+    }
+
+    size_t probe_len;
+    uint8_t *probe = JS_WriteObject(ctx, &probe_len, desc.value, JS_WRITE_OBJ_REFERENCE);
+    if (probe == NULL)
+    {
+      JS_FreeValue(ctx, JS_GetException(ctx));
+      JS_FreeValue(ctx, desc.value);
+      continue;
+    }
+    js_free(ctx, probe);
+    JS_DefinePropertyValue(ctx, j_bag, props[i].atom, desc.value, JS_PROP_C_W_E);
+    carried++;
+  }
+  JS_FreePropertyEnum(ctx, props, len);
+  JS_FreeValue(ctx, j_global);
+
+  if (carried == 0)
+  {
+    JS_FreeValue(ctx, j_bag);
+    return Qnil;
+  }
+
+  size_t out_len;
+  uint8_t *out_buf = JS_WriteObject(ctx, &out_len, j_bag, JS_WRITE_OBJ_REFERENCE);
+  JS_FreeValue(ctx, j_bag);
+  if (out_buf == NULL)
+  {
+    JS_FreeValue(ctx, JS_GetException(ctx));
+    return raise_vm_runtime_error("failed to serialize VM globals");
+  }
+
+  VALUE r_blob = rb_str_new((const char *)out_buf, (long)out_len);
+  rb_enc_associate(r_blob, rb_ascii8bit_encoding());
+  js_free(ctx, out_buf);
+  return rb_obj_freeze(r_blob);
+}
+
+// Counterpart of _dump_globals: assigns every property of the serialized
+// bag onto globalThis with plain assignment semantics, so a name the
+// target already holds as non-writable keeps its value. Deserialization
+// allocates but runs no user JS — GVL held, no in-flight bookkeeping.
+static VALUE vm_m_loadGlobals(VALUE r_self, VALUE r_blob)
+{
+  VMData *data;
+  TypedData_Get_Struct(r_self, VMData, &vm_type, data);
+  StringValue(r_blob);
+  check_disposed(data);
+  check_oom_poisoned(data);
+
+  JSContext *ctx = data->context;
+  JSValue j_bag = JS_ReadObject(ctx, (const uint8_t *)RSTRING_PTR(r_blob), (size_t)RSTRING_LEN(r_blob), JS_READ_OBJ_REFERENCE);
+  if (JS_IsException(j_bag))
+    return to_rb_value(ctx, j_bag); // raises
+  if (!JS_IsObject(j_bag))
+  {
+    JS_FreeValue(ctx, j_bag);
+    return raise_vm_runtime_error("serialized VM globals are not an object");
+  }
+
+  JSPropertyEnum *props;
+  uint32_t len;
+  if (JS_GetOwnPropertyNames(ctx, &props, &len, j_bag, JS_GPN_STRING_MASK | JS_GPN_ENUM_ONLY) < 0)
+  {
+    JS_FreeValue(ctx, j_bag);
+    return to_rb_value(ctx, JS_EXCEPTION); // raises
+  }
+
+  JSValue j_global = JS_GetGlobalObject(ctx);
+  for (uint32_t i = 0; i < len; i++)
+  {
+    JSValue j_value = JS_GetProperty(ctx, j_bag, props[i].atom);
+    if (JS_SetProperty(ctx, j_global, props[i].atom, j_value) < 0)
+      JS_FreeValue(ctx, JS_GetException(ctx));
+  }
+  JS_FreeValue(ctx, j_global);
+  JS_FreePropertyEnum(ctx, props, len);
+  JS_FreeValue(ctx, j_bag);
+  return Qnil;
+}
+
 static VALUE vm_m_defineGlobalFunction(int argc, VALUE *argv, VALUE r_self)
 {
   rb_need_block();
@@ -1979,6 +3402,10 @@ struct js_entry_call
   int argc;
   VALUE *argv;
   VMData *data;
+  bool symbolize_names;
+  // call_json: argv[1..] are JSON texts, parsed with JS_ParseJSON, and the
+  // result comes back stringified.
+  bool json;
 };
 
 static VALUE call_global_function_body(VALUE p)
@@ -2094,11 +3521,28 @@ static VALUE call_global_function_body(VALUE p)
   {
     j_args = (JSValue *)malloc(sizeof(JSValue) * nargs);
     for (int i = 0; i < nargs; i++)
-      j_args[i] = to_js_value(data->context, argv[i + 1]);
+    {
+      if (!call->json)
+      {
+        j_args[i] = to_js_value(data->context, argv[i + 1]);
+        continue;
+      }
+      // StringValueCStr guarantees the terminating NUL JS_ParseJSON reads.
+      const char *json = StringValueCStr(argv[i + 1]);
+      j_args[i] = JS_ParseJSON(data->context, json, (size_t)RSTRING_LEN(argv[i + 1]), vmInternalFilename);
+      if (JS_IsException(j_args[i]))
+      {
+        for (int j = 0; j < i; j++)
+          JS_FreeValue(data->context, j_args[j]);
+        free(j_args);
+        JS_FreeValue(data->context, j_func);
+        JS_FreeValue(data->context, j_this);
+        return to_rb_value(data->context, JS_EXCEPTION); // raises
+      }
+    }
   }
 
-  clock_gettime(CLOCK_MONOTONIC, &data->eval_time->started_at);
-  JS_SetInterruptHandler(JS_GetRuntime(data->context), interrupt_handler, data->eval_time);
+  arm_eval_timer(data);
 
   JSValue j_result = JS_Call(data->context, j_func, j_this, nargs, (JSValueConst *)j_args);
 
@@ -2112,7 +3556,8 @@ static VALUE call_global_function_body(VALUE p)
   }
 
   // js_std_await handles both async (promise) and sync results; frees j_result
-  return to_rb_return_value(data->context, js_std_await(data->context, j_result));
+  ResultOpts opts = {call->symbolize_names, Qnil, call->json};
+  return to_rb_return_value(data->context, js_std_await(data->context, j_result), &opts);
 }
 
 static VALUE vm_m_callGlobalFunction(int argc, VALUE *argv, VALUE r_self)
@@ -2131,7 +3576,44 @@ static VALUE vm_m_callGlobalFunction(int argc, VALUE *argv, VALUE r_self)
   // calls that can yield the GVL (path-segment to_s, argument
   // conversion), and a concurrent dispose! landing in such a gap would
   // free the runtime out from under them.
-  struct js_entry_call call = {argc, argv, data};
+  // `symbolize_names:` is an option of call itself, and only as a real
+  // keyword: a Hash passed in braces reaches the function untouched. The
+  // key is reserved among keywords, so it can't be mixed with keywords
+  // meant as the function's options object, which would otherwise arrive
+  // with it stripped.
+  bool symbolize_names = false;
+  VALUE r_symbolize_names = ID2SYM(rb_intern("symbolize_names"));
+  if (argc > 1 && rb_keyword_given_p() && RB_TYPE_P(argv[argc - 1], T_HASH) &&
+      rb_hash_lookup2(argv[argc - 1], r_symbolize_names, Qundef) != Qundef)
+  {
+    if (RHASH_SIZE(argv[argc - 1]) != 1)
+      rb_raise(rb_eArgError, "symbolize_names: can't be mixed with other keywords; pass the function's options as a Hash in braces");
+    symbolize_names = RTEST(rb_hash_aref(argv[argc - 1], r_symbolize_names));
+    argc--;
+  }
+
+  struct js_entry_call call = {argc, argv, data, symbolize_names, false};
+  return run_held_js_entry(data, call_global_function_body, (VALUE)&call);
+}
+
+// call for JSON-in, JSON-out work: each argument is JSON text that JS
+// receives parsed, and the (awaited) result comes back as JSON text. No
+// Ruby object graph is built on either side.
+static VALUE vm_m_callJson(int argc, VALUE *argv, VALUE r_self)
+{
+  if (argc < 1)
+    rb_raise(rb_eArgError, "wrong number of arguments (given 0, expected 1+)");
+
+  VMData *data;
+  TypedData_Get_Struct(r_self, VMData, &vm_type, data);
+
+  check_disposed(data);
+  check_oom_poisoned(data);
+
+  for (int i = 1; i < argc; i++)
+    StringValue(argv[i]);
+
+  struct js_entry_call call = {argc, argv, data, false, true};
   return run_held_js_entry(data, call_global_function_body, (VALUE)&call);
 }
 
@@ -2296,6 +3778,7 @@ static VALUE vm_m_import(int argc, VALUE *argv, VALUE r_self)
 RUBY_FUNC_EXPORTED void Init_quickjsrb(void)
 {
   rb_require("json");
+  rb_require("set");
   rb_require("securerandom");
 
   VALUE r_module_quickjs = rb_define_module("Quickjs");
@@ -2309,7 +3792,15 @@ RUBY_FUNC_EXPORTED void Init_quickjsrb(void)
   rb_define_private_method(r_class_vm, "_compile_to_bytecode", vm_m_compile, -1);
   rb_define_private_method(r_class_vm, "_run_bytecode", vm_m_evalBytecode, 1);
   rb_define_private_method(r_class_vm, "_load_polyfill_bytecode", vm_m_loadPolyfillBytecode, 1);
+  rb_define_private_method(r_class_vm, "_install_lazy_polyfill", vm_m_installLazyPolyfill, 2);
+  rb_define_private_method(r_class_vm, "_global_names", vm_m_globalNames, 0);
+  rb_define_private_method(r_class_vm, "_dump_globals", vm_m_dumpGlobals, 1);
+  rb_define_private_method(r_class_vm, "_load_globals", vm_m_loadGlobals, 1);
+  rb_define_private_method(r_class_vm, "_reset_context", vm_m_resetContext, 1);
+  rb_define_private_method(r_class_vm, "_rebuild_runtime", vm_m_rebuildRuntime, 1);
+  rb_define_private_method(r_class_vm, "_init_phase", vm_m_initPhase, 1);
   rb_define_method(r_class_vm, "call", vm_m_callGlobalFunction, -1);
+  rb_define_method(r_class_vm, "call_json", vm_m_callJson, -1);
   rb_define_method(r_class_vm, "define_function", vm_m_defineGlobalFunction, -1);
   rb_define_method(r_class_vm, "import", vm_m_import, -1);
   rb_define_method(r_class_vm, "module_loader", vm_m_get_module_loader, 0);
@@ -2318,11 +3809,25 @@ RUBY_FUNC_EXPORTED void Init_quickjsrb(void)
   rb_define_method(r_class_vm, "on_log", vm_m_on_log, 0);
   rb_define_method(r_class_vm, "memory_usage", vm_m_memoryUsage, 0);
   rb_define_method(r_class_vm, "gc!", vm_m_runGC, 0);
+  rb_define_method(r_class_vm, "heap_bytes", vm_m_heapBytes, 0);
   rb_define_method(r_class_vm, "memory_poisoned?", vm_m_memoryPoisoned, 0);
+  rb_define_method(r_class_vm, "interrupted?", vm_m_interrupted, 0);
   rb_define_method(r_class_vm, "dispose!", vm_m_dispose, 0);
+  rb_define_method(r_class_vm, "dispose_later", vm_m_disposeLater, 0);
   rb_define_method(r_class_vm, "disposed?", vm_m_disposed, 0);
   rb_define_method(r_class_vm, "drain_jobs!", vm_m_drainJobs, 0);
+  rb_define_method(r_class_vm, "runtime", vm_m_runtime, 0);
+  rb_define_method(r_class_vm, "init_profile", vm_m_initProfile, 0);
   r_define_log_class(r_class_vm);
+
+  quickjsrb_init_runtime_class(r_module_quickjs);
+  quickjsrb_init_reaper(r_module_quickjs);
+  quickjsrb_init_heap(r_module_quickjs);
+  quickjsrb_init_preload(r_module_quickjs);
+  quickjsrb_init_bytes(r_module_quickjs);
+  quickjsrb_init_object_ref(r_module_quickjs);
+  quickjsrb_init_typed_array(r_module_quickjs);
+  quickjsrb_init_ref(r_module_quickjs);
 }
 
 static VALUE vm_m_memoryUsage(VALUE r_self)
@@ -2330,8 +3835,13 @@ static VALUE vm_m_memoryUsage(VALUE r_self)
   VMData *data;
   TypedData_Get_Struct(r_self, VMData, &vm_type, data);
   check_disposed(data);
+  return quickjsrb_memory_usage_hash(JS_GetRuntime(data->context));
+}
+
+VALUE quickjsrb_memory_usage_hash(JSRuntime *runtime)
+{
   JSMemoryUsage s;
-  JS_ComputeMemoryUsage(JS_GetRuntime(data->context), &s);
+  JS_ComputeMemoryUsage(runtime, &s);
   VALUE h = rb_hash_new();
   rb_hash_aset(h, ID2SYM(rb_intern("malloc_size")), LL2NUM(s.malloc_size));
   rb_hash_aset(h, ID2SYM(rb_intern("malloc_limit")), LL2NUM(s.malloc_limit));
@@ -2354,9 +3864,20 @@ static VALUE vm_m_runGC(VALUE r_self)
   TypedData_Get_Struct(r_self, VMData, &vm_type, data);
   check_disposed(data);
   JS_RunGC(JS_GetRuntime(data->context));
+  quickjsrb_heap_sync(vm_heap(data));
   return Qnil;
 }
 
+// O(1): the allocator keeps this count as it goes, whereas memory_usage
+// walks the heap. For a VM on a Quickjs::Runtime it's the whole runtime's.
+static VALUE vm_m_heapBytes(VALUE r_self)
+{
+  VMData *data;
+  TypedData_Get_Struct(r_self, VMData, &vm_type, data);
+  check_disposed(data);
+  return SIZET2NUM(vm_heap(data)->bytes);
+}
+
 static VALUE drain_jobs_body(VALUE p)
 {
   VMData *data = (VMData *)p;
@@ -2397,6 +3918,13 @@ static VALUE vm_m_memoryPoisoned(VALUE r_self)
   return data->oom_poisoned ? Qtrue : Qfalse;
 }
 
+static VALUE vm_m_interrupted(VALUE r_self)
+{
+  VMData *data;
+  TypedData_Get_Struct(r_self, VMData, &vm_type, data);
+  return data->eval_time->fired ? Qtrue : Qfalse;
+}
+
 // JS_FreeContext + JS_FreeRuntime walk the entire heap to run finalisers.
 // On a VM with polyfills loaded this can be tens of milliseconds — run it
 // without the GVL so other Ruby threads (e.g. the next pool builder) keep
@@ -2405,7 +3933,8 @@ static VALUE vm_m_memoryPoisoned(VALUE r_self)
 // only fire during JS execution, not during free.
 static void *vm_dispose_no_gvl(void *p)
 {
-  vm_teardown_context((JSContext *)p);
+  VMData *data = (VMData *)p;
+  vm_teardown_context(data);
   return NULL;
 }
 
@@ -2426,17 +3955,30 @@ static VALUE vm_m_dispose(VALUE r_self)
   if (data->evals_in_flight > 0)
     rb_raise(rb_eThreadError, "cannot dispose a Quickjs::VM while it is evaluating");
 
-  if (!JS_IsUndefined(data->j_file_proxy_creator))
+  if (data->context == NULL)
   {
-    JS_FreeValue(data->context, data->j_file_proxy_creator);
-    data->j_file_proxy_creator = JS_UNDEFINED;
+    data->disposed = true;
+    return Qnil;
   }
 
+  vm_release_context_values(data, data->context);
+
   // Mark disposed before releasing the GVL so a concurrent dfree finds
   // disposed=true and skips its own teardown.
   data->disposed = true;
 
-  rb_thread_call_without_gvl(vm_dispose_no_gvl, data->context, NULL, NULL);
+  if (data->shared_runtime != NULL)
+  {
+    // Siblings may be evaluating on the runtime from other threads the
+    // moment the GVL is released, so free this context with it held.
+    quickjsrb_runtime_detach(data->shared_runtime, r_self);
+    vm_teardown_context(data);
+  }
+  else
+  {
+    rb_thread_call_without_gvl(vm_dispose_no_gvl, data, NULL, NULL);
+    quickjsrb_heap_forget(data->heap);
+  }
 
   // Drop references to user-supplied closures so Ruby GC can reclaim them
   // (and anything they captured) before the wrapping VM object itself is
@@ -2449,6 +3991,212 @@ static VALUE vm_m_dispose(VALUE r_self)
   return Qnil;
 }
 
+// dispose! that hands the private runtime to the reaper thread instead of
+// freeing it here. The VM is disposed on return either way. Contexts on a
+// shared runtime are freed inline: it's only the context, and it has to
+// happen under the GVL (see vm_m_dispose).
+static VALUE vm_m_disposeLater(VALUE r_self)
+{
+  VMData *data;
+  TypedData_Get_Struct(r_self, VMData, &vm_type, data);
+
+  if (data->disposed)
+    return Qnil;
+  if (data->evals_in_flight > 0)
+    rb_raise(rb_eThreadError, "cannot dispose a Quickjs::VM while it is evaluating");
+  if (data->context == NULL || data->shared_runtime != NULL)
+    return vm_m_dispose(r_self);
+
+  vm_release_context_values(data, data->context);
+  data->disposed = true;
+
+  // The heap gauge goes with the runtime: its allocator keeps writing to
+  // it until the reaper is done, and the reaper frees it.
+  quickjsrb_heap_forget(data->heap);
+  QuickjsrbHeap *heap = data->heap;
+  QuickjsrbArena *arena = data->arena;
+  data->heap = NULL;
+  data->arena = NULL;
+  quickjsrb_reaper_submit(data->context, arena, data->arena_fast_teardown, heap);
+
+  data->defined_functions = rb_hash_new();
+  data->alive_objects = rb_hash_new();
+  data->log_listener = Qnil;
+  data->module_loader = Qnil;
+
+  return Qnil;
+}
+
+static VALUE reset_drain_discard(VALUE p)
+{
+  return to_rb_value((JSContext *)p, JS_EXCEPTION); // raises
+}
+
+// Runs what's queued to completion before the context goes. A job keeps
+// its context alive, so one left queued would run after the swap with
+// VMData's caches already pointing into the fresh context. Throws are
+// dropped (to_rb_value still poisons the VM on OOM); the eval timer bounds
+// a job that keeps queueing more. A shared runtime has one queue, so its
+// siblings' jobs run here too, as they would under drain_jobs!.
+static VALUE reset_drain_body(VALUE p)
+{
+  VMData *data = (VMData *)p;
+  JSRuntime *runtime = JS_GetRuntime(data->context);
+  JSContext *job_ctx;
+  int err;
+  while ((err = JS_ExecutePendingJob(runtime, &job_ctx)) != 0)
+  {
+    if (err < 0)
+    {
+      int state;
+      rb_protect(reset_drain_discard, (VALUE)job_ctx, &state);
+      rb_set_errinfo(Qnil);
+    }
+  }
+  return Qnil;
+}
+
+// Swaps in a fresh JSContext on the same runtime and re-runs the
+// context half of initialize on it. Everything user code created — globals,
+// top-level let/const, mutated builtins, loaded modules — lived on the old
+// context and goes with it. Bundled polyfills come back as lazy stubs, so
+// a reset doesn't pay to run them again; registered polyfills and
+// define_function bridges are replayed from Ruby (VM#reset!).
+// module_loader, on_log, and on_unhandled_rejection live on VMData and are
+// kept as-is.
+static VALUE vm_m_resetContext(VALUE r_self, VALUE r_features)
+{
+  VMData *data;
+  TypedData_Get_Struct(r_self, VMData, &vm_type, data);
+
+  check_disposed(data);
+  // OOM damage is runtime-wide; a new context on the same heap doesn't
+  // undo it.
+  check_oom_poisoned(data);
+  if (data->evals_in_flight > 0)
+    rb_raise(rb_eThreadError, "cannot reset a Quickjs::VM while it is evaluating");
+  if (NIL_P(r_features))
+    r_features = rb_ary_new();
+
+  if (JS_IsJobPending(JS_GetRuntime(data->context)))
+  {
+    arm_eval_timer(data);
+    run_held_js_entry(data, reset_drain_body, (VALUE)data);
+    check_oom_poisoned(data);
+  }
+
+  JSContext *fresh = quickjsrb_new_context(JS_GetRuntime(data->context), data->intrinsics);
+  if (fresh == NULL)
+    rb_raise(rb_eNoMemError, "failed to allocate a QuickJS context");
+  JS_SetContextOpaque(fresh, data);
+
+  JSContext *stale = data->context;
+  vm_release_context_values(data, stale);
+  data->context = fresh;
+  JS_FreeContext(stale);
+
+  rb_hash_clear(data->module_resolution_cache);
+  rb_hash_clear(data->module_source_cache);
+  rb_hash_clear(data->alive_objects);
+
+  vm_setup_context(data, r_features, true);
+  quickjsrb_heap_sync(vm_heap(data));
+
+  return Qnil;
+}
+
+// VM.new(recycle:): replaces the private runtime with a fresh one built
+// from the same options and re-runs the context half of initialize on it,
+// like _reset_context but with a new heap — which is what clears OOM
+// poisoning and the shapes and atoms a long-lived runtime accumulates.
+// The old runtime goes to the reaper (see dispose_later). Returns false,
+// doing nothing, while JS is running on the VM: a bridge re-entering eval
+// mustn't pull the runtime out from under the outer eval, so the rebuild
+// waits for the next boundary.
+static VALUE vm_m_rebuildRuntime(VALUE r_self, VALUE r_features)
+{
+  VMData *data;
+  TypedData_Get_Struct(r_self, VMData, &vm_type, data);
+
+  check_disposed(data);
+  if (data->shared_runtime != NULL)
+    rb_raise(rb_eArgError, "a VM on a shared Quickjs::Runtime can't rebuild its runtime");
+  if (data->evals_in_flight > 0)
+    return Qfalse;
+  if (NIL_P(r_features))
+    r_features = rb_ary_new();
+  quickjsrb_global_await_headroom();
+
+  // Build the replacement first so a failure leaves the VM as it was.
+  QuickjsrbHeap *heap = calloc(1, sizeof(QuickjsrbHeap));
+  if (heap == NULL)
+    rb_raise(rb_eNoMemError, "failed to allocate a QuickJS context");
+  struct vm_create_args args = {NULL, heap, data->intrinsics, NULL};
+  if (data->arena != NULL && (args.arena = quickjsrb_arena_new(heap)) == NULL)
+  {
+    free(heap);
+    rb_raise(rb_eNoMemError, "failed to allocate a QuickJS context");
+  }
+  rb_thread_call_without_gvl(vm_create_no_gvl, &args, NULL, NULL);
+  if (args.context == NULL)
+  {
+    quickjsrb_arena_destroy(args.arena);
+    free(heap);
+    rb_raise(rb_eNoMemError, "failed to allocate a QuickJS context");
+  }
+
+  vm_release_context_values(data, data->context);
+  // Jobs still queued on the old runtime are dropped with it.
+  quickjsrb_heap_forget(data->heap);
+  quickjsrb_reaper_submit(data->context, data->arena, data->arena_fast_teardown, data->heap);
+
+  data->context = args.context;
+  data->arena = args.arena;
+  data->heap = heap;
+  data->oom_poisoned = false;
+  data->eval_time->fired = false;
+  JS_SetContextOpaque(data->context, data);
+  vm_setup_private_runtime(data);
+
+  rb_hash_clear(data->module_resolution_cache);
+  rb_hash_clear(data->module_source_cache);
+  rb_hash_clear(data->alive_objects);
+
+  vm_setup_context(data, r_features, data->lazy_polyfills);
+  quickjsrb_heap_sync(vm_heap(data));
+
+  return Qtrue;
+}
+
+// Times the block as one init_profile phase; registered polyfills are
+// applied from Ruby (Quickjs._apply_registered_polyfills).
+static VALUE vm_m_initPhase(VALUE r_self, VALUE r_phase)
+{
+  VMData *data;
+  TypedData_Get_Struct(r_self, VMData, &vm_type, data);
+  check_disposed(data);
+
+  InitPhase phase;
+  init_phase_begin(data, vm_heap(data), &phase);
+  VALUE r_result = rb_yield(Qnil);
+  init_phase_end(data, &phase, r_phase);
+  return r_result;
+}
+
+static VALUE vm_m_initProfile(VALUE r_self)
+{
+  VMData *data;
+  TypedData_Get_Struct(r_self, VMData, &vm_type, data);
+  return data->init_profile;
+}
+
+static VALUE vm_m_runtime(VALUE r_self)
+{
+  VMData *data;
+  TypedData_Get_Struct(r_self, VMData, &vm_type, data);
+  return data->r_runtime;
+}
+
 static VALUE vm_m_disposed(VALUE r_self)
 {
   VMData *data;
@@ -9,6 +9,9 @@
 #include "quickjs-libc.h"
 #include "cutils.h"
 
+#include "quickjsrb_arena.h"
+
+#include <math.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
@@ -44,11 +47,119 @@ typedef struct EvalTime
 {
   int64_t limit_ms;
   struct timespec started_at;
+  // Latched by the interrupt handler when it stops an eval, so callers can
+  // tell a VM left mid-eval even if the InterruptedError was rescued
+  // (VM#interrupted?). Cleared only when the runtime is rebuilt.
+  bool fired;
 } EvalTime;
 
+// A JSRuntime hosting the contexts of several VMs (Quickjs::Runtime).
+// Lives in its own malloc'd block rather than the Runtime wrapper's
+// TypedData struct because it must outlive whichever of the wrapper and
+// its contexts Ruby's GC happens to free first: the wrapper and every
+// context each hold one reference, and the last release frees the
+// JSRuntime. All fields are only touched with the GVL held — contexts on
+// a shared runtime never release it (see can_eval_gvl_free) — so plain
+// ints are race-free.
+typedef struct QuickjsrbRuntime
+{
+  JSRuntime *runtime;
+  int refcount;
+  // Nesting depth of JS executions across all contexts of this runtime,
+  // and the Ruby thread that owns them. QuickJS keeps the current stack
+  // frame and stack limit per runtime, so a second thread entering JS on
+  // a sibling context while the first is parked in a bridge callback
+  // (which yields the GVL) would splice its frames into the first one's
+  // chain. quickjsrb_runtime_enter refuses that with ThreadError; the
+  // owning thread may nest freely (a bridge evaluating on a sibling).
+  int active_depth;
+  VALUE active_thread;
+  // EvalTime last installed as the interrupt handler's opaque, so a
+  // context freed while its timer is still installed can uninstall it
+  // without clobbering a sibling's armed timer.
+  void *interrupt_opaque;
+  // Strong refs to live contexts (VM => true), marked by the wrapper.
+  // QuickJS jobs and timers keep a JSContext alive past JS_FreeContext and
+  // later run against its opaque VMData, so a context stays pinned here —
+  // moved to `retired` on dispose! while jobs are still queued — instead
+  // of letting Ruby free the VMData under a pending job.
+  VALUE contexts;
+  VALUE retired;
+  // Kept current by the runtime's allocator; see quickjsrb_heap.h.
+  QuickjsrbHeap heap;
+} QuickjsrbRuntime;
+
+void quickjsrb_runtime_release(QuickjsrbRuntime *shared);
+
+// VM.new(intrinsics:). Base objects, eval and Promise aren't optional —
+// the binding itself evaluates code and runs async module and polyfill
+// loads — so only the rest get a bit.
+enum
+{
+  QUICKJSRB_INTRINSIC_DATE = 1 << 0,
+  QUICKJSRB_INTRINSIC_STRING_NORMALIZE = 1 << 1,
+  QUICKJSRB_INTRINSIC_REGEXP = 1 << 2,
+  QUICKJSRB_INTRINSIC_JSON = 1 << 3,
+  QUICKJSRB_INTRINSIC_PROXY = 1 << 4,
+  QUICKJSRB_INTRINSIC_MAP_SET = 1 << 5,
+  QUICKJSRB_INTRINSIC_TYPED_ARRAYS = 1 << 6,
+  QUICKJSRB_INTRINSIC_WEAK_REF = 1 << 7,
+};
+#define QUICKJSRB_INTRINSICS_ALL 0xffu
+
+// JS_NewContext when every intrinsic is wanted; otherwise the same
+// sequence of JS_AddIntrinsic* calls, in the same order, minus the ones
+// left out. Pure QuickJS work, fine without the GVL.
+static inline JSContext *quickjsrb_new_context(JSRuntime *runtime, unsigned int intrinsics)
+{
+  if (intrinsics == QUICKJSRB_INTRINSICS_ALL)
+    return JS_NewContext(runtime);
+
+  JSContext *ctx = JS_NewContextRaw(runtime);
+  if (ctx == NULL)
+    return NULL;
+  JS_AddIntrinsicBaseObjects(ctx);
+  if (intrinsics & QUICKJSRB_INTRINSIC_DATE)
+    JS_AddIntrinsicDate(ctx);
+  JS_AddIntrinsicEval(ctx);
+  if (intrinsics & QUICKJSRB_INTRINSIC_STRING_NORMALIZE)
+    JS_AddIntrinsicStringNormalize(ctx);
+  if (intrinsics & QUICKJSRB_INTRINSIC_REGEXP)
+    JS_AddIntrinsicRegExp(ctx);
+  if (intrinsics & QUICKJSRB_INTRINSIC_JSON)
+    JS_AddIntrinsicJSON(ctx);
+  if (intrinsics & QUICKJSRB_INTRINSIC_PROXY)
+    JS_AddIntrinsicProxy(ctx);
+  if (intrinsics & QUICKJSRB_INTRINSIC_MAP_SET)
+    JS_AddIntrinsicMapSet(ctx);
+  if (intrinsics & QUICKJSRB_INTRINSIC_TYPED_ARRAYS)
+    JS_AddIntrinsicTypedArrays(ctx);
+  JS_AddIntrinsicPromise(ctx);
+  if (intrinsics & QUICKJSRB_INTRINSIC_WEAK_REF)
+    JS_AddIntrinsicWeakRef(ctx);
+  return ctx;
+}
+
 typedef struct VMData
 {
+  // NULL until VM#initialize creates it: whether the context gets a
+  // private JSRuntime or joins a Quickjs::Runtime is an initialize option.
   struct JSContext *context;
+  // Non-NULL when the context lives on a Quickjs::Runtime shared with
+  // other VMs; r_runtime is the Ruby wrapper (Qnil otherwise).
+  QuickjsrbRuntime *shared_runtime;
+  VALUE r_runtime;
+  // allocator: :arena. The private runtime's whole heap lives in this
+  // arena; arena_fast_teardown means no finalizer on it owns anything
+  // outside (no std/os FILEs or timers), so teardown can unmap the arena
+  // without running JS_FreeRuntime's per-object walk.
+  QuickjsrbArena *arena;
+  bool arena_fast_teardown;
+  // Byte gauge for the private runtime (unused on a shared one, whose
+  // QuickjsrbRuntime carries it); read through vm_heap. Allocated apart
+  // from VMData because the runtime's allocator writes to it until the
+  // runtime is gone, which with VM#dispose_later can be after the VM is.
+  QuickjsrbHeap *heap;
   VALUE defined_functions;
   struct EvalTime *eval_time;
   VALUE log_listener;
@@ -65,6 +176,57 @@ typedef struct VMData
   // loader returns either a raw source String or `{ code:, as: }`.
   VALUE module_source_cache;
   JSValue j_file_proxy_creator;
+  // Builtins captured once per context (vm_setup_context) so converters
+  // don't fetch them from the global object by name per value. Owned
+  // references; vm_release_context_values frees them with the context.
+  JSValue j_object_prototype;
+  JSValue j_number_ctor;
+  JSValue j_uint8array_ctor;
+  // ArrayBuffer.prototype and %TypedArray%.prototype (Uint8Array.prototype's
+  // parent), for recognising binary results by their prototype chain.
+  // JS_UNDEFINED without the typed array intrinsics.
+  JSValue j_arraybuffer_prototype;
+  JSValue j_typedarray_prototype;
+  // Quickjs::Float64Array / Int32Array's counterparts (quickjsrb_typed_array.c).
+  JSValue j_float64array_ctor;
+  JSValue j_int32array_ctor;
+  JSValue j_float64array_prototype;
+  JSValue j_int32array_prototype;
+  // Date, Map and Set become Time, Hash and Set; JS_UNDEFINED when left
+  // out by `intrinsics:`. Map and Set entries are read through Array.from.
+  JSValue j_date_prototype;
+  JSValue j_date_get_time;
+  JSValue j_map_prototype;
+  JSValue j_set_prototype;
+  JSValue j_array_from;
+  // Prototype of the JS objects Array-backed Quickjs::Refs appear as.
+  JSValue j_array_prototype;
+  // POLYFILL_FILE's File and Blob. Fetched on first use instead, since
+  // reading them can trigger a lazy polyfill load; JS_UNDEFINED when the
+  // feature is off or its lazy stubs haven't fired. See
+  // quickjsrb_file_ctors.
+  JSValue j_file_ctor;
+  JSValue j_blob_ctor;
+  bool file_ctors_cached;
+  // Live Quickjs::ObjectRef handles on this context (see
+  // quickjsrb_object_ref.c), and values whose handle was collected while
+  // JS ran with the GVL released, freed once it's back.
+  struct QuickjsrbObjectRef *object_refs;
+  JSValue *ref_graveyard;
+  size_t ref_graveyard_len;
+  size_t ref_graveyard_cap;
+  // Ruby objects JS can reach through a Quickjs::Ref (quickjsrb_ref.c),
+  // marked with the VM. ref_pins_dead: some were let go by JS while it ran
+  // with the GVL released; quickjsrb_refs_sweep unlinks them.
+  struct QuickjsrbRefPin *ref_pins;
+  bool ref_pins_dead;
+  // Hash keys headed into JS, as atoms on this context: Symbol keys by ID,
+  // frozen String keys by content (see rb_hash_key_atom). Each entry holds
+  // a reference on its atom until vm_release_context_values; NULL until
+  // the first key of that kind.
+  st_table *sym_atoms;
+  st_table *str_atoms;
+  size_t cached_atoms;
   // Once the runtime has hit JS-level "out of memory", the QuickJS heap is in
   // a fragile state where further evaluation can trigger a use-after-free in
   // the parser-error-during-OOM cascade (segfault inside js_shape_hash_unlink).
@@ -75,6 +237,21 @@ typedef struct VMData
   // enough pressure to collect the wrapper. Doubles as a double-free guard
   // for the dfree handler.
   bool disposed;
+  // VM.new(lazy_polyfills: true): bytecode polyfills are installed as
+  // getter stubs that load on first touch. Kept for recycle: rebuilds;
+  // VM#reset! installs stubs either way.
+  bool lazy_polyfills;
+  // QUICKJSRB_INTRINSIC_* the context was built with; VM#reset! builds
+  // its fresh context the same way.
+  unsigned int intrinsics;
+  // A private runtime's limits, kept so VM.new(recycle:) can build its
+  // replacement the same way.
+  size_t memory_limit;
+  size_t max_stack_size;
+  // VM.new(profile_init: true): one Hash per construction phase, appended
+  // while the Array is unfrozen. PolyfillLoader freezes it once the
+  // registered polyfills are in, which ends recording. Qnil otherwise.
+  VALUE init_profile;
   // Set while JS is executing with the GVL released so JS→Ruby bridges
   // (currently js_quickjsrb_log) can re-acquire the GVL before touching
   // Ruby APIs. Covers both vm_m_evalCode and vm_m_loadPolyfillBytecode;
@@ -129,39 +306,210 @@ static inline JSValue quickjsrb_new_ruby_bridge(JSContext *ctx, JSCFunction *fun
   return JS_NewCFunction(ctx, func, name, length);
 }
 
-static void vm_teardown_context(JSContext *ctx)
+static inline QuickjsrbHeap *vm_heap(VMData *data)
+{
+  return data->shared_runtime != NULL ? &data->shared_runtime->heap : data->heap;
+}
+
+// Converts a JS value to Ruby (raising for an exception value); doesn't
+// free j_val.
+VALUE to_rb_value(JSContext *ctx, JSValue j_val);
+// Converts a Ruby value to a new JS value.
+JSValue to_js_value(JSContext *ctx, VALUE r_value);
+// A JS Error standing for r_error, which is kept alive so it re-raises
+// as itself when the error reaches Ruby again.
+JSValue j_error_from_ruby_error(JSContext *ctx, VALUE r_error);
+
+// The kinds of object to_rb_value_inner converts natively, told apart by
+// the builtin prototype on their chain (js_object_kind in quickjsrb.c).
+typedef enum
+{
+  QUICKJSRB_OBJECT_OTHER,
+  QUICKJSRB_OBJECT_PLAIN,
+  QUICKJSRB_OBJECT_ARRAY_BUFFER,
+  QUICKJSRB_OBJECT_TYPED_ARRAY,
+  QUICKJSRB_OBJECT_FLOAT64_ARRAY,
+  QUICKJSRB_OBJECT_INT32_ARRAY,
+  QUICKJSRB_OBJECT_DATE,
+  QUICKJSRB_OBJECT_MAP,
+  QUICKJSRB_OBJECT_SET,
+} QuickjsrbObjectKind;
+
+static inline bool quickjsrb_object_kind_typed_array_p(QuickjsrbObjectKind kind)
 {
+  return kind == QUICKJSRB_OBJECT_TYPED_ARRAY || kind == QUICKJSRB_OBJECT_FLOAT64_ARRAY ||
+         kind == QUICKJSRB_OBJECT_INT32_ARRAY;
+}
+
+// Copies the bytes of a JS ArrayBuffer or TypedArray (its own window of
+// the buffer) into an ASCII-8BIT String; empty once detached. Qnil for
+// anything else.
+VALUE quickjsrb_js_buffer_to_rb_str(JSContext *ctx, JSValueConst j_val);
+
+// Passes whatever the heap grew or shrank by since the last call on to
+// Ruby's GC, so a VM holding a large JS heap counts as malloc pressure and
+// gets its wrapper collected (and the heap freed) at a sensible pace.
+// Needs the GVL; call it where JS has just returned control to Ruby.
+static inline void quickjsrb_heap_sync(QuickjsrbHeap *heap)
+{
+  ssize_t diff = (ssize_t)heap->bytes - (ssize_t)heap->reported;
+  if (diff == 0)
+    return;
+  heap->reported = heap->bytes;
+  rb_gc_adjust_memory_usage(diff);
+}
+
+// Blocks VM construction (GVL released between polls) until the global
+// memory limit leaves room for a new runtime, up to
+// Quickjs.global_memory_wait seconds; then raises Quickjs::RuntimeError.
+// Returns at once when no limit is set.
+void quickjsrb_global_await_headroom(void);
+void quickjsrb_init_heap(VALUE r_module);
+
+// Withdraws everything reported for a heap that has just been freed.
+// Also needs the GVL, so it stays out of vm_teardown_context (which
+// dispose! runs without it).
+static inline void quickjsrb_heap_forget(QuickjsrbHeap *heap)
+{
+  if (heap->reported > 0)
+    rb_gc_adjust_memory_usage(-(ssize_t)heap->reported);
+  heap->bytes = 0;
+  heap->reported = 0;
+}
+
+// Frees a VM's private runtime, context and arena. Touches nothing of
+// Ruby's, so dispose! and the dispose_later reaper run it without the GVL.
+static inline void quickjsrb_free_private_runtime(JSContext *ctx, QuickjsrbArena *arena, bool arena_fast_teardown)
+{
+  if (arena != NULL && arena_fast_teardown)
+  {
+    quickjsrb_arena_destroy(arena);
+    return;
+  }
+
   JSRuntime *runtime = JS_GetRuntime(ctx);
   JS_SetInterruptHandler(runtime, NULL, NULL);
   js_std_free_handlers(runtime);
   JS_FreeContext(ctx);
   JS_FreeRuntime(runtime);
+  quickjsrb_arena_destroy(arena);
+}
+
+// Frees the JSValues Quickjs::ObjectRef handles hold on `ctx`; the handles
+// stay, reporting their VM gone.
+void quickjsrb_object_refs_release(VMData *data, JSContext *ctx);
+// Frees the values of handles collected while JS ran with the GVL
+// released. Call with the GVL held and no such region open.
+void quickjsrb_object_refs_drain(VMData *data);
+
+// Quickjs::Ref pins. Mark runs from the VM's own hook and pins what it
+// marks, since Refs cache children by address; sweep unlinks pins dropped
+// while the GVL was released (call with it held); release detaches the
+// rest from a context being freed or swapped out.
+void quickjsrb_refs_mark(VMData *data);
+void quickjsrb_refs_sweep(VMData *data);
+void quickjsrb_refs_release(VMData *data);
+
+static int vm_free_cached_atom(st_data_t key, st_data_t atom, st_data_t ctx)
+{
+  JS_FreeAtom((JSContext *)ctx, (JSAtom)atom);
+  return ST_CONTINUE;
+}
+
+static int vm_free_cached_str_atom(st_data_t key, st_data_t atom, st_data_t ctx)
+{
+  free((char *)key);
+  return vm_free_cached_atom(key, atom, ctx);
+}
+
+// Frees the JSValues VMData holds on `ctx` — the file proxy factory, the
+// intrinsic cache, ObjectRef handles and cached key atoms — and detaches
+// Quickjs::Ref pins. Call before that context is freed or swapped out.
+static inline void vm_release_context_values(VMData *data, JSContext *ctx)
+{
+  quickjsrb_object_refs_release(data, ctx);
+  quickjsrb_refs_release(data);
+  if (data->sym_atoms != NULL)
+  {
+    st_foreach(data->sym_atoms, vm_free_cached_atom, (st_data_t)ctx);
+    st_free_table(data->sym_atoms);
+    data->sym_atoms = NULL;
+  }
+  if (data->str_atoms != NULL)
+  {
+    st_foreach(data->str_atoms, vm_free_cached_str_atom, (st_data_t)ctx);
+    st_free_table(data->str_atoms);
+    data->str_atoms = NULL;
+  }
+  data->cached_atoms = 0;
+  JSValue *values[] = {&data->j_file_proxy_creator, &data->j_object_prototype, &data->j_number_ctor,
+                       &data->j_uint8array_ctor, &data->j_arraybuffer_prototype, &data->j_typedarray_prototype,
+                       &data->j_float64array_ctor, &data->j_int32array_ctor, &data->j_float64array_prototype,
+                       &data->j_int32array_prototype, &data->j_date_prototype,
+                       &data->j_date_get_time, &data->j_map_prototype, &data->j_set_prototype, &data->j_array_from,
+                       &data->j_array_prototype,
+                       &data->j_file_ctor, &data->j_blob_ctor};
+  for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+  {
+    JS_FreeValue(ctx, *values[i]);
+    *values[i] = JS_UNDEFINED;
+  }
+  data->file_ctors_cached = false;
+}
+
+static void vm_teardown_context(VMData *data)
+{
+  JSContext *ctx = data->context;
+  QuickjsrbRuntime *shared = data->shared_runtime;
+  if (shared != NULL)
+  {
+    // Siblings keep using the runtime: free only this context, and
+    // uninstall the interrupt handler only if it's still this VM's timer.
+    if (shared->interrupt_opaque == data->eval_time)
+    {
+      JS_SetInterruptHandler(shared->runtime, NULL, NULL);
+      shared->interrupt_opaque = NULL;
+    }
+    JS_FreeContext(ctx);
+    quickjsrb_runtime_release(shared);
+    return;
+  }
+
+  quickjsrb_free_private_runtime(ctx, data->arena, data->arena_fast_teardown);
+  data->arena = NULL;
 }
 
 static void vm_free(void *ptr)
 {
   VMData *data = (VMData *)ptr;
-  free(data->eval_time);
 
-  if (!data->disposed)
+  if (!data->disposed && data->context != NULL)
   {
-    if (!JS_IsUndefined(data->j_file_proxy_creator))
-      JS_FreeValue(data->context, data->j_file_proxy_creator);
-
-    vm_teardown_context(data->context);
+    vm_release_context_values(data, data->context);
+    vm_teardown_context(data);
+    quickjsrb_heap_forget(data->heap);
   }
 
+  free(data->heap);
+  free(data->eval_time);
+  free(data->ref_graveyard);
   xfree(ptr);
 }
 
-static size_t vm_size(const void *data)
+// A shared runtime's heap is reported by the Quickjs::Runtime wrapper
+// instead, so ObjectSpace.memsize_of doesn't count it once per context.
+static size_t vm_size(const void *ptr)
 {
-  return sizeof(VMData);
+  const VMData *data = ptr;
+  if (data->disposed || data->context == NULL || data->shared_runtime != NULL)
+    return sizeof(VMData);
+  return sizeof(VMData) + data->heap->bytes;
 }
 
 static void vm_mark(void *ptr)
 {
   VMData *data = (VMData *)ptr;
+  rb_gc_mark_movable(data->r_runtime);
   rb_gc_mark_movable(data->defined_functions);
   rb_gc_mark_movable(data->log_listener);
   rb_gc_mark_movable(data->alive_objects);
@@ -169,11 +517,14 @@ static void vm_mark(void *ptr)
   rb_gc_mark_movable(data->on_unhandled_rejection);
   rb_gc_mark_movable(data->module_resolution_cache);
   rb_gc_mark_movable(data->module_source_cache);
+  rb_gc_mark_movable(data->init_profile);
+  quickjsrb_refs_mark(data);
 }
 
 static void vm_compact(void *ptr)
 {
   VMData *data = (VMData *)ptr;
+  data->r_runtime = rb_gc_location(data->r_runtime);
   data->defined_functions = rb_gc_location(data->defined_functions);
   data->log_listener = rb_gc_location(data->log_listener);
   data->alive_objects = rb_gc_location(data->alive_objects);
@@ -181,6 +532,7 @@ static void vm_compact(void *ptr)
   data->on_unhandled_rejection = rb_gc_location(data->on_unhandled_rejection);
   data->module_resolution_cache = rb_gc_location(data->module_resolution_cache);
   data->module_source_cache = rb_gc_location(data->module_source_cache);
+  data->init_profile = rb_gc_location(data->init_profile);
 }
 
 static const rb_data_type_t vm_type = {
@@ -196,13 +548,24 @@ static const rb_data_type_t vm_type = {
 
 struct vm_create_args
 {
+  QuickjsrbArena *arena;
+  QuickjsrbHeap *heap;
+  unsigned int intrinsics;
   JSContext *context;
 };
 
 static void *vm_create_no_gvl(void *p)
 {
   struct vm_create_args *args = p;
-  args->context = JS_NewContext(JS_NewRuntime());
+  JSRuntime *runtime = args->arena != NULL
+                           ? JS_NewRuntime2(&quickjsrb_arena_malloc_functions, args->arena)
+                           : JS_NewRuntime2(&quickjsrb_tracked_malloc_functions, args->heap);
+  if (runtime == NULL)
+    return NULL;
+  args->heap->runtime = runtime;
+  args->context = quickjsrb_new_context(runtime, args->intrinsics);
+  if (args->context == NULL)
+    JS_FreeRuntime(runtime);
   return NULL;
 }
 
@@ -210,6 +573,12 @@ static VALUE vm_alloc(VALUE r_self)
 {
   VMData *data;
   VALUE obj = TypedData_Make_Struct(r_self, VMData, &vm_type, data);
+  data->context = NULL;
+  data->shared_runtime = NULL;
+  data->r_runtime = Qnil;
+  data->arena = NULL;
+  data->arena_fast_teardown = false;
+  data->init_profile = Qnil;
   data->defined_functions = rb_hash_new();
   data->log_listener = Qnil;
   data->alive_objects = rb_hash_new();
@@ -218,22 +587,46 @@ static VALUE vm_alloc(VALUE r_self)
   data->module_resolution_cache = rb_hash_new();
   data->module_source_cache = rb_hash_new();
   data->j_file_proxy_creator = JS_UNDEFINED;
+  data->j_object_prototype = JS_UNDEFINED;
+  data->j_number_ctor = JS_UNDEFINED;
+  data->j_uint8array_ctor = JS_UNDEFINED;
+  data->j_arraybuffer_prototype = JS_UNDEFINED;
+  data->j_typedarray_prototype = JS_UNDEFINED;
+  data->j_float64array_ctor = JS_UNDEFINED;
+  data->j_int32array_ctor = JS_UNDEFINED;
+  data->j_float64array_prototype = JS_UNDEFINED;
+  data->j_int32array_prototype = JS_UNDEFINED;
+  data->j_date_prototype = JS_UNDEFINED;
+  data->j_date_get_time = JS_UNDEFINED;
+  data->j_map_prototype = JS_UNDEFINED;
+  data->j_set_prototype = JS_UNDEFINED;
+  data->j_array_from = JS_UNDEFINED;
+  data->j_array_prototype = JS_UNDEFINED;
+  data->j_file_ctor = JS_UNDEFINED;
+  data->j_blob_ctor = JS_UNDEFINED;
+  data->file_ctors_cached = false;
+  data->object_refs = NULL;
+  data->ref_graveyard = NULL;
+  data->ref_graveyard_len = 0;
+  data->ref_graveyard_cap = 0;
+  data->ref_pins = NULL;
+  data->ref_pins_dead = false;
+  data->sym_atoms = NULL;
+  data->str_atoms = NULL;
+  data->cached_atoms = 0;
   data->oom_poisoned = false;
   data->disposed = false;
+  data->lazy_polyfills = false;
+  data->intrinsics = QUICKJSRB_INTRINSICS_ALL;
   data->gvl_released_js = false;
   data->evals_in_flight = 0;
   data->gvl_release_regions = 0;
   data->has_native_ruby_bridge = false;
 
   EvalTime *eval_time = malloc(sizeof(EvalTime));
+  eval_time->fired = false;
   data->eval_time = eval_time;
-
-  // JSRuntime / JSContext creation is pure QuickJS C work — no Ruby state
-  // touched. Release the GVL so a background warmer thread can run this in
-  // parallel with the main thread on multi-core hosts.
-  struct vm_create_args args = {NULL};
-  rb_thread_call_without_gvl(vm_create_no_gvl, &args, NULL, NULL);
-  data->context = args.context;
+  data->heap = calloc(1, sizeof(QuickjsrbHeap));
 
   return obj;
 }
@@ -271,6 +664,8 @@ static void r_define_constants(VALUE r_parent_class)
   rb_define_const(r_parent_class, "POLYFILL_ENCODING", QUICKJSRB_SYM(featurePolyfillEncodingId));
   rb_define_const(r_parent_class, "POLYFILL_URL", QUICKJSRB_SYM(featurePolyfillUrlId));
   rb_define_const(r_parent_class, "POLYFILL_CRYPTO", QUICKJSRB_SYM(featurePolyfillCryptoId));
+  // Bytecode and VM snapshots are only readable by the QuickJS build that wrote them.
+  rb_define_const(r_parent_class, "QUICKJS_VERSION", rb_obj_freeze(rb_str_new_cstr(CONFIG_VERSION)));
 
   VALUE rb_cQuickjsValue = rb_define_class_under(r_parent_class, "Value", rb_cObject);
   rb_define_const(rb_cQuickjsValue, "UNDEFINED", QUICKJSRB_SYM(undefinedId));
@@ -338,6 +733,7 @@ static VALUE r_log_body_new(VALUE r_raw, VALUE r_c)
 #define QUICKJSRB_ROOT_RUNTIME_ERROR "RuntimeError"
 #define QUICKJSRB_INTERRUPTED_ERROR "InterruptedError"
 #define QUICKJSRB_NO_AWAIT_ERROR "NoAwaitError"
+#define QUICKJSRB_GLOBAL_MEMORY_LIMIT_ERROR "GlobalMemoryLimitError"
 
 #define QUICKJSRB_ERROR_FOR(name) \
   (VALUE) { rb_const_get(rb_const_get(rb_cClass, rb_intern("Quickjs")), rb_intern(name)) }
@@ -364,6 +760,7 @@ static void r_define_exception_classes(VALUE r_parent_class)
   // quickjsrb specific errors
   rb_define_class_under(r_parent_class, QUICKJSRB_INTERRUPTED_ERROR, r_runtime_error);
   rb_define_class_under(r_parent_class, QUICKJSRB_NO_AWAIT_ERROR, r_runtime_error);
+  rb_define_class_under(r_parent_class, QUICKJSRB_GLOBAL_MEMORY_LIMIT_ERROR, r_runtime_error);
 }
 
 #endif /* QUICKJSRB_H */
@@ -0,0 +1,274 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "quickjsrb_arena.h"
+
+// Blocks up to ARENA_MAX_SMALL bytes are carved from 1MB chunks and
+// recycled through per-size-class free lists; chunks are only returned
+// to the OS when the arena is destroyed, and a freed block only serves
+// its own size class. Anything larger (big strings, array buffers,
+// bytecode) gets a mapping of its own, unmapped as soon as QuickJS frees
+// it. So an arena's footprint is its high-water mark: it suits VMs that
+// are built, used and dropped, not long-lived pooled ones.
+//
+// Quickjs.global_memory_limit is charged per mapping (a chunk when it's
+// mapped, a large block for its mapping's length), since that is what
+// the process holds; freeing a small block gives nothing back to it.
+#define ARENA_CHUNK_SIZE (1024 * 1024)
+#define ARENA_MAX_SMALL (32 * 1024)
+// 16-byte steps up to 256, then four classes per power of two.
+#define ARENA_CLASS_COUNT 44
+#define ARENA_LARGE ((size_t)-1)
+
+// Precedes every pointer handed to QuickJS: js_malloc_usable_size gets
+// nothing but the pointer, so the block has to carry its own size. 16
+// bytes keeps payloads 16-byte aligned, as malloc's are.
+typedef struct ArenaHeader
+{
+  size_t usable;
+  size_t cls;
+} ArenaHeader;
+
+typedef struct ArenaChunk
+{
+  struct ArenaChunk *next;
+  size_t pad;
+} ArenaChunk;
+
+typedef struct ArenaLarge
+{
+  struct ArenaLarge *prev;
+  struct ArenaLarge *next;
+  size_t map_len;
+  size_t pad;
+} ArenaLarge;
+
+struct QuickjsrbArena
+{
+  QuickjsrbHeap *heap;
+  // Bytes mapped, all charged to Quickjs.global_memory_limit; what
+  // destroying the arena gives back at once.
+  size_t charged;
+  ArenaChunk *chunks;
+  char *bump;
+  char *bump_end;
+  ArenaLarge *large;
+  void *free_lists[ARENA_CLASS_COUNT];
+};
+
+static size_t arena_page_size(void)
+{
+  static size_t page_size = 0;
+  if (page_size == 0)
+    page_size = (size_t)sysconf(_SC_PAGESIZE);
+  return page_size;
+}
+
+static void *arena_map(size_t len)
+{
+  void *p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  return p == MAP_FAILED ? NULL : p;
+}
+
+static size_t arena_class_for(size_t size)
+{
+  if (size <= 256)
+    return size == 0 ? 0 : (size + 15) / 16 - 1;
+
+  size_t n = size - 1;
+  int p = (int)(sizeof(unsigned long) * 8 - 1) - __builtin_clzl((unsigned long)n);
+  return 16 + (size_t)(p - 8) * 4 + ((n >> (p - 2)) & 3);
+}
+
+static size_t arena_class_size(size_t cls)
+{
+  if (cls < 16)
+    return (cls + 1) * 16;
+
+  size_t k = cls - 16;
+  int p = 8 + (int)(k / 4);
+  return ((size_t)1 << p) + ((k % 4) + 1) * ((size_t)1 << (p - 2));
+}
+
+static ArenaHeader *arena_small_block(QuickjsrbArena *arena, size_t cls)
+{
+  void *head = arena->free_lists[cls];
+  if (head != NULL)
+  {
+    arena->free_lists[cls] = *(void **)head;
+    return (ArenaHeader *)head - 1;
+  }
+
+  size_t need = sizeof(ArenaHeader) + arena_class_size(cls);
+  if (arena->bump == NULL || (size_t)(arena->bump_end - arena->bump) < need)
+  {
+    // The old chunk's tail (under ARENA_MAX_SMALL bytes) is left unused.
+    if (!quickjsrb_global_reserve(arena->heap, ARENA_CHUNK_SIZE))
+      return NULL;
+    ArenaChunk *chunk = arena_map(ARENA_CHUNK_SIZE);
+    if (chunk == NULL)
+    {
+      quickjsrb_global_release(ARENA_CHUNK_SIZE);
+      return NULL;
+    }
+    arena->charged += ARENA_CHUNK_SIZE;
+    chunk->next = arena->chunks;
+    arena->chunks = chunk;
+    arena->bump = (char *)(chunk + 1);
+    arena->bump_end = (char *)chunk + ARENA_CHUNK_SIZE;
+  }
+
+  ArenaHeader *header = (ArenaHeader *)arena->bump;
+  arena->bump += need;
+  header->usable = arena_class_size(cls);
+  header->cls = cls;
+  return header;
+}
+
+static ArenaHeader *arena_large_block(QuickjsrbArena *arena, size_t size)
+{
+  size_t page_size = arena_page_size();
+  size_t map_len = (sizeof(ArenaLarge) + sizeof(ArenaHeader) + size + page_size - 1) & ~(page_size - 1);
+  if (!quickjsrb_global_reserve(arena->heap, map_len))
+    return NULL;
+  ArenaLarge *large = arena_map(map_len);
+  if (large == NULL)
+  {
+    quickjsrb_global_release(map_len);
+    return NULL;
+  }
+  arena->charged += map_len;
+
+  large->prev = NULL;
+  large->next = arena->large;
+  large->map_len = map_len;
+  if (arena->large != NULL)
+    arena->large->prev = large;
+  arena->large = large;
+
+  ArenaHeader *header = (ArenaHeader *)(large + 1);
+  header->usable = map_len - sizeof(ArenaLarge) - sizeof(ArenaHeader);
+  header->cls = ARENA_LARGE;
+  return header;
+}
+
+// QuickJS leaves malloc_count / malloc_size bookkeeping and malloc_limit
+// enforcement (JS_SetMemoryLimit) to the allocator; this mirrors its
+// default js_def_malloc.
+static void *arena_malloc(JSMallocState *s, size_t size)
+{
+  QuickjsrbArena *arena = s->opaque;
+  size_t footprint = size <= ARENA_MAX_SMALL ? arena_class_size(arena_class_for(size)) : size;
+  if (s->malloc_size + footprint + sizeof(ArenaHeader) > s->malloc_limit)
+    return quickjsrb_local_refusal(arena->heap);
+
+  ArenaHeader *header = size <= ARENA_MAX_SMALL ? arena_small_block(arena, arena_class_for(size)) : arena_large_block(arena, size);
+  if (header == NULL)
+    return NULL;
+
+  s->malloc_count++;
+  s->malloc_size += header->usable + sizeof(ArenaHeader);
+  arena->heap->bytes = s->malloc_size;
+  arena->heap->allocations++;
+  return header + 1;
+}
+
+static void arena_free(JSMallocState *s, void *ptr)
+{
+  if (ptr == NULL)
+    return;
+
+  QuickjsrbArena *arena = s->opaque;
+  ArenaHeader *header = (ArenaHeader *)ptr - 1;
+  s->malloc_count--;
+  s->malloc_size -= header->usable + sizeof(ArenaHeader);
+  arena->heap->bytes = s->malloc_size;
+
+  if (header->cls == ARENA_LARGE)
+  {
+    ArenaLarge *large = (ArenaLarge *)header - 1;
+    arena->charged -= large->map_len;
+    quickjsrb_global_release(large->map_len);
+    if (large->prev != NULL)
+      large->prev->next = large->next;
+    else
+      arena->large = large->next;
+    if (large->next != NULL)
+      large->next->prev = large->prev;
+    munmap(large, large->map_len);
+    return;
+  }
+
+  *(void **)ptr = arena->free_lists[header->cls];
+  arena->free_lists[header->cls] = ptr;
+}
+
+static void *arena_realloc(JSMallocState *s, void *ptr, size_t size)
+{
+  if (ptr == NULL)
+    return size == 0 ? NULL : arena_malloc(s, size);
+  if (size == 0)
+  {
+    arena_free(s, ptr);
+    return NULL;
+  }
+
+  ArenaHeader *header = (ArenaHeader *)ptr - 1;
+  if (size <= header->usable)
+    return ptr;
+
+  void *grown = arena_malloc(s, size);
+  if (grown == NULL)
+    return NULL;
+  memcpy(grown, ptr, header->usable);
+  arena_free(s, ptr);
+  return grown;
+}
+
+static size_t arena_malloc_usable_size(const void *ptr)
+{
+  return ptr == NULL ? 0 : ((const ArenaHeader *)ptr - 1)->usable;
+}
+
+const JSMallocFunctions quickjsrb_arena_malloc_functions = {
+    arena_malloc,
+    arena_free,
+    arena_realloc,
+    arena_malloc_usable_size,
+};
+
+QuickjsrbArena *quickjsrb_arena_new(QuickjsrbHeap *heap)
+{
+  QuickjsrbArena *arena = calloc(1, sizeof(QuickjsrbArena));
+  if (arena != NULL)
+    arena->heap = heap;
+  return arena;
+}
+
+void quickjsrb_arena_destroy(QuickjsrbArena *arena)
+{
+  if (arena == NULL)
+    return;
+
+  quickjsrb_global_release(arena->charged);
+  ArenaChunk *chunk = arena->chunks;
+  while (chunk != NULL)
+  {
+    ArenaChunk *next = chunk->next;
+    munmap(chunk, ARENA_CHUNK_SIZE);
+    chunk = next;
+  }
+
+  ArenaLarge *large = arena->large;
+  while (large != NULL)
+  {
+    ArenaLarge *next = large->next;
+    munmap(large, large->map_len);
+    large = next;
+  }
+
+  free(arena);
+}
@@ -0,0 +1,27 @@
+#ifndef QUICKJSRB_ARENA_H
+#define QUICKJSRB_ARENA_H 1
+
+#include "quickjs.h"
+#include "quickjsrb_heap.h"
+
+// Region allocator behind VM.new(allocator: :arena). A runtime created
+// with JS_NewRuntime2(&quickjsrb_arena_malloc_functions, arena) takes
+// every allocation from mmap'd chunks owned by the arena, so the whole
+// heap can be handed back to the OS with a few munmap calls instead of
+// one free() per object. Small-block chunks stay mapped until then, so
+// it's meant for short-lived VMs. Not thread-safe; like the runtime it
+// backs, an arena is used by one thread at a time.
+typedef struct QuickjsrbArena QuickjsrbArena;
+
+extern const JSMallocFunctions quickjsrb_arena_malloc_functions;
+
+// NULL when out of memory. The arena keeps heap->bytes current.
+QuickjsrbArena *quickjsrb_arena_new(QuickjsrbHeap *heap);
+
+// Unmaps every chunk and large block without visiting what's in them.
+// Only call once nothing will touch the runtime's memory again — either
+// after JS_FreeRuntime, or instead of it when no finalizer holds a
+// resource outside the arena.
+void quickjsrb_arena_destroy(QuickjsrbArena *arena);
+
+#endif /* QUICKJSRB_ARENA_H */
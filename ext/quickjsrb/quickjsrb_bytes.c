@@ -0,0 +1,138 @@
+#include <pthread.h>
+
+#include "quickjsrb.h"
+#include "quickjsrb_bytes.h"
+
+VALUE quickjsrb_class_bytes = Qnil;
+
+// One per ArrayBuffer handed to JS. QuickJS's free callback unlinks it,
+// possibly on a thread running JS without the GVL, hence the lock instead
+// of a Ruby Hash.
+typedef struct BytesPin
+{
+  VALUE r_str;
+  struct BytesPin *prev;
+  struct BytesPin *next;
+} BytesPin;
+
+static pthread_mutex_t pins_lock = PTHREAD_MUTEX_INITIALIZER;
+static BytesPin *pins = NULL;
+static ID id_buffer;
+
+// rb_gc_mark, not rb_gc_mark_movable: JS holds RSTRING_PTR, so the String
+// mustn't move even when its bytes are embedded in the object slot.
+static void pins_mark(void *ptr)
+{
+  pthread_mutex_lock(&pins_lock);
+  for (BytesPin *pin = pins; pin != NULL; pin = pin->next)
+    rb_gc_mark(pin->r_str);
+  pthread_mutex_unlock(&pins_lock);
+}
+
+static const rb_data_type_t pins_type = {
+    "quickjsrb_bytes_pins",
+    {pins_mark, NULL, NULL},
+    0,
+    0,
+    RUBY_TYPED_FREE_IMMEDIATELY,
+};
+
+static void pins_unlink(BytesPin *pin)
+{
+  pthread_mutex_lock(&pins_lock);
+  if (pin->prev != NULL)
+    pin->prev->next = pin->next;
+  else
+    pins = pin->next;
+  if (pin->next != NULL)
+    pin->next->prev = pin->prev;
+  pthread_mutex_unlock(&pins_lock);
+  free(pin);
+}
+
+static void bytes_free_array_buffer(JSRuntime *rt, void *opaque, void *ptr)
+{
+  pins_unlink(opaque);
+}
+
+JSValue quickjsrb_bytes_to_js(JSContext *ctx, VALUE r_bytes)
+{
+  VALUE r_str = rb_ivar_get(r_bytes, id_buffer);
+  if (!RB_TYPE_P(r_str, T_STRING))
+    rb_raise(rb_eTypeError, "uninitialized Quickjs::Bytes");
+
+  // An arena VM's fast teardown skips ArrayBuffer free callbacks, which
+  // would leave this pin, and the String, on the list for good.
+  VMData *data = JS_GetContextOpaque(ctx);
+  if (data != NULL)
+    data->arena_fast_teardown = false;
+
+  BytesPin *pin = malloc(sizeof(BytesPin));
+  if (pin == NULL)
+    return JS_ThrowOutOfMemory(ctx);
+
+  pin->r_str = r_str;
+  pin->prev = NULL;
+  pthread_mutex_lock(&pins_lock);
+  pin->next = pins;
+  if (pins != NULL)
+    pins->prev = pin;
+  pins = pin;
+  pthread_mutex_unlock(&pins_lock);
+
+  JSValue j_buf = JS_NewArrayBuffer(ctx, (uint8_t *)RSTRING_PTR(r_str), (size_t)RSTRING_LEN(r_str),
+                                    bytes_free_array_buffer, pin, false);
+  // QuickJS doesn't call the free callback for a buffer it failed to make.
+  if (JS_IsException(j_buf))
+    pins_unlink(pin);
+  return j_buf;
+}
+
+// JS can write through the ArrayBuffer, so Bytes copies the String once
+// into a buffer of its own: sharing the caller's (as rb_str_new_frozen
+// does) would let JS change their String, or a frozen one. The copy sits
+// in an ivar Ruby code can't name and is never handed out, so nothing
+// resizes it and RSTRING_PTR stays put for as long as JS holds it. Every VM and call the
+// Bytes is passed to aliases that one buffer and sees earlier JS writes.
+static VALUE bytes_m_initialize(VALUE r_self, VALUE r_str)
+{
+  StringValue(r_str);
+  VALUE r_buffer = rb_str_new(RSTRING_PTR(r_str), RSTRING_LEN(r_str));
+  rb_ivar_set(r_self, id_buffer, r_buffer);
+  return r_self;
+}
+
+static VALUE bytes_buffer(VALUE r_self)
+{
+  VALUE r_buffer = rb_ivar_get(r_self, id_buffer);
+  if (!RB_TYPE_P(r_buffer, T_STRING))
+    rb_raise(rb_eTypeError, "uninitialized Quickjs::Bytes");
+  return r_buffer;
+}
+
+// A frozen copy: the buffer itself stays where only JS can write to it.
+static VALUE bytes_m_string(VALUE r_self)
+{
+  VALUE r_buffer = bytes_buffer(r_self);
+  return rb_obj_freeze(rb_str_new(RSTRING_PTR(r_buffer), RSTRING_LEN(r_buffer)));
+}
+
+static VALUE bytes_m_bytesize(VALUE r_self)
+{
+  return LONG2NUM(RSTRING_LEN(bytes_buffer(r_self)));
+}
+
+void quickjsrb_init_bytes(VALUE r_module)
+{
+  // No "@", so it's not an instance variable Ruby code can reach.
+  id_buffer = rb_intern("buffer");
+
+  VALUE r_pins = TypedData_Wrap_Struct(0, &pins_type, &pins);
+  rb_gc_register_mark_object(r_pins);
+
+  quickjsrb_class_bytes = rb_define_class_under(r_module, "Bytes", rb_cObject);
+  rb_gc_register_address(&quickjsrb_class_bytes);
+  rb_define_method(quickjsrb_class_bytes, "initialize", bytes_m_initialize, 1);
+  rb_define_method(quickjsrb_class_bytes, "string", bytes_m_string, 0);
+  rb_define_method(quickjsrb_class_bytes, "bytesize", bytes_m_bytesize, 0);
+}
@@ -0,0 +1,17 @@
+#ifndef QUICKJSRB_BYTES_H
+#define QUICKJSRB_BYTES_H 1
+
+// Included after quickjsrb.h.
+
+// Quickjs::Bytes wraps a frozen String that JS receives as an ArrayBuffer
+// over the String's own memory instead of a copy. The String stays pinned
+// (marked, so compaction can't move it) until QuickJS frees the buffer,
+// which may happen on any thread and without the GVL.
+extern VALUE quickjsrb_class_bytes;
+
+// A new ArrayBuffer aliasing r_bytes' String, or JS_EXCEPTION.
+JSValue quickjsrb_bytes_to_js(JSContext *ctx, VALUE r_bytes);
+
+void quickjsrb_init_bytes(VALUE r_module);
+
+#endif /* QUICKJSRB_BYTES_H */
@@ -13,34 +13,6 @@ static const char *js_get_algorithm_name(JSContext *ctx, JSValueConst j_algo)
   return name;
 }
 
-// Convert a JS ArrayBuffer or TypedArray to a Ruby binary String.
-// Returns Qnil if the value is neither.
-static VALUE js_buffer_to_ruby_str(JSContext *ctx, JSValueConst j_val)
-{
-  size_t byte_offset = 0, byte_length = 0, bytes_per_element = 0;
-  int is_typed_array = 1;
-  JSValue j_buf = JS_GetTypedArrayBuffer(ctx, j_val, &byte_offset, &byte_length, &bytes_per_element);
-  if (JS_IsException(j_buf))
-  {
-    JSValue j_exc = JS_GetException(ctx);
-    JS_FreeValue(ctx, j_exc);
-    is_typed_array = 0;
-    j_buf = JS_DupValue(ctx, j_val);
-  }
-
-  size_t buf_size;
-  uint8_t *buf = JS_GetArrayBuffer(ctx, &buf_size, j_buf);
-  JS_FreeValue(ctx, j_buf);
-
-  if (!buf)
-    return Qnil;
-
-  size_t len = is_typed_array ? byte_length : buf_size;
-  VALUE r_str = rb_str_new((const char *)(buf + byte_offset), len);
-  rb_funcall(r_str, rb_intern("force_encoding"), 1, rb_str_new_cstr("BINARY"));
-  return r_str;
-}
-
 // Build a Ruby Array of strings from a JS array value.
 static VALUE js_usages_to_ruby_array(JSContext *ctx, JSValueConst j_usages)
 {
@@ -148,7 +120,7 @@ static VALUE js_algo_to_ruby_hash(JSContext *ctx, JSValueConst j_algo)
   JSValue j_pub_exp = JS_GetPropertyStr(ctx, j_algo, "publicExponent");
   if (!JS_IsUndefined(j_pub_exp) && !JS_IsException(j_pub_exp))
   {
-    VALUE r_pe = js_buffer_to_ruby_str(ctx, j_pub_exp);
+    VALUE r_pe = quickjsrb_js_buffer_to_rb_str(ctx, j_pub_exp);
     if (!NIL_P(r_pe))
       rb_hash_aset(r_hash, ID2SYM(rb_intern("public_exponent")), r_pe);
   }
@@ -157,7 +129,7 @@ static VALUE js_algo_to_ruby_hash(JSContext *ctx, JSValueConst j_algo)
   JSValue j_iv = JS_GetPropertyStr(ctx, j_algo, "iv");
   if (!JS_IsUndefined(j_iv) && !JS_IsException(j_iv))
   {
-    VALUE r_iv = js_buffer_to_ruby_str(ctx, j_iv);
+    VALUE r_iv = quickjsrb_js_buffer_to_rb_str(ctx, j_iv);
     if (!NIL_P(r_iv))
       rb_hash_aset(r_hash, ID2SYM(rb_intern("iv")), r_iv);
   }
@@ -175,7 +147,7 @@ static VALUE js_algo_to_ruby_hash(JSContext *ctx, JSValueConst j_algo)
   JSValue j_additional_data = JS_GetPropertyStr(ctx, j_algo, "additionalData");
   if (!JS_IsUndefined(j_additional_data) && !JS_IsException(j_additional_data))
   {
-    VALUE r_ad = js_buffer_to_ruby_str(ctx, j_additional_data);
+    VALUE r_ad = quickjsrb_js_buffer_to_rb_str(ctx, j_additional_data);
     if (!NIL_P(r_ad))
       rb_hash_aset(r_hash, ID2SYM(rb_intern("additional_data")), r_ad);
   }
@@ -184,7 +156,7 @@ static VALUE js_algo_to_ruby_hash(JSContext *ctx, JSValueConst j_algo)
   JSValue j_counter = JS_GetPropertyStr(ctx, j_algo, "counter");
   if (!JS_IsUndefined(j_counter) && !JS_IsException(j_counter))
   {
-    VALUE r_counter = js_buffer_to_ruby_str(ctx, j_counter);
+    VALUE r_counter = quickjsrb_js_buffer_to_rb_str(ctx, j_counter);
     if (!NIL_P(r_counter))
       rb_hash_aset(r_hash, ID2SYM(rb_intern("counter")), r_counter);
   }
@@ -193,7 +165,7 @@ static VALUE js_algo_to_ruby_hash(JSContext *ctx, JSValueConst j_algo)
   JSValue j_salt = JS_GetPropertyStr(ctx, j_algo, "salt");
   if (!JS_IsUndefined(j_salt) && !JS_IsException(j_salt))
   {
-    VALUE r_salt = js_buffer_to_ruby_str(ctx, j_salt);
+    VALUE r_salt = quickjsrb_js_buffer_to_rb_str(ctx, j_salt);
     if (!NIL_P(r_salt))
       rb_hash_aset(r_hash, ID2SYM(rb_intern("salt")), r_salt);
   }
@@ -211,7 +183,7 @@ static VALUE js_algo_to_ruby_hash(JSContext *ctx, JSValueConst j_algo)
   JSValue j_info = JS_GetPropertyStr(ctx, j_algo, "info");
   if (!JS_IsUndefined(j_info) && !JS_IsException(j_info))
   {
-    VALUE r_info = js_buffer_to_ruby_str(ctx, j_info);
+    VALUE r_info = quickjsrb_js_buffer_to_rb_str(ctx, j_info);
     if (!NIL_P(r_info))
       rb_hash_aset(r_hash, ID2SYM(rb_intern("info")), r_info);
   }
@@ -229,7 +201,7 @@ static VALUE js_algo_to_ruby_hash(JSContext *ctx, JSValueConst j_algo)
   JSValue j_label = JS_GetPropertyStr(ctx, j_algo, "label");
   if (!JS_IsUndefined(j_label) && !JS_IsException(j_label))
   {
-    VALUE r_label = js_buffer_to_ruby_str(ctx, j_label);
+    VALUE r_label = quickjsrb_js_buffer_to_rb_str(ctx, j_label);
     if (!NIL_P(r_label))
       rb_hash_aset(r_hash, ID2SYM(rb_intern("label")), r_label);
   }
@@ -297,9 +269,8 @@ static JSValue js_crypto_key_to_js(JSContext *ctx, VALUE r_key)
     JSValue j_pe_buf = JS_NewArrayBufferCopy(ctx,
                                              (const uint8_t *)RSTRING_PTR(r_algo_pub_exp),
                                              RSTRING_LEN(r_algo_pub_exp));
-    JSValue j_uint8 = JS_GetPropertyStr(ctx, JS_GetGlobalObject(ctx), "Uint8Array");
-    JSValue j_pe = JS_CallConstructor(ctx, j_uint8, 1, (JSValueConst *)&j_pe_buf);
-    JS_FreeValue(ctx, j_uint8);
+    VMData *data = JS_GetContextOpaque(ctx);
+    JSValue j_pe = JS_CallConstructor(ctx, data->j_uint8array_ctor, 1, (JSValueConst *)&j_pe_buf);
     JS_FreeValue(ctx, j_pe_buf);
     JS_SetPropertyStr(ctx, j_algo, "publicExponent", j_pe);
   }
@@ -341,7 +312,7 @@ static JSValue js_subtle_digest(JSContext *ctx, JSValueConst this_val, int argc,
   VALUE r_algorithm = rb_str_new_cstr(algorithm_name);
   JS_FreeCString(ctx, algorithm_name);
 
-  VALUE r_data = js_buffer_to_ruby_str(ctx, argv[1]);
+  VALUE r_data = quickjsrb_js_buffer_to_rb_str(ctx, argv[1]);
   if (NIL_P(r_data))
     return JS_ThrowTypeError(ctx, "Failed to execute 'digest': data must be an ArrayBuffer or TypedArray.");
 
@@ -452,7 +423,7 @@ static JSValue js_subtle_import_key(JSContext *ctx, JSValueConst this_val, int a
   VALUE r_format = rb_str_new_cstr(format_cstr);
   JS_FreeCString(ctx, format_cstr);
 
-  VALUE r_key_data = js_buffer_to_ruby_str(ctx, argv[1]);
+  VALUE r_key_data = quickjsrb_js_buffer_to_rb_str(ctx, argv[1]);
 
   VALUE r_algo_hash = js_algo_to_ruby_hash(ctx, argv[2]);
   VALUE r_extractable = JS_ToBool(ctx, argv[3]) ? Qtrue : Qfalse;
@@ -570,7 +541,7 @@ static JSValue js_subtle_crypt(JSContext *ctx, JSValueConst this_val, int argc,
   if (NIL_P(r_key))
     return JS_ThrowTypeError(ctx, "invalid CryptoKey.");
 
-  VALUE r_data = js_buffer_to_ruby_str(ctx, argv[2]);
+  VALUE r_data = quickjsrb_js_buffer_to_rb_str(ctx, argv[2]);
   if (NIL_P(r_data))
     return JS_ThrowTypeError(ctx, "data must be an ArrayBuffer or TypedArray.");
 
@@ -636,7 +607,7 @@ static JSValue js_subtle_sign(JSContext *ctx, JSValueConst this_val, int argc, J
   if (NIL_P(r_key))
     return JS_ThrowTypeError(ctx, "Failed to execute 'sign': invalid CryptoKey.");
 
-  VALUE r_data = js_buffer_to_ruby_str(ctx, argv[2]);
+  VALUE r_data = quickjsrb_js_buffer_to_rb_str(ctx, argv[2]);
   if (NIL_P(r_data))
     return JS_ThrowTypeError(ctx, "Failed to execute 'sign': data must be an ArrayBuffer or TypedArray.");
 
@@ -692,11 +663,11 @@ static JSValue js_subtle_verify(JSContext *ctx, JSValueConst this_val, int argc,
   if (NIL_P(r_key))
     return JS_ThrowTypeError(ctx, "Failed to execute 'verify': invalid CryptoKey.");
 
-  VALUE r_signature = js_buffer_to_ruby_str(ctx, argv[2]);
+  VALUE r_signature = quickjsrb_js_buffer_to_rb_str(ctx, argv[2]);
   if (NIL_P(r_signature))
     return JS_ThrowTypeError(ctx, "Failed to execute 'verify': signature must be an ArrayBuffer or TypedArray.");
 
-  VALUE r_data = js_buffer_to_ruby_str(ctx, argv[3]);
+  VALUE r_data = quickjsrb_js_buffer_to_rb_str(ctx, argv[3]);
   if (NIL_P(r_data))
     return JS_ThrowTypeError(ctx, "Failed to execute 'verify': data must be an ArrayBuffer or TypedArray.");
 
@@ -922,7 +893,7 @@ static JSValue js_subtle_unwrap_key(JSContext *ctx, JSValueConst this_val, int a
   VALUE r_format = rb_str_new_cstr(format_cstr);
   JS_FreeCString(ctx, format_cstr);
 
-  VALUE r_wrapped_key = js_buffer_to_ruby_str(ctx, argv[1]);
+  VALUE r_wrapped_key = quickjsrb_js_buffer_to_rb_str(ctx, argv[1]);
   if (NIL_P(r_wrapped_key))
     return JS_ThrowTypeError(ctx, "Failed to execute 'unwrapKey': wrapped key data must be an ArrayBuffer or TypedArray.");
 
@@ -148,10 +148,9 @@ static JSValue js_ruby_file_slice(JSContext *ctx, JSValueConst _this, int argc,
   VALUE r_bytes = rb_funcall(r_file, rb_intern("read"), 1, LONG2NUM(len));
   rb_funcall(r_bytes, rb_intern("force_encoding"), 1, rb_str_new_cstr("BINARY"));
 
+  VMData *data = JS_GetContextOpaque(ctx);
   JSValue j_buf = JS_NewArrayBufferCopy(ctx, (const uint8_t *)RSTRING_PTR(r_bytes), RSTRING_LEN(r_bytes));
-  JSValue j_global = JS_GetGlobalObject(ctx);
-  JSValue j_uint8_ctor = JS_GetPropertyStr(ctx, j_global, "Uint8Array");
-  JSValue j_uint8 = JS_CallConstructor(ctx, j_uint8_ctor, 1, &j_buf);
+  JSValue j_uint8 = JS_CallConstructor(ctx, data->j_uint8array_ctor, 1, &j_buf);
 
   JSValue j_parts = JS_NewArray(ctx);
   JS_SetPropertyUint32(ctx, j_parts, 0, j_uint8);
@@ -159,19 +158,16 @@ static JSValue js_ruby_file_slice(JSContext *ctx, JSValueConst _this, int argc,
   JSValue j_opts = JS_NewObject(ctx);
   JS_SetPropertyStr(ctx, j_opts, "type", JS_NewString(ctx, content_type));
 
-  JSValue j_blob_ctor = JS_GetPropertyStr(ctx, j_global, "Blob");
   JSValueConst blob_args[2] = {j_parts, j_opts};
-  JSValue j_blob = JS_CallConstructor(ctx, j_blob_ctor, 2, blob_args);
+  JSValue j_blob = quickjsrb_file_ctors(data, true) ? JS_CallConstructor(ctx, data->j_blob_ctor, 2, blob_args)
+                                                    : JS_EXCEPTION;
 
   if (argc > 3 && JS_IsString(argv[3]))
     JS_FreeCString(ctx, content_type);
 
   JS_FreeValue(ctx, j_buf);
-  JS_FreeValue(ctx, j_uint8_ctor);
   JS_FreeValue(ctx, j_parts);
   JS_FreeValue(ctx, j_opts);
-  JS_FreeValue(ctx, j_blob_ctor);
-  JS_FreeValue(ctx, j_global);
 
   return j_blob;
 }
@@ -273,20 +269,79 @@ static void r_populate_blob_attrs(JSContext *ctx, JSValue j_val, VALUE r_obj)
   rb_iv_set(r_obj, "@content", r_extract_blob_content(ctx, j_val));
 }
 
-VALUE quickjsrb_try_convert_js_file(JSContext *ctx, JSValue j_val)
+// A lazy_polyfills: File stub still on globalThis: an accessor, where the
+// loaded polyfill assigns a plain data property. Read without calling it.
+static bool file_polyfill_stubbed(JSContext *ctx, JSValueConst j_global)
 {
-  JSValue j_global = JS_GetGlobalObject(ctx);
+  JSPropertyDescriptor desc;
+  JSAtom atom = JS_NewAtom(ctx, "File");
+  int found = JS_GetOwnProperty(ctx, &desc, j_global, atom);
+  JS_FreeAtom(ctx, atom);
+  if (found < 0)
+    JS_FreeValue(ctx, JS_GetException(ctx));
+  if (found <= 0)
+    return false;
+  JS_FreeValue(ctx, desc.value);
+  JS_FreeValue(ctx, desc.getter);
+  JS_FreeValue(ctx, desc.setter);
+  return (desc.flags & JS_PROP_GETSET) != 0;
+}
 
-  // Check File first (File extends Blob, so instanceof Blob is also true for Files)
+bool quickjsrb_file_ctors(VMData *data, bool load)
+{
+  if (data->file_ctors_cached)
+    return true;
+
+  JSContext *ctx = data->context;
+  JSValue j_global = JS_GetGlobalObject(ctx);
+  if (!load && file_polyfill_stubbed(ctx, j_global))
+  {
+    // Settled until the stub fires: lazy_polyfill_load clears the flag.
+    JS_FreeValue(ctx, j_global);
+    data->file_ctors_cached = true;
+    return true;
+  }
   JSValue j_file_ctor = JS_GetPropertyStr(ctx, j_global, "File");
-  if (!JS_IsUndefined(j_file_ctor) && !JS_IsException(j_file_ctor))
+  JSValue j_blob_ctor = JS_IsException(j_file_ctor) ? JS_UNDEFINED : JS_GetPropertyStr(ctx, j_global, "Blob");
+  JS_FreeValue(ctx, j_global);
+  if (JS_IsException(j_file_ctor) || JS_IsException(j_blob_ctor))
   {
-    int is_file = JS_IsInstanceOf(ctx, j_val, j_file_ctor);
+    // The lazy load threw. Nothing is cached, so the next use tries the
+    // globals again rather than treating Files as gone for good.
     JS_FreeValue(ctx, j_file_ctor);
+    if (!load)
+      JS_FreeValue(ctx, JS_GetException(ctx));
+    return false;
+  }
+  JS_FreeValue(ctx, data->j_file_ctor);
+  JS_FreeValue(ctx, data->j_blob_ctor);
+  data->j_file_ctor = JS_UNDEFINED;
+  data->j_blob_ctor = JS_UNDEFINED;
+  if (!JS_IsObject(j_file_ctor) || !JS_IsObject(j_blob_ctor))
+  {
+    JS_FreeValue(ctx, j_file_ctor);
+    JS_FreeValue(ctx, j_blob_ctor);
+    return true;
+  }
+  data->j_file_ctor = j_file_ctor;
+  data->j_blob_ctor = j_blob_ctor;
+  data->file_ctors_cached = true;
+  return true;
+}
+
+VALUE quickjsrb_try_convert_js_file(JSContext *ctx, JSValue j_val)
+{
+  VMData *data = JS_GetContextOpaque(ctx);
+  quickjsrb_file_ctors(data, false);
+
+  // Check File first (File extends Blob, so instanceof Blob is also true for Files)
+  if (!JS_IsUndefined(data->j_file_ctor))
+  {
+    int is_file = JS_IsInstanceOf(ctx, j_val, data->j_file_ctor);
+    if (is_file < 0)
+      JS_FreeValue(ctx, JS_GetException(ctx));
     if (is_file > 0)
     {
-      JS_FreeValue(ctx, j_global);
-
       VALUE r_quickjs_mod = rb_const_get(rb_cClass, rb_intern("Quickjs"));
       VALUE r_file = rb_funcall(rb_const_get(r_quickjs_mod, rb_intern("File")), rb_intern("new"), 0);
       r_populate_blob_attrs(ctx, j_val, r_file);
@@ -306,21 +361,13 @@ VALUE quickjsrb_try_convert_js_file(JSContext *ctx, JSValue j_val)
       return r_file;
     }
   }
-  else
-  {
-    JS_FreeValue(ctx, j_file_ctor);
-  }
 
-  JSValue j_blob_ctor = JS_GetPropertyStr(ctx, j_global, "Blob");
-  JS_FreeValue(ctx, j_global);
-  if (JS_IsUndefined(j_blob_ctor) || JS_IsException(j_blob_ctor))
-  {
-    JS_FreeValue(ctx, j_blob_ctor);
+  if (JS_IsUndefined(data->j_blob_ctor))
     return Qnil;
-  }
 
-  int is_blob = JS_IsInstanceOf(ctx, j_val, j_blob_ctor);
-  JS_FreeValue(ctx, j_blob_ctor);
+  int is_blob = JS_IsInstanceOf(ctx, j_val, data->j_blob_ctor);
+  if (is_blob < 0)
+    JS_FreeValue(ctx, JS_GetException(ctx)); // e.g. a throwing Proxy trap
   if (is_blob <= 0)
     return Qnil;
 
@@ -12,5 +12,13 @@ JSValue quickjsrb_file_to_js(JSContext *ctx, VALUE r_file);
 // Returns Qnil if not a File
 VALUE quickjsrb_try_convert_js_file(JSContext *ctx, JSValue j_val);
 
+// Fills data->j_file_ctor / j_blob_ctor (see VMData). With `load`, reading
+// them fires a pending lazy POLYFILL_FILE load; false means that load
+// threw, and its exception is pending. Without `load`, File stubs that
+// haven't fired leave both JS_UNDEFINED: no File or Blob can exist yet.
+// Loaded constructors and pending stubs are cached until
+// lazy_polyfill_load drops the cache; a failed lookup never is.
+bool quickjsrb_file_ctors(VMData *data, bool load);
+
 
 #endif /* QUICKJSRB_FILE_H */
@@ -0,0 +1,248 @@
+#include <stdlib.h>
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#elif defined(__linux__) || defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "quickjsrb.h"
+
+// Same per-allocation overhead QuickJS's js_def_malloc charges, so
+// malloc_size (and memory_limit) mean what they did before.
+#define TRACKED_MALLOC_OVERHEAD 8
+
+static _Atomic size_t global_limit = 0;
+static _Atomic size_t global_used = 0;
+
+bool quickjsrb_global_reserve(QuickjsrbHeap *heap, size_t bytes)
+{
+  size_t limit = atomic_load_explicit(&global_limit, memory_order_relaxed);
+  size_t used = atomic_fetch_add_explicit(&global_used, bytes, memory_order_relaxed) + bytes;
+  if (limit == 0)
+    return true;
+
+  // JS_RunGC can't run from inside an allocation; a zero threshold
+  // makes QuickJS collect before its next object allocation, after which
+  // it resets the threshold itself.
+  if (used > limit)
+  {
+    atomic_fetch_sub_explicit(&global_used, bytes, memory_order_relaxed);
+    heap->global_refused = true;
+    if (heap->runtime != NULL)
+    {
+      heap->pressure_gc_requested = true;
+      JS_SetGCThreshold(heap->runtime, 0);
+    }
+    return false;
+  }
+  if (used > limit - (limit >> 3))
+  {
+    if (heap->runtime != NULL && !heap->pressure_gc_requested)
+    {
+      heap->pressure_gc_requested = true;
+      JS_SetGCThreshold(heap->runtime, 0);
+    }
+  }
+  else if (heap->pressure_gc_requested && used < limit - (limit >> 2))
+  {
+    heap->pressure_gc_requested = false;
+  }
+  return true;
+}
+
+void quickjsrb_global_release(size_t bytes)
+{
+  atomic_fetch_sub_explicit(&global_used, bytes, memory_order_relaxed);
+}
+
+size_t quickjsrb_global_headroom(void)
+{
+  size_t limit = atomic_load_explicit(&global_limit, memory_order_relaxed);
+  size_t used = atomic_load_explicit(&global_used, memory_order_relaxed);
+  if (limit == 0)
+    return SIZE_MAX;
+  return used >= limit ? 0 : limit - used;
+}
+
+static size_t tracked_malloc_usable_size(const void *ptr)
+{
+#if defined(__APPLE__)
+  return malloc_size(ptr);
+#elif defined(__linux__) || defined(__GLIBC__)
+  return malloc_usable_size((void *)ptr);
+#else
+  return 0;
+#endif
+}
+
+void quickjsrb_global_settle(size_t reserved, size_t actual)
+{
+  if (actual > reserved)
+    atomic_fetch_add_explicit(&global_used, actual - reserved, memory_order_relaxed);
+  else if (actual < reserved)
+    quickjsrb_global_release(reserved - actual);
+}
+
+static void *tracked_malloc(JSMallocState *s, size_t size)
+{
+  QuickjsrbHeap *heap = s->opaque;
+  if (s->malloc_size + size > s->malloc_limit)
+    return quickjsrb_local_refusal(heap);
+
+  if (!quickjsrb_global_reserve(heap, size + TRACKED_MALLOC_OVERHEAD))
+    return NULL;
+  void *ptr = malloc(size);
+  if (ptr == NULL)
+  {
+    quickjsrb_global_release(size + TRACKED_MALLOC_OVERHEAD);
+    return NULL;
+  }
+
+  size_t footprint = tracked_malloc_usable_size(ptr) + TRACKED_MALLOC_OVERHEAD;
+  quickjsrb_global_settle(size + TRACKED_MALLOC_OVERHEAD, footprint);
+  s->malloc_count++;
+  s->malloc_size += footprint;
+  heap->bytes = s->malloc_size;
+  heap->allocations++;
+  return ptr;
+}
+
+static void tracked_free(JSMallocState *s, void *ptr)
+{
+  if (ptr == NULL)
+    return;
+
+  size_t footprint = tracked_malloc_usable_size(ptr) + TRACKED_MALLOC_OVERHEAD;
+  s->malloc_count--;
+  s->malloc_size -= footprint;
+  ((QuickjsrbHeap *)s->opaque)->bytes = s->malloc_size;
+  quickjsrb_global_release(footprint);
+  free(ptr);
+}
+
+static void *tracked_realloc(JSMallocState *s, void *ptr, size_t size)
+{
+  if (ptr == NULL)
+    return size == 0 ? NULL : tracked_malloc(s, size);
+
+  size_t old_size = tracked_malloc_usable_size(ptr);
+  if (size == 0)
+  {
+    tracked_free(s, ptr);
+    return NULL;
+  }
+  if (s->malloc_size + size - old_size > s->malloc_limit)
+    return quickjsrb_local_refusal(s->opaque);
+
+  size_t reserved = size > old_size ? size - old_size : 0;
+  if (reserved > 0 && !quickjsrb_global_reserve(s->opaque, reserved))
+    return NULL;
+  void *grown = realloc(ptr, size);
+  if (grown == NULL)
+  {
+    quickjsrb_global_release(reserved);
+    return NULL;
+  }
+
+  size_t new_size = tracked_malloc_usable_size(grown);
+  quickjsrb_global_settle(old_size + reserved, new_size);
+  s->malloc_size += new_size - old_size;
+  ((QuickjsrbHeap *)s->opaque)->bytes = s->malloc_size;
+  return grown;
+}
+
+const JSMallocFunctions quickjsrb_tracked_malloc_functions = {
+    tracked_malloc,
+    tracked_free,
+    tracked_realloc,
+    tracked_malloc_usable_size,
+};
+
+// What VM construction wants free under the global limit before it
+// starts: a bare context is a few hundred KB, polyfills add more.
+#define GLOBAL_CONSTRUCT_HEADROOM (1024 * 1024)
+#define GLOBAL_WAIT_POLL_USEC 5000
+
+// Seconds VM.new waits for headroom before raising (Quickjs.global_memory_wait).
+static double global_wait = 1.0;
+
+static double global_now(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+void quickjsrb_global_await_headroom(void)
+{
+  if (quickjsrb_global_headroom() >= GLOBAL_CONSTRUCT_HEADROOM)
+    return;
+
+  // Dropped-but-uncollected VMs are the cheapest headroom there is.
+  rb_gc();
+  double deadline = global_now() + global_wait;
+  while (quickjsrb_global_headroom() < GLOBAL_CONSTRUCT_HEADROOM)
+  {
+    if (global_now() >= deadline)
+    {
+      VALUE r_msg = rb_sprintf("Quickjs.global_memory_limit reached: %zu of %zu bytes in use",
+                               atomic_load_explicit(&global_used, memory_order_relaxed),
+                               atomic_load_explicit(&global_limit, memory_order_relaxed));
+      rb_exc_raise(rb_funcall(QUICKJSRB_ERROR_FOR(QUICKJSRB_GLOBAL_MEMORY_LIMIT_ERROR), rb_intern("new"), 2, r_msg, Qnil));
+    }
+    // Other threads' dispose!, GC and the reaper free memory meanwhile.
+    struct timeval tv = {0, GLOBAL_WAIT_POLL_USEC};
+    rb_thread_wait_for(tv);
+  }
+}
+
+static VALUE heap_m_global_limit(VALUE r_self)
+{
+  size_t limit = atomic_load_explicit(&global_limit, memory_order_relaxed);
+  return limit == 0 ? Qnil : SIZET2NUM(limit);
+}
+
+static VALUE heap_m_set_global_limit(VALUE r_self, VALUE r_limit)
+{
+  size_t limit = 0;
+  if (!NIL_P(r_limit))
+  {
+    if (NUM2LL(r_limit) < 0)
+      rb_raise(rb_eArgError, "global_memory_limit must not be negative");
+    limit = NUM2SIZET(r_limit);
+  }
+  atomic_store_explicit(&global_limit, limit, memory_order_relaxed);
+  return r_limit;
+}
+
+static VALUE heap_m_global_used(VALUE r_self)
+{
+  return SIZET2NUM(atomic_load_explicit(&global_used, memory_order_relaxed));
+}
+
+static VALUE heap_m_global_wait(VALUE r_self)
+{
+  return DBL2NUM(global_wait);
+}
+
+static VALUE heap_m_set_global_wait(VALUE r_self, VALUE r_seconds)
+{
+  double seconds = NUM2DBL(r_seconds);
+  if (seconds < 0)
+    rb_raise(rb_eArgError, "global_memory_wait must not be negative");
+  global_wait = seconds;
+  return r_seconds;
+}
+
+void quickjsrb_init_heap(VALUE r_module)
+{
+  rb_define_singleton_method(r_module, "global_memory_limit", heap_m_global_limit, 0);
+  rb_define_singleton_method(r_module, "global_memory_limit=", heap_m_set_global_limit, 1);
+  rb_define_singleton_method(r_module, "global_memory_used", heap_m_global_used, 0);
+  rb_define_singleton_method(r_module, "global_memory_wait", heap_m_global_wait, 0);
+  rb_define_singleton_method(r_module, "global_memory_wait=", heap_m_set_global_wait, 1);
+}
@@ -0,0 +1,65 @@
+#ifndef QUICKJSRB_HEAP_H
+#define QUICKJSRB_HEAP_H 1
+
+#include <stdbool.h>
+
+#include "quickjs.h"
+
+// Bytes a JSRuntime currently holds from its allocator. The allocator
+// itself keeps `bytes` current (quickjsrb_tracked_malloc_functions below,
+// or the arena), so reading it is O(1) — unlike JS_ComputeMemoryUsage,
+// which walks the whole heap. `reported` is the part of it Ruby's GC has
+// been told about through rb_gc_adjust_memory_usage; that call needs the
+// GVL, which allocations made by GVL-released JS don't have, so the two
+// are reconciled at GVL-held points instead (see quickjsrb_heap_sync).
+typedef struct QuickjsrbHeap
+{
+  size_t bytes;
+  size_t reported;
+  // Allocations made over the runtime's lifetime (VM#init_profile).
+  size_t allocations;
+  // Set once the runtime exists, so global-budget pressure can ask it to
+  // collect (see quickjsrb_global_reserve).
+  JSRuntime *runtime;
+  // This runtime has been asked to collect during the current pressure
+  // episode; cleared when the process drops back below the mark.
+  bool pressure_gc_requested;
+  // The last allocation this runtime was refused was turned down by the
+  // global budget rather than its own malloc_limit. The error path reads
+  // it to raise Quickjs::GlobalMemoryLimitError; cleared at each
+  // outermost JS entry.
+  bool global_refused;
+} QuickjsrbHeap;
+
+// QuickJS's default malloc/free/realloc with its own accounting and
+// malloc_limit checks, plus mirroring malloc_size into the QuickjsrbHeap
+// passed as JS_NewRuntime2's opaque.
+extern const JSMallocFunctions quickjsrb_tracked_malloc_functions;
+
+// Quickjs.global_memory_limit: one atomic count of the bytes every
+// runtime's allocator (tracked or arena) holds, checked on top of each
+// runtime's own malloc_limit. Reserving past the limit fails, which
+// QuickJS surfaces as an out-of-memory error in the allocating VM. Once
+// the process is past seven eighths of the limit, each allocating runtime
+// is asked — once per episode — to run its GC at QuickJS's next safe
+// point, so garbage is reclaimed before anyone hits the wall. A limit of
+// 0 means none; usage is counted either way so a limit set later is
+// accurate. A refusal asks the runtime to collect at its next safe point
+// too: QuickJS can't run its GC from inside its own allocator, so the
+// collection lands before the next object allocation, or when the error
+// reaches Ruby, and a retry then finds the space the garbage held.
+bool quickjsrb_global_reserve(QuickjsrbHeap *heap, size_t bytes);
+void quickjsrb_global_release(size_t bytes);
+// Allocators call this when the runtime's own malloc_limit refuses.
+static inline void *quickjsrb_local_refusal(QuickjsrbHeap *heap)
+{
+  heap->global_refused = false;
+  return NULL;
+}
+// Corrects a reservation of `reserved` bytes to what the allocation
+// actually occupies (allocators round sizes up).
+void quickjsrb_global_settle(size_t reserved, size_t actual);
+// Bytes left under the limit; SIZE_MAX when there is none.
+size_t quickjsrb_global_headroom(void);
+
+#endif /* QUICKJSRB_HEAP_H */
@@ -0,0 +1,277 @@
+#include "quickjsrb.h"
+#include "quickjsrb_object_ref.h"
+
+static VALUE r_class_object_ref = Qnil;
+
+// Linked into its VM's data->object_refs while `data` is set. Releasing
+// the context (dispose!, reset!, a recycle rebuild, or the VM's own dfree)
+// frees j_val and clears `data`; the handle then only raises.
+typedef struct QuickjsrbObjectRef
+{
+  VALUE r_vm;
+  VMData *data;
+  JSValue j_val;
+  struct QuickjsrbObjectRef *prev;
+  struct QuickjsrbObjectRef *next;
+} QuickjsrbObjectRef;
+
+static void object_ref_unlink(QuickjsrbObjectRef *ref)
+{
+  if (ref->prev != NULL)
+    ref->prev->next = ref->next;
+  else
+    ref->data->object_refs = ref->next;
+  if (ref->next != NULL)
+    ref->next->prev = ref->prev;
+  ref->prev = ref->next = NULL;
+}
+
+// Runs during GC with the GVL held. JS paused in a bridge callback is
+// fine to free under, but JS running with the GVL released isn't: park
+// the value until that region ends (quickjsrb_object_refs_drain).
+static void object_ref_free(void *ptr)
+{
+  QuickjsrbObjectRef *ref = ptr;
+  VMData *data = ref->data;
+  if (data != NULL)
+  {
+    object_ref_unlink(ref);
+    if (data->gvl_release_regions == 0)
+    {
+      JS_FreeValue(data->context, ref->j_val);
+    }
+    else
+    {
+      if (data->ref_graveyard_len == data->ref_graveyard_cap)
+      {
+        size_t cap = data->ref_graveyard_cap == 0 ? 16 : data->ref_graveyard_cap * 2;
+        JSValue *grown = realloc(data->ref_graveyard, cap * sizeof(JSValue));
+        if (grown != NULL)
+        {
+          data->ref_graveyard = grown;
+          data->ref_graveyard_cap = cap;
+        }
+      }
+      // Out of memory: the value leaks until the runtime is freed.
+      if (data->ref_graveyard_len < data->ref_graveyard_cap)
+        data->ref_graveyard[data->ref_graveyard_len++] = ref->j_val;
+    }
+  }
+  xfree(ref);
+}
+
+static void object_ref_mark(void *ptr)
+{
+  QuickjsrbObjectRef *ref = ptr;
+  rb_gc_mark_movable(ref->r_vm);
+}
+
+static void object_ref_compact(void *ptr)
+{
+  QuickjsrbObjectRef *ref = ptr;
+  ref->r_vm = rb_gc_location(ref->r_vm);
+}
+
+static const rb_data_type_t object_ref_type = {
+    .wrap_struct_name = "quickjsrb_object_ref",
+    .function = {
+        .dmark = object_ref_mark,
+        .dfree = object_ref_free,
+        .dcompact = object_ref_compact,
+    },
+    .flags = RUBY_TYPED_FREE_IMMEDIATELY,
+};
+
+VALUE quickjsrb_object_ref_new(VALUE r_vm, VMData *data, JSValue j_val)
+{
+  QuickjsrbObjectRef *ref;
+  VALUE r_ref = TypedData_Make_Struct(r_class_object_ref, QuickjsrbObjectRef, &object_ref_type, ref);
+  ref->r_vm = r_vm;
+  ref->data = data;
+  ref->j_val = j_val;
+  ref->prev = NULL;
+  ref->next = data->object_refs;
+  if (data->object_refs != NULL)
+    data->object_refs->prev = ref;
+  data->object_refs = ref;
+  return r_ref;
+}
+
+void quickjsrb_object_refs_drain(VMData *data)
+{
+  for (size_t i = 0; i < data->ref_graveyard_len; i++)
+    JS_FreeValue(data->context, data->ref_graveyard[i]);
+  data->ref_graveyard_len = 0;
+}
+
+void quickjsrb_object_refs_release(VMData *data, JSContext *ctx)
+{
+  for (size_t i = 0; i < data->ref_graveyard_len; i++)
+    JS_FreeValue(ctx, data->ref_graveyard[i]);
+  data->ref_graveyard_len = 0;
+
+  QuickjsrbObjectRef *ref = data->object_refs;
+  while (ref != NULL)
+  {
+    QuickjsrbObjectRef *next = ref->next;
+    JS_FreeValue(ctx, ref->j_val);
+    ref->j_val = JS_UNDEFINED;
+    ref->data = NULL;
+    ref->prev = ref->next = NULL;
+    ref = next;
+  }
+  data->object_refs = NULL;
+}
+
+static QuickjsrbObjectRef *object_ref_live(VALUE r_self)
+{
+  QuickjsrbObjectRef *ref;
+  TypedData_Get_Struct(r_self, QuickjsrbObjectRef, &object_ref_type, ref);
+  if (ref->data == NULL)
+  {
+    VALUE r_msg = rb_str_new2("Quickjs::ObjectRef outlived its context: the VM was disposed, reset or recycled");
+    rb_exc_raise(rb_funcall(QUICKJSRB_ERROR_FOR(QUICKJSRB_ROOT_RUNTIME_ERROR), rb_intern("new"), 2, r_msg, Qnil));
+  }
+  if (ref->data->gvl_release_regions > 0)
+    rb_raise(rb_eThreadError, "cannot read a Quickjs::ObjectRef while its VM is evaluating with the GVL released");
+  return ref;
+}
+
+struct object_ref_op
+{
+  QuickjsrbObjectRef *ref;
+  VALUE r_arg;
+};
+
+static VALUE object_ref_run(VALUE r_self, VALUE (*body)(VALUE), VALUE r_arg)
+{
+  struct object_ref_op op = {object_ref_live(r_self), r_arg};
+  return quickjsrb_run_js_entry(op.ref->data, body, (VALUE)&op);
+}
+
+static VALUE object_ref_aref_body(VALUE p)
+{
+  struct object_ref_op *op = (struct object_ref_op *)p;
+  JSContext *ctx = op->ref->data->context;
+  JSValue j_prop;
+  if (RB_INTEGER_TYPE_P(op->r_arg))
+  {
+    j_prop = JS_GetPropertyInt64(ctx, op->ref->j_val, NUM2LL(op->r_arg));
+  }
+  else
+  {
+    VALUE r_name = SYMBOL_P(op->r_arg) ? rb_sym2str(op->r_arg) : op->r_arg;
+    StringValue(r_name);
+    JSAtom atom = JS_NewAtomLen(ctx, RSTRING_PTR(r_name), (size_t)RSTRING_LEN(r_name));
+    j_prop = JS_GetProperty(ctx, op->ref->j_val, atom);
+    JS_FreeAtom(ctx, atom);
+  }
+
+  VALUE r_value = quickjsrb_to_rb_value_lazy(ctx, j_prop, op->ref->r_vm);
+  JS_FreeValue(ctx, j_prop);
+  return r_value;
+}
+
+// Reads one property (String / Symbol key) or element (Integer index).
+// Objects come back as further ObjectRefs; everything else converts as
+// eval_code would.
+static VALUE object_ref_m_aref(VALUE r_self, VALUE r_key)
+{
+  return object_ref_run(r_self, object_ref_aref_body, r_key);
+}
+
+static VALUE object_ref_keys_body(VALUE p)
+{
+  struct object_ref_op *op = (struct object_ref_op *)p;
+  JSContext *ctx = op->ref->data->context;
+  JSPropertyEnum *ptab;
+  uint32_t plen;
+  if (JS_GetOwnPropertyNames(ctx, &ptab, &plen, op->ref->j_val, JS_GPN_STRING_MASK | JS_GPN_ENUM_ONLY) < 0)
+    return to_rb_value(ctx, JS_EXCEPTION); // raises
+
+  VALUE r_keys = rb_ary_new_capa(plen);
+  for (uint32_t i = 0; i < plen; i++)
+  {
+    const char *key = JS_AtomToCString(ctx, ptab[i].atom);
+    if (key != NULL)
+    {
+      rb_ary_push(r_keys, rb_utf8_str_new_cstr(key));
+      JS_FreeCString(ctx, key);
+    }
+  }
+  JS_FreePropertyEnum(ctx, ptab, plen);
+  return r_keys;
+}
+
+// Own enumerable String keys, the ones eval_code would put in the Hash.
+static VALUE object_ref_m_keys(VALUE r_self)
+{
+  return object_ref_run(r_self, object_ref_keys_body, Qnil);
+}
+
+static VALUE object_ref_size_body(VALUE p)
+{
+  struct object_ref_op *op = (struct object_ref_op *)p;
+  JSContext *ctx = op->ref->data->context;
+  if (JS_IsArray(ctx, op->ref->j_val) <= 0)
+    return LONG2NUM(RARRAY_LEN(object_ref_keys_body(p)));
+
+  JSValue j_length = JS_GetPropertyStr(ctx, op->ref->j_val, "length");
+  int64_t length = 0;
+  JS_ToInt64(ctx, &length, j_length);
+  JS_FreeValue(ctx, j_length);
+  return LL2NUM(length);
+}
+
+// Element count of an array, key count of any other object.
+static VALUE object_ref_m_size(VALUE r_self)
+{
+  return object_ref_run(r_self, object_ref_size_body, Qnil);
+}
+
+static VALUE object_ref_m_array_p(VALUE r_self)
+{
+  QuickjsrbObjectRef *ref = object_ref_live(r_self);
+  return JS_IsArray(ref->data->context, ref->j_val) > 0 ? Qtrue : Qfalse;
+}
+
+static VALUE object_ref_materialize_body(VALUE p)
+{
+  struct object_ref_op *op = (struct object_ref_op *)p;
+  return to_rb_value(op->ref->data->context, op->ref->j_val);
+}
+
+// The whole graph, converted the way eval_code would have.
+static VALUE object_ref_m_materialize(VALUE r_self)
+{
+  return object_ref_run(r_self, object_ref_materialize_body, Qnil);
+}
+
+static VALUE object_ref_m_to_h(VALUE r_self)
+{
+  VALUE r_value = object_ref_m_materialize(r_self);
+  if (!RB_TYPE_P(r_value, T_HASH))
+    rb_raise(rb_eTypeError, "Quickjs::ObjectRef holds a %s, not an object", rb_obj_classname(r_value));
+  return r_value;
+}
+
+static VALUE object_ref_m_released_p(VALUE r_self)
+{
+  QuickjsrbObjectRef *ref;
+  TypedData_Get_Struct(r_self, QuickjsrbObjectRef, &object_ref_type, ref);
+  return ref->data == NULL ? Qtrue : Qfalse;
+}
+
+void quickjsrb_init_object_ref(VALUE r_module)
+{
+  r_class_object_ref = rb_define_class_under(r_module, "ObjectRef", rb_cObject);
+  rb_gc_register_address(&r_class_object_ref);
+  rb_undef_alloc_func(r_class_object_ref);
+  rb_define_method(r_class_object_ref, "[]", object_ref_m_aref, 1);
+  rb_define_method(r_class_object_ref, "keys", object_ref_m_keys, 0);
+  rb_define_method(r_class_object_ref, "size", object_ref_m_size, 0);
+  rb_define_method(r_class_object_ref, "array?", object_ref_m_array_p, 0);
+  rb_define_method(r_class_object_ref, "materialize", object_ref_m_materialize, 0);
+  rb_define_method(r_class_object_ref, "to_h", object_ref_m_to_h, 0);
+  rb_define_method(r_class_object_ref, "released?", object_ref_m_released_p, 0);
+}
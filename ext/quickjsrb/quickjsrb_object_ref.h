@@ -0,0 +1,25 @@
+#ifndef QUICKJSRB_OBJECT_REF_H
+#define QUICKJSRB_OBJECT_REF_H 1
+
+// Included after quickjsrb.h.
+
+// eval_code(materialize: :lazy) / VM#eval_handle hand back a
+// Quickjs::ObjectRef instead of converting the result graph: it holds the
+// JSValue and converts only what's read through it.
+
+// Wraps j_val, a value on data->context, for the VM r_vm (whose VMData
+// is data). Ownership of j_val passes to the handle.
+VALUE quickjsrb_object_ref_new(VALUE r_vm, VMData *data, JSValue j_val);
+
+// to_rb_value, except that objects stop at a Quickjs::ObjectRef on r_vm.
+// Doesn't free j_val.
+VALUE quickjsrb_to_rb_value_lazy(JSContext *ctx, JSValue j_val, VALUE r_vm);
+
+// Runs body(arg) as a JS entry on the VM: disposed and poisoned checks,
+// a fresh eval budget, and the evals_in_flight accounting dispose! relies
+// on.
+VALUE quickjsrb_run_js_entry(VMData *data, VALUE (*body)(VALUE), VALUE arg);
+
+void quickjsrb_init_object_ref(VALUE r_module);
+
+#endif /* QUICKJSRB_OBJECT_REF_H */
@@ -0,0 +1,86 @@
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "quickjsrb.h"
+#include "quickjsrb_preload.h"
+
+typedef struct SealedRegion
+{
+  const char *ptr;
+  size_t len;
+} SealedRegion;
+
+// Only touched with the GVL held. Regions are never unmapped: Strings
+// pointing into them may be anywhere, including in forked children.
+static SealedRegion *sealed_regions = NULL;
+static size_t sealed_count = 0;
+
+bool quickjsrb_sealed_p(const void *ptr, size_t len)
+{
+  const char *p = ptr;
+  for (size_t i = 0; i < sealed_count; i++)
+    if (p >= sealed_regions[i].ptr && p + len <= sealed_regions[i].ptr + sealed_regions[i].len)
+      return true;
+  return false;
+}
+
+// Copies the String's bytes into a fresh mapping, makes it read-only, and
+// returns a frozen binary String backed by it. Nothing writes those pages
+// again — not QuickJS (JS_ReadObject only reads its input), not Ruby's GC
+// (the String doesn't own the buffer) — so a preforking master's copy is
+// the one every worker reads. Already-sealed Strings come back as-is.
+static VALUE preload_m_seal_bytes(VALUE r_self, VALUE r_str)
+{
+  StringValue(r_str);
+  size_t len = (size_t)RSTRING_LEN(r_str);
+  if (quickjsrb_sealed_p(RSTRING_PTR(r_str), len) && OBJ_FROZEN(r_str))
+    return r_str;
+
+  SealedRegion *grown = realloc(sealed_regions, (sealed_count + 1) * sizeof(SealedRegion));
+  if (grown == NULL)
+    rb_raise(rb_eNoMemError, "failed to seal bytecode");
+  sealed_regions = grown;
+
+  // One spare byte keeps the copy NUL-terminated like any Ruby String.
+  size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+  size_t map_len = (len + 1 + page_size - 1) & ~(page_size - 1);
+  char *map = mmap(NULL, map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (map == MAP_FAILED)
+    rb_raise(rb_eNoMemError, "failed to seal bytecode");
+  memcpy(map, RSTRING_PTR(r_str), len);
+  if (mprotect(map, map_len, PROT_READ) != 0)
+  {
+    munmap(map, map_len);
+    rb_sys_fail("mprotect");
+  }
+
+  sealed_regions[sealed_count].ptr = map;
+  sealed_regions[sealed_count].len = len;
+  sealed_count++;
+
+  VALUE r_sealed = rb_str_new_static(map, (long)len);
+  return rb_obj_freeze(r_sealed);
+}
+
+static VALUE preload_m_sealed_p(VALUE r_self, VALUE r_str)
+{
+  if (!RB_TYPE_P(r_str, T_STRING))
+    return Qfalse;
+  return quickjsrb_sealed_p(RSTRING_PTR(r_str), (size_t)RSTRING_LEN(r_str)) ? Qtrue : Qfalse;
+}
+
+// Bytes held in sealed mappings, for Quickjs.preload_stats.
+static VALUE preload_m_sealed_bytes(VALUE r_self)
+{
+  size_t total = 0;
+  for (size_t i = 0; i < sealed_count; i++)
+    total += sealed_regions[i].len;
+  return SIZET2NUM(total);
+}
+
+void quickjsrb_init_preload(VALUE r_module)
+{
+  rb_define_singleton_method(r_module, "_seal_bytes", preload_m_seal_bytes, 1);
+  rb_define_singleton_method(r_module, "_sealed?", preload_m_sealed_p, 1);
+  rb_define_singleton_method(r_module, "_sealed_bytes", preload_m_sealed_bytes, 0);
+}
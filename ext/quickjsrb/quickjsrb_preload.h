@@ -0,0 +1,15 @@
+#ifndef QUICKJSRB_PRELOAD_H
+#define QUICKJSRB_PRELOAD_H 1
+
+// Included after quickjsrb.h.
+
+// Quickjs.preload_for_fork seals bytecode into read-only mappings that
+// live for the rest of the process (and, after fork, are shared by every
+// worker until exit). True when [ptr, ptr + len) lies inside one: that
+// memory never moves or changes, so a GVL-released run may read it in
+// place instead of copying. Call with the GVL held.
+bool quickjsrb_sealed_p(const void *ptr, size_t len);
+
+void quickjsrb_init_preload(VALUE r_module);
+
+#endif /* QUICKJSRB_PRELOAD_H */
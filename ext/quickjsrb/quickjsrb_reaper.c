@@ -0,0 +1,243 @@
+#include <pthread.h>
+
+#include "quickjsrb.h"
+#include "quickjsrb_reaper.h"
+
+#define REAPER_DEFAULT_CAPACITY 64
+
+typedef struct ReaperJob
+{
+  struct ReaperJob *next;
+  JSContext *context;
+  QuickjsrbArena *arena;
+  bool arena_fast_teardown;
+  QuickjsrbHeap *heap;
+} ReaperJob;
+
+// Everything below is guarded by reaper_lock.
+static pthread_mutex_t reaper_lock = PTHREAD_MUTEX_INITIALIZER;
+// Signalled when a job is queued, and when the backlog drops to zero.
+static pthread_cond_t reaper_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t reaper_idle = PTHREAD_COND_INITIALIZER;
+static ReaperJob *reaper_head = NULL;
+static ReaperJob *reaper_tail = NULL;
+static bool reaper_started = false;
+// Jobs queued plus the one being torn down, if any.
+static size_t reaper_backlog = 0;
+static size_t reaper_capacity = REAPER_DEFAULT_CAPACITY;
+static uint64_t reaper_enqueued = 0;
+static uint64_t reaper_reaped = 0;
+static uint64_t reaper_inline = 0;
+// Teardown wall-clock over reaped and inline jobs alike.
+static uint64_t reaper_teardown_ns_total = 0;
+static uint64_t reaper_teardown_ns_max = 0;
+
+static uint64_t reaper_now_ns(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+// Caller holds reaper_lock.
+static void reaper_record(uint64_t ns)
+{
+  reaper_teardown_ns_total += ns;
+  if (ns > reaper_teardown_ns_max)
+    reaper_teardown_ns_max = ns;
+}
+
+static uint64_t reaper_teardown(ReaperJob *job)
+{
+  uint64_t started = reaper_now_ns();
+  quickjsrb_free_private_runtime(job->context, job->arena, job->arena_fast_teardown);
+  free(job->heap);
+  free(job);
+  return reaper_now_ns() - started;
+}
+
+static void *reaper_main(void *arg)
+{
+  pthread_mutex_lock(&reaper_lock);
+  for (;;)
+  {
+    while (reaper_head == NULL)
+      pthread_cond_wait(&reaper_wake, &reaper_lock);
+
+    ReaperJob *job = reaper_head;
+    reaper_head = job->next;
+    if (reaper_head == NULL)
+      reaper_tail = NULL;
+
+    pthread_mutex_unlock(&reaper_lock);
+    uint64_t ns = reaper_teardown(job);
+    pthread_mutex_lock(&reaper_lock);
+
+    reaper_reaped++;
+    reaper_record(ns);
+    if (--reaper_backlog == 0)
+      pthread_cond_broadcast(&reaper_idle);
+  }
+  return NULL;
+}
+
+// Caller holds reaper_lock. The thread is detached and never exits; it
+// sleeps on reaper_wake when there's nothing to do.
+static bool reaper_ensure_started(void)
+{
+  if (reaper_started)
+    return true;
+
+  pthread_attr_t attr;
+  pthread_t thread;
+  if (pthread_attr_init(&attr) != 0)
+    return false;
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  reaper_started = pthread_create(&thread, &attr, reaper_main, NULL) == 0;
+  pthread_attr_destroy(&attr);
+  return reaper_started;
+}
+
+static void *reaper_inline_no_gvl(void *p)
+{
+  ReaperJob *job = p;
+  uint64_t ns = reaper_teardown(job);
+  pthread_mutex_lock(&reaper_lock);
+  reaper_inline++;
+  reaper_record(ns);
+  pthread_mutex_unlock(&reaper_lock);
+  return NULL;
+}
+
+void quickjsrb_reaper_submit(JSContext *ctx, QuickjsrbArena *arena, bool arena_fast_teardown, QuickjsrbHeap *heap)
+{
+  ReaperJob *job = malloc(sizeof(ReaperJob));
+  if (job == NULL)
+    rb_raise(rb_eNoMemError, "failed to queue a Quickjs::VM for disposal");
+  job->next = NULL;
+  job->context = ctx;
+  job->arena = arena;
+  job->arena_fast_teardown = arena_fast_teardown;
+  job->heap = heap;
+
+  pthread_mutex_lock(&reaper_lock);
+  bool queued = reaper_backlog < reaper_capacity && reaper_ensure_started();
+  if (queued)
+  {
+    if (reaper_tail != NULL)
+      reaper_tail->next = job;
+    else
+      reaper_head = job;
+    reaper_tail = job;
+    reaper_backlog++;
+    reaper_enqueued++;
+    pthread_cond_signal(&reaper_wake);
+  }
+  pthread_mutex_unlock(&reaper_lock);
+
+  if (!queued)
+    rb_thread_call_without_gvl(reaper_inline_no_gvl, job, NULL, NULL);
+}
+
+// The reaper thread doesn't survive fork, and may have held the lock when
+// the fork happened. The child gets fresh sync objects and starts its own
+// reaper on the next submit; a job the parent's reaper had dequeued is
+// simply never freed in the child.
+static void reaper_atfork_child(void)
+{
+  pthread_mutex_init(&reaper_lock, NULL);
+  pthread_cond_init(&reaper_wake, NULL);
+  pthread_cond_init(&reaper_idle, NULL);
+  reaper_started = false;
+  reaper_backlog = 0;
+  for (ReaperJob *job = reaper_head; job != NULL; job = job->next)
+    reaper_backlog++;
+}
+
+struct reaper_flush_wait
+{
+  bool interrupted;
+};
+
+static void *reaper_flush_no_gvl(void *p)
+{
+  struct reaper_flush_wait *wait = p;
+  pthread_mutex_lock(&reaper_lock);
+  if (reaper_head != NULL)
+    reaper_ensure_started();
+  while (reaper_backlog > 0 && reaper_started && !wait->interrupted)
+    pthread_cond_wait(&reaper_idle, &reaper_lock);
+  pthread_mutex_unlock(&reaper_lock);
+  return NULL;
+}
+
+static void reaper_flush_ubf(void *p)
+{
+  struct reaper_flush_wait *wait = p;
+  pthread_mutex_lock(&reaper_lock);
+  wait->interrupted = true;
+  pthread_cond_broadcast(&reaper_idle);
+  pthread_mutex_unlock(&reaper_lock);
+}
+
+// Blocks until every VM queued so far has been torn down.
+static VALUE reaper_m_flush(VALUE r_self)
+{
+  struct reaper_flush_wait wait = {false};
+  rb_thread_call_without_gvl(reaper_flush_no_gvl, &wait, reaper_flush_ubf, &wait);
+  return Qnil;
+}
+
+static VALUE reaper_m_capacity(VALUE r_self)
+{
+  pthread_mutex_lock(&reaper_lock);
+  size_t capacity = reaper_capacity;
+  pthread_mutex_unlock(&reaper_lock);
+  return SIZET2NUM(capacity);
+}
+
+static VALUE reaper_m_set_capacity(VALUE r_self, VALUE r_capacity)
+{
+  if (!RB_INTEGER_TYPE_P(r_capacity) || RTEST(rb_funcall(r_capacity, rb_intern("negative?"), 0)))
+    rb_raise(rb_eArgError, "reaper_capacity must be a non-negative Integer, got %" PRIsVALUE, rb_inspect(r_capacity));
+  size_t capacity = NUM2SIZET(r_capacity);
+  pthread_mutex_lock(&reaper_lock);
+  reaper_capacity = capacity;
+  pthread_mutex_unlock(&reaper_lock);
+  return r_capacity;
+}
+
+static VALUE reaper_m_metrics(VALUE r_self)
+{
+  pthread_mutex_lock(&reaper_lock);
+  size_t backlog = reaper_backlog;
+  size_t capacity = reaper_capacity;
+  uint64_t enqueued = reaper_enqueued;
+  uint64_t reaped = reaper_reaped;
+  uint64_t inlined = reaper_inline;
+  uint64_t ns_total = reaper_teardown_ns_total;
+  uint64_t ns_max = reaper_teardown_ns_max;
+  pthread_mutex_unlock(&reaper_lock);
+
+  uint64_t torn_down = reaped + inlined;
+  VALUE h = rb_hash_new();
+  rb_hash_aset(h, ID2SYM(rb_intern("backlog")), SIZET2NUM(backlog));
+  rb_hash_aset(h, ID2SYM(rb_intern("capacity")), SIZET2NUM(capacity));
+  rb_hash_aset(h, ID2SYM(rb_intern("enqueued")), ULL2NUM(enqueued));
+  rb_hash_aset(h, ID2SYM(rb_intern("reaped")), ULL2NUM(reaped));
+  rb_hash_aset(h, ID2SYM(rb_intern("inline")), ULL2NUM(inlined));
+  rb_hash_aset(h, ID2SYM(rb_intern("teardown_time_total")), DBL2NUM((double)ns_total / 1e9));
+  rb_hash_aset(h, ID2SYM(rb_intern("teardown_time_max")), DBL2NUM((double)ns_max / 1e9));
+  rb_hash_aset(h, ID2SYM(rb_intern("teardown_time_avg")), DBL2NUM(torn_down == 0 ? 0.0 : (double)ns_total / 1e9 / (double)torn_down));
+  return h;
+}
+
+void quickjsrb_init_reaper(VALUE r_module)
+{
+  pthread_atfork(NULL, NULL, reaper_atfork_child);
+
+  rb_define_singleton_method(r_module, "reaper_metrics", reaper_m_metrics, 0);
+  rb_define_singleton_method(r_module, "reaper_capacity", reaper_m_capacity, 0);
+  rb_define_singleton_method(r_module, "reaper_capacity=", reaper_m_set_capacity, 1);
+  rb_define_singleton_method(r_module, "reaper_flush", reaper_m_flush, 0);
+}
@@ -0,0 +1,16 @@
+#ifndef QUICKJSRB_REAPER_H
+#define QUICKJSRB_REAPER_H 1
+
+// Included after quickjsrb.h.
+
+// Background teardown behind VM#dispose_later: one native thread, started
+// on first use, frees queued private runtimes without the GVL. The queue
+// is bounded (Quickjs.reaper_capacity); a submit that finds it full tears
+// the runtime down on the calling thread instead, GVL released, so a
+// producer outrunning the reaper is slowed to its pace rather than piling
+// up heaps. Takes ownership of all three pointers. Call with the GVL held.
+void quickjsrb_reaper_submit(JSContext *ctx, QuickjsrbArena *arena, bool arena_fast_teardown, QuickjsrbHeap *heap);
+
+void quickjsrb_init_reaper(VALUE r_module);
+
+#endif /* QUICKJSRB_REAPER_H */
@@ -0,0 +1,539 @@
+#include "quickjsrb.h"
+#include "quickjsrb_ref.h"
+
+VALUE quickjsrb_class_ref = Qnil;
+
+static JSClassID ref_class_id;
+static ID id_object;
+static ID id_aref;
+static ID id_keys;
+
+// One per JS object made for a Quickjs::Ref, linked into its VM's
+// data->ref_pins so vm_mark keeps r_obj alive while JS can reach it. The
+// list only changes with the GVL held: a finalizer that runs while JS has
+// the GVL released marks its pin dead instead, and quickjsrb_refs_sweep
+// unlinks it once the region ends. Releasing the context clears `data`;
+// the JS object's finalizer then just frees the pin. Pins live on the JS
+// heap, so an arena VM's fast teardown, which skips finalizers, takes
+// them with it.
+//
+// `children` maps each Hash or Array read through this object to the JS
+// object made for it, so `o.user === o.user` and repeated reads don't
+// pile up pins. It's an open-addressed table keyed by the Ruby object's
+// address, which is why r_obj is marked pinned rather than movable.
+typedef struct QuickjsrbRefChild
+{
+  VALUE r_obj;
+  JSValue j_ref;
+} QuickjsrbRefChild;
+
+typedef struct QuickjsrbRefPin
+{
+  VALUE r_obj;
+  VMData *data;
+  JSRuntime *rt;
+  bool dead;
+  struct QuickjsrbRefPin *prev;
+  struct QuickjsrbRefPin *next;
+  QuickjsrbRefChild *children;
+  uint32_t children_capacity;
+  uint32_t children_count;
+} QuickjsrbRefPin;
+
+static size_t ref_child_slot(VALUE r_obj, uint32_t capacity)
+{
+  return (size_t)(((uint64_t)r_obj * UINT64_C(0x9E3779B97F4A7C15)) >> 32) & (capacity - 1);
+}
+
+static QuickjsrbRefChild *ref_child_find(QuickjsrbRefPin *pin, VALUE r_obj)
+{
+  if (pin->children == NULL)
+    return NULL;
+  for (size_t i = ref_child_slot(r_obj, pin->children_capacity);; i = (i + 1) & (pin->children_capacity - 1))
+  {
+    if (pin->children[i].r_obj == r_obj)
+      return &pin->children[i];
+    if (pin->children[i].r_obj == 0)
+      return NULL;
+  }
+}
+
+// Takes a reference to j_ref. Best effort: when the table can't grow the
+// child just isn't cached, and the next read makes another.
+static void ref_child_add(QuickjsrbRefPin *pin, VALUE r_obj, JSValueConst j_ref)
+{
+  if ((pin->children_count + 1) * 2 > pin->children_capacity)
+  {
+    uint32_t capacity = pin->children_capacity == 0 ? 8 : pin->children_capacity * 2;
+    QuickjsrbRefChild *grown = js_mallocz_rt(pin->rt, sizeof(QuickjsrbRefChild) * capacity);
+    if (grown == NULL)
+      return;
+    for (uint32_t i = 0; i < pin->children_capacity; i++)
+    {
+      if (pin->children[i].r_obj == 0)
+        continue;
+      size_t j = ref_child_slot(pin->children[i].r_obj, capacity);
+      while (grown[j].r_obj != 0)
+        j = (j + 1) & (capacity - 1);
+      grown[j] = pin->children[i];
+    }
+    js_free_rt(pin->rt, pin->children);
+    pin->children = grown;
+    pin->children_capacity = capacity;
+  }
+  size_t i = ref_child_slot(r_obj, pin->children_capacity);
+  while (pin->children[i].r_obj != 0)
+    i = (i + 1) & (pin->children_capacity - 1);
+  pin->children[i].r_obj = r_obj;
+  pin->children[i].j_ref = JS_DupValueRT(pin->rt, j_ref);
+  pin->children_count++;
+}
+
+// Pure QuickJS, so finalizers run it whether or not they hold the GVL.
+static void ref_children_free(QuickjsrbRefPin *pin)
+{
+  QuickjsrbRefChild *children = pin->children;
+  uint32_t capacity = pin->children_capacity;
+  pin->children = NULL;
+  pin->children_capacity = pin->children_count = 0;
+  for (uint32_t i = 0; i < capacity; i++)
+    if (children[i].r_obj != 0)
+      JS_FreeValueRT(pin->rt, children[i].j_ref);
+  js_free_rt(pin->rt, children);
+}
+
+static void ref_pin_unlink(QuickjsrbRefPin *pin)
+{
+  if (pin->prev != NULL)
+    pin->prev->next = pin->next;
+  else
+    pin->data->ref_pins = pin->next;
+  if (pin->next != NULL)
+    pin->next->prev = pin->prev;
+  js_free_rt(pin->rt, pin);
+}
+
+void quickjsrb_refs_mark(VMData *data)
+{
+  for (QuickjsrbRefPin *pin = data->ref_pins; pin != NULL; pin = pin->next)
+    rb_gc_mark(pin->r_obj);
+}
+
+void quickjsrb_refs_sweep(VMData *data)
+{
+  if (!data->ref_pins_dead)
+    return;
+  QuickjsrbRefPin *pin = data->ref_pins;
+  while (pin != NULL)
+  {
+    QuickjsrbRefPin *next = pin->next;
+    if (pin->dead)
+      ref_pin_unlink(pin);
+    pin = next;
+  }
+  data->ref_pins_dead = false;
+}
+
+void quickjsrb_refs_release(VMData *data)
+{
+  QuickjsrbRefPin *pin = data->ref_pins;
+  while (pin != NULL)
+  {
+    QuickjsrbRefPin *next = pin->next;
+    if (pin->dead)
+    {
+      js_free_rt(pin->rt, pin);
+    }
+    else
+    {
+      pin->data = NULL;
+      pin->prev = pin->next = NULL;
+    }
+    pin = next;
+  }
+  data->ref_pins = NULL;
+  data->ref_pins_dead = false;
+}
+
+static void ref_finalizer(JSRuntime *rt, JSValue j_val)
+{
+  QuickjsrbRefPin *pin = JS_GetOpaque(j_val, ref_class_id);
+  if (pin == NULL)
+    return;
+  ref_children_free(pin);
+  if (pin->data == NULL)
+  {
+    js_free_rt(rt, pin);
+    return;
+  }
+  if (pin->data->gvl_released_js)
+  {
+    pin->dead = true;
+    pin->data->ref_pins_dead = true;
+    return;
+  }
+  ref_pin_unlink(pin);
+}
+
+static void ref_gc_mark(JSRuntime *rt, JSValueConst j_val, JS_MarkFunc *mark_func)
+{
+  QuickjsrbRefPin *pin = JS_GetOpaque(j_val, ref_class_id);
+  if (pin == NULL || pin->children == NULL)
+    return;
+  for (uint32_t i = 0; i < pin->children_capacity; i++)
+    if (pin->children[i].r_obj != 0)
+      JS_MarkValue(rt, pin->children[i].j_ref, mark_func);
+}
+
+static JSClassExoticMethods ref_exotic;
+static JSClassDef ref_class_def = {
+    .class_name = "Ref",
+    .finalizer = ref_finalizer,
+    .gc_mark = ref_gc_mark,
+    .exotic = &ref_exotic,
+};
+
+// Hashes and Arrays get a pin on a fresh JS object; Array ones inherit
+// Array.prototype, whose methods only need `length` and indices.
+static JSValue ref_new_js(JSContext *ctx, VALUE r_obj)
+{
+  VMData *data = JS_GetContextOpaque(ctx);
+  JSRuntime *rt = JS_GetRuntime(ctx);
+  if (!JS_IsRegisteredClass(rt, ref_class_id) && JS_NewClass(rt, ref_class_id, &ref_class_def) < 0)
+    return JS_ThrowOutOfMemory(ctx);
+
+  JSValueConst j_proto = RB_TYPE_P(r_obj, T_ARRAY) && JS_IsObject(data->j_array_prototype) ? data->j_array_prototype
+                                                                                          : data->j_object_prototype;
+  JSValue j_ref = JS_NewObjectProtoClass(ctx, j_proto, ref_class_id);
+  if (JS_IsException(j_ref))
+    return j_ref;
+  QuickjsrbRefPin *pin = js_malloc_rt(rt, sizeof(QuickjsrbRefPin));
+  if (pin == NULL)
+  {
+    JS_FreeValue(ctx, j_ref);
+    return JS_ThrowOutOfMemory(ctx);
+  }
+  pin->r_obj = r_obj;
+  pin->data = data;
+  pin->rt = rt;
+  pin->dead = false;
+  pin->children = NULL;
+  pin->children_capacity = pin->children_count = 0;
+  pin->prev = NULL;
+  pin->next = data->ref_pins;
+  if (data->ref_pins != NULL)
+    data->ref_pins->prev = pin;
+  data->ref_pins = pin;
+  JS_SetOpaque(j_ref, pin);
+  return j_ref;
+}
+
+JSValue quickjsrb_ref_to_js(JSContext *ctx, VALUE r_ref)
+{
+  return ref_new_js(ctx, rb_ivar_get(r_ref, id_object));
+}
+
+VALUE quickjsrb_ref_from_js(JSValueConst j_val)
+{
+  QuickjsrbRefPin *pin = JS_GetOpaque(j_val, ref_class_id);
+  if (pin == NULL)
+    return Qundef;
+  return pin->data != NULL ? pin->r_obj : Qnil;
+}
+
+// A Hash or Array read through `pin` reuses the JS object made for it the
+// first time; anything else is converted as to_js_value would.
+static JSValue ref_value_to_js(JSContext *ctx, QuickjsrbRefPin *pin, VALUE r_value)
+{
+  if (!RB_TYPE_P(r_value, T_HASH) && !RB_TYPE_P(r_value, T_ARRAY))
+    return to_js_value(ctx, r_value);
+
+  QuickjsrbRefChild *child = ref_child_find(pin, r_value);
+  if (child != NULL)
+    return JS_DupValue(ctx, child->j_ref);
+  JSValue j_ref = ref_new_js(ctx, r_value);
+  if (!JS_IsException(j_ref))
+    ref_child_add(pin, r_value, j_ref);
+  return j_ref;
+}
+
+// Each exotic handler packs its arguments here and runs `body` with the
+// GVL held and Ruby exceptions caught: a raise can't unwind through
+// QuickJS, so it's rethrown into JS the way define_function does.
+struct ref_op
+{
+  JSContext *ctx;
+  QuickjsrbRefPin *pin;
+  JSAtom atom;
+  JSPropertyDescriptor *desc;
+  JSPropertyEnum **ptab;
+  uint32_t *plen;
+  VALUE (*body)(VALUE);
+  int ret;
+};
+
+static void ref_run_protected(struct ref_op *op)
+{
+  int state = 0;
+  rb_protect(op->body, (VALUE)op, &state);
+  if (state)
+  {
+    VALUE r_error = rb_errinfo();
+    rb_set_errinfo(Qnil);
+    if (rb_obj_is_kind_of(r_error, rb_eException))
+      JS_Throw(op->ctx, j_error_from_ruby_error(op->ctx, r_error));
+    else
+      JS_ThrowInternalError(op->ctx, "Quickjs::Ref lookup jumped out of Ruby");
+    op->ret = -1;
+  }
+}
+
+static void *ref_run_with_gvl(void *p)
+{
+  struct ref_op *op = p;
+  VMData *data = JS_GetContextOpaque(op->ctx);
+  // As in quickjsrb_log_with_gvl: JS re-entered from here runs with the
+  // GVL held.
+  bool prev = data->gvl_released_js;
+  data->gvl_released_js = false;
+  ref_run_protected(op);
+  data->gvl_released_js = prev;
+  return NULL;
+}
+
+static int ref_run(JSContext *ctx, JSValueConst j_obj, struct ref_op *op, VALUE (*body)(VALUE))
+{
+  op->ctx = ctx;
+  op->pin = JS_GetOpaque(j_obj, ref_class_id);
+  if (op->pin == NULL || op->pin->data == NULL)
+  {
+    JS_ThrowTypeError(ctx, "Quickjs::Ref outlived its VM");
+    return -1;
+  }
+  op->body = body;
+  op->ret = 0;
+  VMData *data = JS_GetContextOpaque(ctx);
+  if (data->gvl_released_js)
+    rb_thread_call_with_gvl(ref_run_with_gvl, op);
+  else
+    ref_run_protected(op);
+  return op->ret;
+}
+
+// True when name is a canonical array index ("0", "17", not "017" or
+// "4294967295"), with the index in *index. QuickJS keeps such keys as
+// tagged-int atoms but JS_AtomToValue hands them back as Strings, so the
+// index is re-read from the text.
+static bool ref_array_index(const char *name, size_t len, uint32_t *index)
+{
+  if (len == 0 || len > 10 || (len > 1 && name[0] == '0'))
+    return false;
+  uint64_t n = 0;
+  for (size_t i = 0; i < len; i++)
+  {
+    if (name[i] < '0' || name[i] > '9')
+      return false;
+    n = n * 10 + (uint64_t)(name[i] - '0');
+  }
+  if (n >= UINT32_MAX)
+    return false;
+  *index = (uint32_t)n;
+  return true;
+}
+
+// Reads the property `atom` names off r_obj: an index or `length` on an
+// Array; otherwise the String key, then the Symbol key (if that Symbol
+// exists), then an Integer key for index-like names. Qundef when absent,
+// including for JS Symbol keys. *enumerable is false for `length`.
+static VALUE ref_lookup(JSContext *ctx, VALUE r_obj, JSAtom atom, bool *enumerable)
+{
+  *enumerable = true;
+  JSValue j_key = JS_AtomToValue(ctx, atom);
+  if (!JS_IsString(j_key))
+  {
+    JS_FreeValue(ctx, j_key);
+    return Qundef;
+  }
+  size_t len;
+  const char *name = JS_ToCStringLen(ctx, &len, j_key);
+  JS_FreeValue(ctx, j_key);
+  if (name == NULL)
+    return Qundef;
+  uint32_t index;
+  bool is_index = ref_array_index(name, len, &index);
+  VALUE r_name = rb_utf8_str_new(name, (long)len);
+  JS_FreeCString(ctx, name);
+
+  if (RB_TYPE_P(r_obj, T_ARRAY))
+  {
+    if (is_index)
+      return (long)index < RARRAY_LEN(r_obj) ? RARRAY_AREF(r_obj, index) : Qundef;
+    if (RSTRING_LEN(r_name) != 6 || memcmp(RSTRING_PTR(r_name), "length", 6) != 0)
+      return Qundef;
+    *enumerable = false;
+    return LONG2NUM(RARRAY_LEN(r_obj));
+  }
+
+  VALUE r_keys[3] = {r_name, Qnil, is_index ? UINT2NUM(index) : Qnil};
+  ID id = rb_check_id(&r_name);
+  if (id)
+    r_keys[1] = ID2SYM(id);
+  for (int i = 0; i < 3; i++)
+  {
+    if (NIL_P(r_keys[i]))
+      continue;
+    if (RB_TYPE_P(r_obj, T_HASH))
+    {
+      VALUE r_value = rb_hash_lookup2(r_obj, r_keys[i], Qundef);
+      if (r_value != Qundef)
+        return r_value;
+    }
+    else
+    {
+      VALUE r_value = rb_funcall(r_obj, id_aref, 1, r_keys[i]);
+      if (!NIL_P(r_value))
+        return r_value;
+    }
+  }
+  return Qundef;
+}
+
+static VALUE ref_get_own_property_body(VALUE p)
+{
+  struct ref_op *op = (struct ref_op *)p;
+  bool enumerable;
+  VALUE r_value = ref_lookup(op->ctx, op->pin->r_obj, op->atom, &enumerable);
+  if (r_value == Qundef)
+    return Qnil;
+  if (op->desc != NULL)
+  {
+    JSValue j_value = ref_value_to_js(op->ctx, op->pin, r_value);
+    if (JS_IsException(j_value))
+    {
+      op->ret = -1;
+      return Qnil;
+    }
+    op->desc->flags = enumerable ? JS_PROP_ENUMERABLE : 0;
+    op->desc->value = j_value;
+    op->desc->getter = JS_UNDEFINED;
+    op->desc->setter = JS_UNDEFINED;
+  }
+  op->ret = 1;
+  return Qnil;
+}
+
+static int ref_get_own_property(JSContext *ctx, JSPropertyDescriptor *desc, JSValueConst j_obj, JSAtom atom)
+{
+  struct ref_op op = {.atom = atom, .desc = desc};
+  return ref_run(ctx, j_obj, &op, ref_get_own_property_body);
+}
+
+// Names are gathered as Ruby Strings first (to_s on an odd key can
+// raise), then interned without calling back into Ruby.
+static VALUE ref_get_own_property_names_body(VALUE p)
+{
+  struct ref_op *op = (struct ref_op *)p;
+  JSContext *ctx = op->ctx;
+  VALUE r_obj = op->pin->r_obj;
+  bool is_array = RB_TYPE_P(r_obj, T_ARRAY);
+  VALUE r_names = Qnil;
+  long count;
+  if (is_array)
+  {
+    count = RARRAY_LEN(r_obj) + 1;
+  }
+  else
+  {
+    VALUE r_keys = rb_check_array_type(rb_funcall(r_obj, id_keys, 0));
+    if (NIL_P(r_keys))
+      rb_raise(rb_eTypeError, "%" PRIsVALUE "#keys didn't return an Array", rb_obj_class(r_obj));
+    count = RARRAY_LEN(r_keys);
+    r_names = rb_ary_new_capa(count);
+    for (long i = 0; i < count; i++)
+    {
+      VALUE r_key = RARRAY_AREF(r_keys, i);
+      rb_ary_push(r_names, SYMBOL_P(r_key) ? rb_sym2str(r_key) : rb_obj_as_string(r_key));
+    }
+  }
+
+  JSPropertyEnum *tab = js_malloc(ctx, sizeof(JSPropertyEnum) * (count > 0 ? count : 1));
+  if (tab == NULL)
+  {
+    op->ret = -1;
+    return Qnil;
+  }
+  for (long i = 0; i < count; i++)
+  {
+    bool is_length = is_array && i == count - 1;
+    JSAtom atom = is_length  ? JS_NewAtom(ctx, "length")
+                  : is_array ? JS_NewAtomUInt32(ctx, (uint32_t)i)
+                             : JS_NewAtomLen(ctx, RSTRING_PTR(RARRAY_AREF(r_names, i)),
+                                             (size_t)RSTRING_LEN(RARRAY_AREF(r_names, i)));
+    if (atom == JS_ATOM_NULL)
+    {
+      for (long j = 0; j < i; j++)
+        JS_FreeAtom(ctx, tab[j].atom);
+      js_free(ctx, tab);
+      op->ret = -1;
+      return Qnil;
+    }
+    tab[i].atom = atom;
+    tab[i].is_enumerable = !is_length;
+  }
+  *op->ptab = tab;
+  *op->plen = (uint32_t)count;
+  RB_GC_GUARD(r_names);
+  return Qnil;
+}
+
+static int ref_get_own_property_names(JSContext *ctx, JSPropertyEnum **ptab, uint32_t *plen, JSValueConst j_obj)
+{
+  struct ref_op op = {.ptab = ptab, .plen = plen};
+  return ref_run(ctx, j_obj, &op, ref_get_own_property_names_body);
+}
+
+static int ref_define_own_property(JSContext *ctx, JSValueConst this_obj, JSAtom prop, JSValueConst val,
+                                   JSValueConst getter, JSValueConst setter, int flags)
+{
+  JS_ThrowTypeError(ctx, "Quickjs::Ref is read-only");
+  return -1;
+}
+
+static int ref_delete_property(JSContext *ctx, JSValueConst obj, JSAtom prop)
+{
+  JS_ThrowTypeError(ctx, "Quickjs::Ref is read-only");
+  return -1;
+}
+
+static VALUE ref_m_initialize(VALUE r_self, VALUE r_obj)
+{
+  if (!RB_TYPE_P(r_obj, T_HASH) && !RB_TYPE_P(r_obj, T_ARRAY) &&
+      !(rb_respond_to(r_obj, id_aref) && rb_respond_to(r_obj, id_keys)))
+    rb_raise(rb_eTypeError, "Quickjs::Ref wraps a Hash, an Array or an object with [] and keys, not %" PRIsVALUE,
+             rb_obj_class(r_obj));
+  rb_ivar_set(r_self, id_object, r_obj);
+  return r_self;
+}
+
+static VALUE ref_m_object(VALUE r_self)
+{
+  return rb_ivar_get(r_self, id_object);
+}
+
+void quickjsrb_init_ref(VALUE r_module)
+{
+  id_object = rb_intern("@object");
+  id_aref = rb_intern("[]");
+  id_keys = rb_intern("keys");
+
+  JS_NewClassID(&ref_class_id);
+  ref_exotic.get_own_property = ref_get_own_property;
+  ref_exotic.get_own_property_names = ref_get_own_property_names;
+  ref_exotic.define_own_property = ref_define_own_property;
+  ref_exotic.delete_property = ref_delete_property;
+
+  quickjsrb_class_ref = rb_define_class_under(r_module, "Ref", rb_cObject);
+  rb_gc_register_address(&quickjsrb_class_ref);
+  rb_define_method(quickjsrb_class_ref, "initialize", ref_m_initialize, 1);
+  rb_define_method(quickjsrb_class_ref, "object", ref_m_object, 0);
+}
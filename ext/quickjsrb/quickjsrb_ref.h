@@ -0,0 +1,21 @@
+#ifndef QUICKJSRB_REF_H
+#define QUICKJSRB_REF_H 1
+
+// Included after quickjsrb.h.
+
+// Quickjs::Ref.new(obj) reaches JS as a read-only exotic object whose
+// properties are looked up on obj (`[]`, `size`, `keys`) when JS reads
+// them, instead of a copy of the whole Hash or Array. Hash and Array
+// values read through it come back as further such objects.
+extern VALUE quickjsrb_class_ref;
+
+// The JS object for a Quickjs::Ref, or JS_EXCEPTION.
+JSValue quickjsrb_ref_to_js(JSContext *ctx, VALUE r_ref);
+
+// The Ruby object behind j_val when it's one of those JS objects (nil
+// once its VM let go of it); Qundef for anything else.
+VALUE quickjsrb_ref_from_js(JSValueConst j_val);
+
+void quickjsrb_init_ref(VALUE r_module);
+
+#endif /* QUICKJSRB_REF_H */
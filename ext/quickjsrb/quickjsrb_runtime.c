@@ -0,0 +1,264 @@
+#include "quickjsrb.h"
+#include "quickjsrb_runtime.h"
+
+// Quickjs::Runtime wraps a QuickjsrbRuntime. DATA_PTR is NULL before
+// initialize and after dispose!; Ruby skips dmark/dfree for a NULL pointer.
+
+static void runtime_mark(void *ptr)
+{
+  QuickjsrbRuntime *shared = (QuickjsrbRuntime *)ptr;
+  rb_gc_mark_movable(shared->contexts);
+  rb_gc_mark_movable(shared->retired);
+}
+
+static void runtime_compact(void *ptr)
+{
+  QuickjsrbRuntime *shared = (QuickjsrbRuntime *)ptr;
+  shared->contexts = rb_gc_location(shared->contexts);
+  shared->retired = rb_gc_location(shared->retired);
+}
+
+static void runtime_free(void *ptr)
+{
+  quickjsrb_runtime_release((QuickjsrbRuntime *)ptr);
+}
+
+// Includes the JS heap every context on the runtime draws from; their
+// own VM wrappers leave it out.
+static size_t runtime_size(const void *ptr)
+{
+  return sizeof(QuickjsrbRuntime) + ((const QuickjsrbRuntime *)ptr)->heap.bytes;
+}
+
+static const rb_data_type_t runtime_type = {
+    .wrap_struct_name = "quickjsruntime",
+    .function = {
+        .dmark = runtime_mark,
+        .dfree = runtime_free,
+        .dsize = runtime_size,
+        .dcompact = runtime_compact,
+    },
+    .flags = RUBY_TYPED_FREE_IMMEDIATELY,
+};
+
+void quickjsrb_runtime_release(QuickjsrbRuntime *shared)
+{
+  if (--shared->refcount > 0)
+    return;
+
+  JS_SetInterruptHandler(shared->runtime, NULL, NULL);
+  js_std_free_handlers(shared->runtime);
+  JS_FreeRuntime(shared->runtime);
+  quickjsrb_heap_forget(&shared->heap);
+  free(shared);
+}
+
+static void raise_runtime_disposed(void)
+{
+  VALUE r_msg = rb_str_new2("Runtime has been disposed; create a new Quickjs::Runtime");
+  rb_exc_raise(rb_funcall(QUICKJSRB_ERROR_FOR(QUICKJSRB_ROOT_RUNTIME_ERROR), rb_intern("new"), 2, r_msg, Qnil));
+}
+
+QuickjsrbRuntime *quickjsrb_runtime_from_value(VALUE r_runtime)
+{
+  if (!rb_typeddata_is_kind_of(r_runtime, &runtime_type))
+    rb_raise(rb_eTypeError, "runtime: must be a Quickjs::Runtime, got %s", rb_obj_classname(r_runtime));
+
+  QuickjsrbRuntime *shared = DATA_PTR(r_runtime);
+  if (shared == NULL)
+    raise_runtime_disposed();
+  return shared;
+}
+
+void quickjsrb_runtime_attach(QuickjsrbRuntime *shared, VALUE r_vm)
+{
+  shared->refcount++;
+  rb_hash_aset(shared->contexts, r_vm, Qtrue);
+}
+
+void quickjsrb_runtime_detach(QuickjsrbRuntime *shared, VALUE r_vm)
+{
+  rb_hash_delete(shared->contexts, r_vm);
+  if (JS_IsJobPending(shared->runtime))
+    rb_ary_push(shared->retired, r_vm);
+}
+
+void quickjsrb_runtime_enter(QuickjsrbRuntime *shared)
+{
+  VALUE r_thread = rb_thread_current();
+  if (shared->active_depth > 0 && shared->active_thread != r_thread)
+    rb_raise(rb_eThreadError, "another thread is evaluating on a context of this Quickjs::Runtime");
+
+  if (shared->active_depth == 0)
+  {
+    // Retired contexts only need pinning while a queued job could still
+    // run against them; an idle, drained runtime lets them go.
+    if (RARRAY_LEN(shared->retired) > 0 && !JS_IsJobPending(shared->runtime))
+      rb_ary_clear(shared->retired);
+    // The runtime records one native stack top, taken from whichever
+    // thread created it; re-anchor it for the thread entering now so a
+    // context used from another thread doesn't trip a false overflow.
+    JS_UpdateStackTop(shared->runtime);
+    shared->active_thread = r_thread;
+  }
+  shared->active_depth++;
+}
+
+void quickjsrb_runtime_leave(QuickjsrbRuntime *shared)
+{
+  if (--shared->active_depth == 0)
+    shared->active_thread = Qnil;
+}
+
+struct runtime_create_args
+{
+  QuickjsrbHeap *heap;
+  JSRuntime *runtime;
+};
+
+static void *runtime_create_no_gvl(void *p)
+{
+  struct runtime_create_args *args = p;
+  args->runtime = JS_NewRuntime2(&quickjsrb_tracked_malloc_functions, args->heap);
+  args->heap->runtime = args->runtime;
+  return NULL;
+}
+
+static VALUE runtime_alloc(VALUE r_klass)
+{
+  return TypedData_Wrap_Struct(r_klass, &runtime_type, NULL);
+}
+
+static VALUE runtime_m_initialize(int argc, VALUE *argv, VALUE r_self)
+{
+  VALUE r_opts;
+  rb_scan_args(argc, argv, ":", &r_opts);
+  if (NIL_P(r_opts))
+    r_opts = rb_hash_new();
+
+  if (DATA_PTR(r_self) != NULL)
+    rb_raise(rb_eArgError, "Quickjs::Runtime is already initialized");
+
+  VALUE r_memory_limit = rb_hash_aref(r_opts, ID2SYM(rb_intern("memory_limit")));
+  if (NIL_P(r_memory_limit))
+    r_memory_limit = UINT2NUM(1024 * 1024 * 128);
+  VALUE r_max_stack_size = rb_hash_aref(r_opts, ID2SYM(rb_intern("max_stack_size")));
+  if (NIL_P(r_max_stack_size))
+    r_max_stack_size = UINT2NUM(1024 * 1024 * 4);
+  size_t memory_limit = NUM2UINT(r_memory_limit);
+  size_t max_stack_size = NUM2UINT(r_max_stack_size);
+
+  VALUE r_contexts = rb_hash_new();
+  VALUE r_retired = rb_ary_new();
+  quickjsrb_global_await_headroom();
+
+  // Allocated first: the runtime's allocator writes into shared->heap.
+  QuickjsrbRuntime *shared = malloc(sizeof(QuickjsrbRuntime));
+  if (shared == NULL)
+    rb_raise(rb_eNoMemError, "failed to allocate a QuickJS runtime");
+  shared->heap.bytes = 0;
+  shared->heap.reported = 0;
+  shared->heap.allocations = 0;
+  shared->heap.runtime = NULL;
+  shared->heap.pressure_gc_requested = false;
+  shared->heap.global_refused = false;
+
+  struct runtime_create_args args = {&shared->heap, NULL};
+  rb_thread_call_without_gvl(runtime_create_no_gvl, &args, NULL, NULL);
+  if (args.runtime == NULL)
+  {
+    free(shared);
+    rb_raise(rb_eNoMemError, "failed to allocate a QuickJS runtime");
+  }
+  shared->runtime = args.runtime;
+  shared->refcount = 1; // the wrapper's own reference
+  shared->active_depth = 0;
+  shared->active_thread = Qnil;
+  shared->interrupt_opaque = NULL;
+  shared->contexts = r_contexts;
+  shared->retired = r_retired;
+
+  JS_SetMemoryLimit(shared->runtime, memory_limit);
+  JS_SetMaxStackSize(shared->runtime, max_stack_size);
+  quickjsrb_install_runtime_hooks(shared->runtime);
+
+  DATA_PTR(r_self) = shared;
+  quickjsrb_heap_sync(&shared->heap);
+  RB_GC_GUARD(r_contexts);
+  RB_GC_GUARD(r_retired);
+  return r_self;
+}
+
+static QuickjsrbRuntime *runtime_get_live(VALUE r_self)
+{
+  QuickjsrbRuntime *shared = rb_check_typeddata(r_self, &runtime_type);
+  if (shared == NULL)
+    raise_runtime_disposed();
+  return shared;
+}
+
+// Totals for the whole runtime — every context on it draws from the same
+// heap, so this is also what each of their VM#memory_usage reports.
+static VALUE runtime_m_memory_usage(VALUE r_self)
+{
+  return quickjsrb_memory_usage_hash(runtime_get_live(r_self)->runtime);
+}
+
+static VALUE runtime_m_gc(VALUE r_self)
+{
+  QuickjsrbRuntime *shared = runtime_get_live(r_self);
+  JS_RunGC(shared->runtime);
+  quickjsrb_heap_sync(&shared->heap);
+  return Qnil;
+}
+
+static VALUE runtime_m_heap_bytes(VALUE r_self)
+{
+  return SIZET2NUM(runtime_get_live(r_self)->heap.bytes);
+}
+
+static VALUE runtime_m_context_count(VALUE r_self)
+{
+  QuickjsrbRuntime *shared = rb_check_typeddata(r_self, &runtime_type);
+  return shared == NULL ? INT2NUM(0) : SIZET2NUM(RHASH_SIZE(shared->contexts));
+}
+
+// Disposes every live context, then drops the wrapper's reference so the
+// JSRuntime is freed now rather than when Ruby collects the last VM.
+static VALUE runtime_m_dispose(VALUE r_self)
+{
+  QuickjsrbRuntime *shared = rb_check_typeddata(r_self, &runtime_type);
+  if (shared == NULL)
+    return Qnil;
+
+  if (shared->active_depth > 0)
+    rb_raise(rb_eThreadError, "cannot dispose a Quickjs::Runtime while one of its contexts is evaluating");
+
+  VALUE r_vms = rb_funcall(shared->contexts, rb_intern("keys"), 0);
+  for (long i = 0; i < RARRAY_LEN(r_vms); i++)
+    rb_funcall(RARRAY_AREF(r_vms, i), rb_intern("dispose!"), 0);
+
+  rb_hash_clear(shared->contexts);
+  rb_ary_clear(shared->retired);
+  DATA_PTR(r_self) = NULL;
+  quickjsrb_runtime_release(shared);
+  return Qnil;
+}
+
+static VALUE runtime_m_disposed(VALUE r_self)
+{
+  return rb_check_typeddata(r_self, &runtime_type) == NULL ? Qtrue : Qfalse;
+}
+
+void quickjsrb_init_runtime_class(VALUE r_module)
+{
+  VALUE r_class_runtime = rb_define_class_under(r_module, "Runtime", rb_cObject);
+  rb_define_alloc_func(r_class_runtime, runtime_alloc);
+  rb_define_method(r_class_runtime, "initialize", runtime_m_initialize, -1);
+  rb_define_method(r_class_runtime, "memory_usage", runtime_m_memory_usage, 0);
+  rb_define_method(r_class_runtime, "gc!", runtime_m_gc, 0);
+  rb_define_method(r_class_runtime, "heap_bytes", runtime_m_heap_bytes, 0);
+  rb_define_method(r_class_runtime, "context_count", runtime_m_context_count, 0);
+  rb_define_method(r_class_runtime, "dispose!", runtime_m_dispose, 0);
+  rb_define_method(r_class_runtime, "disposed?", runtime_m_disposed, 0);
+}
@@ -0,0 +1,30 @@
+#ifndef QUICKJSRB_RUNTIME_H
+#define QUICKJSRB_RUNTIME_H 1
+
+// Included after quickjsrb.h, which defines QuickjsrbRuntime and VMData.
+
+void quickjsrb_init_runtime_class(VALUE r_module);
+
+// Resolves a VM's `runtime:` option. Raises TypeError for anything other
+// than a Quickjs::Runtime and Quickjs::RuntimeError for a disposed one.
+QuickjsrbRuntime *quickjsrb_runtime_from_value(VALUE r_runtime);
+
+// A context joining / leaving the runtime. Joining takes a reference;
+// leaving (VM#dispose!) drops the strong ref from `contexts`, parking the
+// VM in `retired` while jobs that may target it are still queued. The
+// reference itself goes through quickjsrb_runtime_release at teardown.
+void quickjsrb_runtime_attach(QuickjsrbRuntime *shared, VALUE r_vm);
+void quickjsrb_runtime_detach(QuickjsrbRuntime *shared, VALUE r_vm);
+
+// Bracket every JS execution on a shared-runtime context. enter raises
+// ThreadError when another thread is mid-JS on the same runtime.
+void quickjsrb_runtime_enter(QuickjsrbRuntime *shared);
+void quickjsrb_runtime_leave(QuickjsrbRuntime *shared);
+
+// Defined in quickjsrb.c: runtime-wide hooks every context on a shared
+// runtime relies on (rejection tracker, module hooks, std handlers), and
+// the memory_usage Hash VM#memory_usage and Runtime#memory_usage share.
+void quickjsrb_install_runtime_hooks(JSRuntime *runtime);
+VALUE quickjsrb_memory_usage_hash(JSRuntime *runtime);
+
+#endif /* QUICKJSRB_RUNTIME_H */
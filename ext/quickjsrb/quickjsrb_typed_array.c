@@ -0,0 +1,162 @@
+#include "quickjsrb.h"
+#include "quickjsrb_typed_array.h"
+
+VALUE quickjsrb_class_float64_array = Qnil;
+VALUE quickjsrb_class_int32_array = Qnil;
+
+static ID id_bytes;
+
+static bool typed_array_float_p(VALUE r_self)
+{
+  return RTEST(rb_obj_is_kind_of(r_self, quickjsrb_class_float64_array));
+}
+
+static long typed_array_element_size(bool is_float)
+{
+  return is_float ? (long)sizeof(double) : (long)sizeof(int32_t);
+}
+
+static VALUE typed_array_bytes(VALUE r_self)
+{
+  VALUE r_bytes = rb_ivar_get(r_self, id_bytes);
+  if (!RB_TYPE_P(r_bytes, T_STRING))
+    rb_raise(rb_eTypeError, "uninitialized %" PRIsVALUE, rb_obj_class(r_self));
+  return r_bytes;
+}
+
+// memcpy rather than a cast: the String's buffer has no alignment promise.
+static VALUE typed_array_element(const char *ptr, long i, bool is_float)
+{
+  if (is_float)
+  {
+    double d;
+    memcpy(&d, ptr + i * (long)sizeof(double), sizeof(double));
+    return DBL2NUM(d);
+  }
+  int32_t n;
+  memcpy(&n, ptr + i * (long)sizeof(int32_t), sizeof(int32_t));
+  return INT2NUM(n);
+}
+
+// Packs in one pass into a String sized up front. NUM2DBL and NUM2INT can
+// call back into Ruby (to_f on a Rational), which may shrink the Array, so
+// its length is re-read as we go. Int32Array raises RangeError for values
+// outside 32 bits rather than wrapping them.
+static VALUE typed_array_m_initialize(VALUE r_self, VALUE r_values)
+{
+  r_values = rb_convert_type(r_values, T_ARRAY, "Array", "to_ary");
+  bool is_float = typed_array_float_p(r_self);
+  long element_size = typed_array_element_size(is_float);
+  long len = RARRAY_LEN(r_values);
+  if (len > LONG_MAX / element_size)
+    rb_raise(rb_eArgError, "too many elements for %" PRIsVALUE, rb_obj_class(r_self));
+
+  VALUE r_bytes = rb_str_new(NULL, len * element_size);
+  long i = 0;
+  for (; i < len && i < RARRAY_LEN(r_values); i++)
+  {
+    VALUE r_element = RARRAY_AREF(r_values, i);
+    char *dst = RSTRING_PTR(r_bytes) + i * element_size;
+    if (is_float)
+    {
+      double d = NUM2DBL(r_element);
+      memcpy(dst, &d, sizeof(double));
+    }
+    else
+    {
+      int32_t n = NUM2INT(r_element);
+      memcpy(dst, &n, sizeof(int32_t));
+    }
+  }
+  rb_str_set_len(r_bytes, i * element_size);
+  rb_ivar_set(r_self, id_bytes, rb_obj_freeze(r_bytes));
+  return r_self;
+}
+
+static VALUE typed_array_m_size(VALUE r_self)
+{
+  return LONG2NUM(RSTRING_LEN(typed_array_bytes(r_self)) / typed_array_element_size(typed_array_float_p(r_self)));
+}
+
+static VALUE typed_array_m_aref(VALUE r_self, VALUE r_index)
+{
+  VALUE r_bytes = typed_array_bytes(r_self);
+  bool is_float = typed_array_float_p(r_self);
+  long len = RSTRING_LEN(r_bytes) / typed_array_element_size(is_float);
+  long i = NUM2LONG(r_index);
+  if (i < 0)
+    i += len;
+  if (i < 0 || i >= len)
+    return Qnil;
+  return typed_array_element(RSTRING_PTR(r_bytes), i, is_float);
+}
+
+static VALUE typed_array_m_to_a(VALUE r_self)
+{
+  VALUE r_bytes = typed_array_bytes(r_self);
+  bool is_float = typed_array_float_p(r_self);
+  long len = RSTRING_LEN(r_bytes) / typed_array_element_size(is_float);
+  VALUE r_array = rb_ary_new_capa(len);
+  for (long i = 0; i < len; i++)
+    rb_ary_push(r_array, typed_array_element(RSTRING_PTR(r_bytes), i, is_float));
+  RB_GC_GUARD(r_bytes);
+  return r_array;
+}
+
+// The packed elements, in native byte order.
+static VALUE typed_array_m_bytes(VALUE r_self)
+{
+  return typed_array_bytes(r_self);
+}
+
+JSValue quickjsrb_typed_array_to_js(JSContext *ctx, VALUE r_array)
+{
+  VMData *data = JS_GetContextOpaque(ctx);
+  VALUE r_bytes = typed_array_bytes(r_array);
+  JSValue j_ctor = typed_array_float_p(r_array) ? data->j_float64array_ctor : data->j_int32array_ctor;
+  if (!JS_IsObject(j_ctor))
+    return to_js_value(ctx, typed_array_m_to_a(r_array));
+
+  JSValue j_buf = JS_NewArrayBufferCopy(ctx, (const uint8_t *)RSTRING_PTR(r_bytes), (size_t)RSTRING_LEN(r_bytes));
+  if (JS_IsException(j_buf))
+    return j_buf;
+  JSValue j_array = JS_CallConstructor(ctx, j_ctor, 1, (JSValueConst *)&j_buf);
+  JS_FreeValue(ctx, j_buf);
+  return j_array;
+}
+
+VALUE quickjsrb_typed_array_from_js(VALUE r_bytes, QuickjsrbObjectKind kind)
+{
+  VALUE r_class;
+  if (kind == QUICKJSRB_OBJECT_FLOAT64_ARRAY)
+    r_class = quickjsrb_class_float64_array;
+  else if (kind == QUICKJSRB_OBJECT_INT32_ARRAY)
+    r_class = quickjsrb_class_int32_array;
+  else
+    return r_bytes;
+
+  VALUE r_array = rb_obj_alloc(r_class);
+  rb_ivar_set(r_array, id_bytes, rb_obj_freeze(r_bytes));
+  return r_array;
+}
+
+static VALUE define_typed_array_class(VALUE r_module, const char *name)
+{
+  VALUE r_class = rb_define_class_under(r_module, name, rb_cObject);
+  rb_define_method(r_class, "initialize", typed_array_m_initialize, 1);
+  rb_define_method(r_class, "size", typed_array_m_size, 0);
+  rb_define_method(r_class, "[]", typed_array_m_aref, 1);
+  rb_define_method(r_class, "to_a", typed_array_m_to_a, 0);
+  rb_define_method(r_class, "bytes", typed_array_m_bytes, 0);
+  return r_class;
+}
+
+void quickjsrb_init_typed_array(VALUE r_module)
+{
+  id_bytes = rb_intern("@bytes");
+
+  quickjsrb_class_float64_array = define_typed_array_class(r_module, "Float64Array");
+  rb_gc_register_address(&quickjsrb_class_float64_array);
+  quickjsrb_class_int32_array = define_typed_array_class(r_module, "Int32Array");
+  rb_gc_register_address(&quickjsrb_class_int32_array);
+}
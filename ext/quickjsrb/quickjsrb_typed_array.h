@@ -0,0 +1,24 @@
+#ifndef QUICKJSRB_TYPED_ARRAY_H
+#define QUICKJSRB_TYPED_ARRAY_H 1
+
+// Included after quickjsrb.h.
+
+// Quickjs::Float64Array and Quickjs::Int32Array hold numbers packed in a
+// frozen binary String (native byte order), so crossing into JS is one
+// ArrayBuffer copy of that String instead of a boxed value per element.
+// JS Float64Array / Int32Array results come back as them the same way.
+extern VALUE quickjsrb_class_float64_array;
+extern VALUE quickjsrb_class_int32_array;
+
+// A new JS typed array over a copy of r_array's elements, or JS_EXCEPTION.
+// Without the typed array intrinsics, a plain JS Array of them.
+JSValue quickjsrb_typed_array_to_js(JSContext *ctx, VALUE r_array);
+
+// r_bytes (quickjsrb_js_buffer_to_rb_str of a JS buffer) wrapped in the
+// matching Ruby class when the buffer's kind is a Float64Array or
+// Int32Array; r_bytes itself for any other buffer.
+VALUE quickjsrb_typed_array_from_js(VALUE r_bytes, QuickjsrbObjectKind kind);
+
+void quickjsrb_init_typed_array(VALUE r_module);
+
+#endif /* QUICKJSRB_TYPED_ARRAY_H */
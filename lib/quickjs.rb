@@ -8,7 +8,15 @@ require_relative "quickjs/crypto_key"
 require_relative "quickjs/function"
 require_relative "quickjs/quickjsrb"
 require_relative "quickjs/runnable"
+require_relative "quickjs/object_ref"
+require_relative "quickjs/typed_array"
 require_relative "quickjs/polyfills"
+require_relative "quickjs/preload"
+require_relative "quickjs/recycle"
+require_relative "quickjs/blueprint"
+require_relative "quickjs/snapshot"
+require_relative "quickjs/runtime"
+require_relative "quickjs/vm_pool"
 
 module Quickjs
   class Blob
@@ -23,6 +31,8 @@ module Quickjs
     eval_opts = {}
     eval_opts[:filename] = overwrite_opts.delete(:filename) if overwrite_opts.key?(:filename)
     eval_opts[:async] = overwrite_opts.delete(:async) if overwrite_opts.key?(:async)
+    eval_opts[:symbolize_names] = overwrite_opts.delete(:symbolize_names) if overwrite_opts.key?(:symbolize_names)
+    eval_opts[:result] = overwrite_opts.delete(:result) if overwrite_opts.key?(:result)
     vm = Quickjs::VM.new(**overwrite_opts)
     vm.eval_code(code, **eval_opts)
   ensure
@@ -0,0 +1,83 @@
+# frozen_string_literal: true
+
+module Quickjs
+  # Remembers how a VM was put together — constructor options and the
+  # define_function bridges registered afterwards — so `reset!` and
+  # `recycle:` can rebuild its context or runtime in the same shape. Procs are kept
+  # by reference and re-registered as they are.
+  module Blueprint
+    def initialize(**opts)
+      super
+      @_blueprint_opts = opts.freeze
+      @_blueprint_functions = []
+    end
+
+    def define_function(*args, &block)
+      result = super
+      @_blueprint_functions << [args.freeze, block]
+      result
+    end
+  end
+
+  VM.prepend(Blueprint) unless VM.ancestors.include?(Blueprint)
+
+  @_baseline_global_names = {}
+  @_baseline_global_names_lock = Mutex.new
+
+  # The globalThis names a VM built with `opts` has before any user code
+  # runs: builtins, polyfill globals, `features:` registrations.
+  # VM#snapshot_to stores only what a VM has beyond these. Built once
+  # per option set on a throwaway VM; registering a polyfill clears it.
+  def self._baseline_global_names(opts)
+    key = opts.except(:runtime)
+    @_baseline_global_names[key] || @_baseline_global_names_lock.synchronize {
+      @_baseline_global_names[key] ||= begin
+        vm = VM.new(**key)
+        vm.send(:_global_names).freeze
+      ensure
+        vm&.dispose!
+      end
+    }
+  end
+
+  def self._forget_baseline_global_names
+    @_baseline_global_names_lock.synchronize { @_baseline_global_names = {} }
+    nil
+  end
+
+  class VM
+    # Puts this VM back to how `initialize` left it, on the same runtime:
+    # globals, top-level `let` / `const`, changes to builtins, and loaded
+    # modules are discarded along with the module resolution caches, then
+    # `features:` and `define_function` bridges are installed afresh.
+    # Polyfills come back as lazy stubs whatever `lazy_polyfills:` says, so
+    # a reset only runs the ones the next script touches. `module_loader`,
+    # `on_log`, and `on_unhandled_rejection` carry over untouched.
+    #
+    # Jobs still queued run first, against the old globals and under the
+    # VM's timeout; what they throw is discarded.
+    def reset!
+      _replay_blueprint(lazy: true) { |features| send(:_reset_context, features) }
+      self
+    end
+
+    private
+
+    # Yields the constructor's features to a primitive that gives the VM a
+    # fresh context (_reset_context, _rebuild_runtime), then re-applies
+    # registered polyfills and define_function bridges onto it. A primitive
+    # returning false did nothing, and neither does this.
+    def _replay_blueprint(lazy: @_blueprint_opts[:lazy_polyfills])
+      features = @_blueprint_opts.fetch(:features, nil) || []
+      return false if yield(features) == false
+      Quickjs._apply_registered_polyfills(self, features, lazy: lazy)
+
+      functions = @_blueprint_functions
+      @_blueprint_functions = []
+      functions.each { |args, block| define_function(*args, &block) }
+      true
+    ensure
+      @_blueprint_functions = functions if functions
+    end
+  end
+end
@@ -0,0 +1,37 @@
+# frozen_string_literal: true
+
+module Quickjs
+  # A JS object left in its VM: `[]`, `dig` and `each` convert only what
+  # they read, handing nested objects back as further ObjectRefs. The VM
+  # stays alive while a ref does; dispose!, reset! or a recycle rebuild
+  # releases every ref on it.
+  class ObjectRef
+    include Enumerable
+
+    # Elements of an array; `[key, value]` pairs of any other object.
+    def each
+      return enum_for(:each) { size } unless block_given?
+
+      if array?
+        size.times { |i| yield self[i] }
+      else
+        keys.each { |key| yield key, self[key] }
+      end
+      self
+    end
+
+    def dig(key, *rest)
+      value = self[key]
+      return value if rest.empty? || !value.respond_to?(:dig)
+
+      value.dig(*rest)
+    end
+  end
+
+  class VM
+    # `eval_code(code, materialize: :lazy, **opts)`.
+    def eval_handle(code, **opts)
+      eval_code(code, **opts, materialize: :lazy)
+    end
+  end
+end
@@ -18,18 +18,26 @@ module Quickjs
   # would have run by then; a pending load raises Quickjs::NoAwaitError
   # instead of handing back a silently half-applied VM.
   #
+  # `globals:` names the globals the polyfill defines (e.g.
+  # `["Intl"]`). It's what lets `VM.new(lazy_polyfills: true)` install the
+  # polyfill as stubs that load on first touch; without it the polyfill is
+  # always loaded eagerly.
+  #
   # Re-registering a name replaces the entry wholesale, lock included: a
   # VM construction already compiling under the old entry finishes
   # against it (and loads the old bytecode) while the first construction
   # under the new entry compiles the new source independently. Each
   # registration compiles at most once; the two compiles can overlap.
-  def self.register_polyfill(name, source:, init: nil)
+  def self.register_polyfill(name, source:, init: nil, globals: nil)
     raise ::TypeError, "name must be a Symbol, got #{name.class}" unless name.is_a?(Symbol)
     raise ::TypeError, "source: must be a String or Proc, got #{source.class}" unless source.is_a?(String) || source.is_a?(Proc)
     raise ::TypeError, "init: must be a String or nil, got #{init.class}" unless init.nil? || init.is_a?(String)
+    unless globals.nil? || (globals.is_a?(Array) && !globals.empty? && globals.all? { |g| g.is_a?(String) || g.is_a?(Symbol) })
+      raise ::TypeError, "globals: must be a non-empty Array of Strings or Symbols, got #{globals.inspect}"
+    end
 
-    @_polyfills[name] = {source: source, init: init&.freeze, bytecode: nil, mutex: Mutex.new}
-    nil
+    @_polyfills[name] = {source: source, init: init&.freeze, globals: globals&.map(&:to_s)&.freeze, bytecode: nil, mutex: Mutex.new}
+    _forget_baseline_global_names
   end
 
   def self._polyfill_for(name)
@@ -38,43 +46,59 @@ module Quickjs
 
   def self._unregister_polyfill(name)
     @_polyfills.delete(name)
-    nil
+    _forget_baseline_global_names
   end
 
-  def self._apply_registered_polyfills(vm, features)
+  def self._apply_registered_polyfills(vm, features, lazy: false)
     features.each do |feature|
       next unless (entry = @_polyfills[feature])
-      # The per-entry mutex makes first-use compilation happen exactly once
-      # even when threads race to construct VMs with the same polyfill —
-      # `||=` alone isn't atomic (`_precompile_polyfill` yields the GVL
-      # inside `Quickjs.compile`), and a losing thread could otherwise
-      # double-compile or read entry[:source] after the winner cleared it.
-      # A compile failure leaves bytecode nil and source intact, so a later
-      # attempt can retry. The unlocked first read keeps the post-compile
-      # hot path (warmer pools constructing VMs concurrently) off the lock;
-      # a stale nil just falls into the synchronize.
-      bytecode = entry[:bytecode] || entry[:mutex].synchronize {
-        entry[:bytecode] ||= begin
-          compiled = _precompile_polyfill(entry, feature)
-          # The Proc / String source isn't needed again once the bytecode
-          # is cached — drop it so its captured scope can be GC'd.
-          entry[:source] = nil
-          entry[:init]   = nil
-          compiled
-        end
-      }
-      begin
-        vm.send(:_load_polyfill_bytecode, bytecode)
-      rescue Quickjs::RuntimeError => e
-        # The C layer only sees bytecode; name the registration so a VM
-        # with several polyfill features points at the one that failed.
-        # `raise e, msg` clones — class, js_name, and any JS backtrace
-        # already set on the original all survive.
-        raise e, "#{feature}: #{e.message}"
-      end
+
+      # One VM#init_profile row per registration, first-use compile
+      # included: that's time VM.new spends too.
+      vm.send(:_init_phase, feature) { _apply_registered_polyfill(vm, feature, entry, lazy) }
+    end
+  end
+
+  def self._apply_registered_polyfill(vm, feature, entry, lazy)
+    bytecode = _polyfill_bytecode(entry, feature)
+    if lazy && entry[:globals]
+      vm.send(:_install_lazy_polyfill, bytecode, entry[:globals])
+      return
+    end
+
+    begin
+      vm.send(:_load_polyfill_bytecode, bytecode)
+    rescue Quickjs::RuntimeError => e
+      # The C layer only sees bytecode; name the registration so a VM
+      # with several polyfill features points at the one that failed.
+      # `raise e, msg` clones — class, js_name, and any JS backtrace
+      # already set on the original all survive.
+      raise e, "#{feature}: #{e.message}"
     end
   end
 
+  def self._polyfill_bytecode(entry, feature)
+    # The per-entry mutex makes first-use compilation happen exactly once
+    # even when threads race to construct VMs with the same polyfill —
+    # `||=` alone isn't atomic (`_precompile_polyfill` yields the GVL
+    # inside `Quickjs.compile`), and a losing thread could otherwise
+    # double-compile or read entry[:source] after the winner cleared it.
+    # A compile failure leaves bytecode nil and source intact, so a later
+    # attempt can retry. The unlocked first read keeps the post-compile
+    # hot path (warmer pools constructing VMs concurrently) off the lock;
+    # a stale nil just falls into the synchronize.
+    entry[:bytecode] || entry[:mutex].synchronize {
+      entry[:bytecode] ||= begin
+        compiled = _precompile_polyfill(entry, feature)
+        # The Proc / String source isn't needed again once the bytecode
+        # is cached — drop it so its captured scope can be GC'd.
+        entry[:source] = nil
+        entry[:init]   = nil
+        compiled
+      end
+    }
+  end
+
   # Compiled once per process per polyfill on a disposable VM whose
   # generous timeout covers parsing multi-MB bundles (e.g. the companion
   # `quickjs-polyfill-intl` gem's FormatJS bundles run a couple MB). The
@@ -90,9 +114,11 @@ module Quickjs
   end
 
   module PolyfillLoader
-    def initialize(features: [], **opts)
+    def initialize(features: [], lazy_polyfills: false, **opts)
       super
-      Quickjs._apply_registered_polyfills(self, features)
+      Quickjs._apply_registered_polyfills(self, features, lazy: lazy_polyfills)
+      # Ends recording; see VM#init_profile.
+      init_profile&.freeze
     end
   end
 
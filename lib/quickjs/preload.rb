@@ -0,0 +1,53 @@
+# frozen_string_literal: true
+
+module Quickjs
+  # For preforking servers (Puma / Unicorn cluster mode, Pitchfork): call
+  # in the master before workers fork, e.g. from Puma's `before_fork`.
+  #
+  # Compiles the registered polyfills named in `features:` and every
+  # source in `sources:` (name => JS String or Runnable) now, and moves
+  # the bytecode into read-only memory that nothing — Ruby's GC, QuickJS,
+  # the extension — ever writes again. Workers then read those pages
+  # straight from the master's copy instead of each dirtying their own:
+  # no first-use compile per worker, and no copy-on-write faults from GC
+  # marking or compaction touching the bytecode Strings. GVL-released
+  # bytecode runs skip their defensive copy of sealed bytecode too.
+  #
+  # Only the bytecode is shared. The objects QuickJS builds from it —
+  # functions, atoms, shapes — are refcounted and live in each VM's own
+  # heap, so every worker still pays for those per VM. Polyfills shipped
+  # with the gem (POLYFILL_FILE, POLYFILL_ENCODING, ...) are compiled into
+  # the extension's read-only data and are already shared; naming them in
+  # `features:` is harmless.
+  #
+  # Returns `sources:` with each value replaced by a Runnable over sealed
+  # bytecode. Sealed memory lives until the process exits, so preload
+  # once, not per request.
+  def self.preload_for_fork(features: [], sources: {})
+    raise ::TypeError, "features: must be an Array, got #{features.class}" unless features.is_a?(Array)
+    raise ::TypeError, "sources: must be a Hash, got #{sources.class}" unless sources.is_a?(Hash)
+
+    features.each do |feature|
+      next unless (entry = @_polyfills[feature])
+
+      _polyfill_bytecode(entry, feature)
+      entry[:mutex].synchronize { entry[:bytecode] = _seal_bytes(entry[:bytecode]) }
+    end
+
+    sources.to_h do |name, source|
+      runnable =
+        case source
+        when Runnable then source
+        when String then compile(source, filename: name.to_s, timeout_msec: 60_000)
+        else raise ::TypeError, "sources: values must be Strings or Runnables, got #{source.class} for #{name.inspect}"
+        end
+      [name, Runnable.new(_seal_bytes(runnable.to_s))]
+    end
+  end
+
+  # `sealed_bytes` is the total held in read-only memory by
+  # `preload_for_fork`.
+  def self.preload_stats
+    {sealed_bytes: _sealed_bytes}
+  end
+end
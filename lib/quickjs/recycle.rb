@@ -0,0 +1,102 @@
+# frozen_string_literal: true
+
+module Quickjs
+  # VM.new(recycle: { max_evals:, max_heap_bytes:, on_poison: }). Before
+  # each eval_code / call / import / Runnable#run, a VM past one of its
+  # limits swaps its runtime for a fresh one built with the same options,
+  # features, and define_function bridges (see VM#_rebuild_runtime), so a
+  # long-lived VM sheds the shapes, atoms, and leaked globals it piled up.
+  # Never mid-eval: a bridge re-entering eval defers the rebuild to the
+  # next top-level one.
+  #
+  # `max_evals:` counts evals since the last rebuild; `max_heap_bytes:`
+  # is checked against `heap_bytes`. `on_poison: :rebuild` rebuilds a
+  # `memory_poisoned?` VM instead of letting the eval raise; the default,
+  # `:raise`, keeps the poisoned VM as it is.
+  module Recycler
+    RECYCLE_KEYS = %i[max_evals max_heap_bytes on_poison].freeze
+    private_constant :RECYCLE_KEYS
+
+    def initialize(recycle: nil, **opts)
+      policy = Recycler.policy_from(recycle, opts)
+      super(**opts)
+      @_recycle = policy
+      @_recycle_evals = 0
+      @_recycle_count = 0
+    end
+
+    def self.policy_from(recycle, opts)
+      return nil if recycle.nil?
+      raise ::TypeError, "recycle: must be a Hash, got #{recycle.class}" unless recycle.is_a?(Hash)
+
+      unknown = recycle.keys - RECYCLE_KEYS
+      raise ::ArgumentError, "unknown recycle: keys #{unknown.inspect}" unless unknown.empty?
+      %i[max_evals max_heap_bytes].each do |key|
+        value = recycle[key]
+        unless value.nil? || (value.is_a?(Integer) && value.positive?)
+          raise ::ArgumentError, "recycle: #{key}: must be a positive Integer, got #{value.inspect}"
+        end
+      end
+      on_poison = recycle.fetch(:on_poison, :raise)
+      unless %i[raise rebuild].include?(on_poison)
+        raise ::ArgumentError, "recycle: on_poison: must be :raise or :rebuild, got #{on_poison.inspect}"
+      end
+      # A shared runtime's heap and poisoning belong to every VM on it.
+      raise ::ArgumentError, "recycle: needs a private runtime; it can't be combined with runtime:" if opts[:runtime]
+
+      recycle.merge(on_poison: on_poison).freeze
+    end
+
+    def eval_code(...)
+      _recycle_point
+      super
+    end
+
+    def call(...)
+      _recycle_point
+      super
+    end
+
+    def call_json(...)
+      _recycle_point
+      super
+    end
+
+    def import(...)
+      _recycle_point
+      super
+    end
+
+    # Times this VM's runtime has been rebuilt by its recycle: policy.
+    def recycle_count
+      @_recycle_count
+    end
+
+    private
+
+    def _run_bytecode(...)
+      _recycle_point
+      super
+    end
+
+    def _recycle_point
+      policy = @_recycle
+      return unless policy && !disposed?
+
+      due =
+        if memory_poisoned?
+          policy[:on_poison] == :rebuild
+        else
+          (policy[:max_evals] && @_recycle_evals >= policy[:max_evals]) ||
+            (policy[:max_heap_bytes] && heap_bytes >= policy[:max_heap_bytes])
+        end
+      if due && _replay_blueprint { |features| send(:_rebuild_runtime, features) }
+        @_recycle_evals = 0
+        @_recycle_count += 1
+      end
+      @_recycle_evals += 1
+    end
+  end
+
+  VM.prepend(Recycler) unless VM.ancestors.include?(Recycler)
+end
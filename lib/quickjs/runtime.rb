@@ -0,0 +1,10 @@
+# frozen_string_literal: true
+
+module Quickjs
+  class Runtime
+    # Shorthand for `Quickjs::VM.new(runtime: self, **vm_opts)`.
+    def new_context(**vm_opts)
+      Quickjs::VM.new(runtime: self, **vm_opts)
+    end
+  end
+end
@@ -0,0 +1,178 @@
+# frozen_string_literal: true
+
+module Quickjs
+  class VM
+    # A snapshot file is the magic, a format number, then length-prefixed
+    # fields: gem version, QuickJS version, platform, constructor options,
+    # and the globals blob. Nothing past the versions is parsed until they
+    # match, and nothing is read with Marshal: options are a small tagged
+    # encoding of the plain values VM.new takes, and the globals go to
+    # _load_globals, which reads data only, never bytecode.
+    SNAPSHOT_MAGIC = "QJSRBSNP".b.freeze
+    SNAPSHOT_FORMAT = 2
+    private_constant :SNAPSHOT_MAGIC, :SNAPSHOT_FORMAT
+
+    # Writes this VM's constructor options and its post-construction data
+    # globals to `path`. The globals blob is QuickJS's own serialization
+    # format, which only the same QuickJS build can read back, so the file
+    # also records the gem version, QuickJS version, and platform.
+    #
+    # What counts as "post-construction" is decided against what a VM
+    # built with the same options has on `globalThis` (builtins, polyfill
+    # globals, `features:` registrations), which `restore` re-creates
+    # rather than stores. A shared `runtime:` isn't recorded; pass one to
+    # `restore` to put the restored VM on it.
+    def snapshot_to(path)
+      options = @_blueprint_opts.except(:runtime)
+      globals = send(:_dump_globals, Quickjs._baseline_global_names(options))
+      out = SNAPSHOT_MAGIC + [SNAPSHOT_FORMAT].pack('L<')
+      [Quickjs::VERSION, Quickjs::QUICKJS_VERSION, RUBY_PLATFORM].each { |field| VM._write_snapshot_bytes(out, field) }
+      VM._write_snapshot_bytes(out, VM._encode_snapshot_value(+''.b, options))
+      VM._write_snapshot_bytes(out, globals || '')
+
+      tmp = "#{path}.#{Process.pid}.tmp"
+      ::File.binwrite(tmp, out)
+      ::File.rename(tmp, path)
+      path
+    ensure
+      ::File.unlink(tmp) if tmp && ::File.exist?(tmp)
+    end
+
+    # Builds a VM from a `snapshot_to` file: a `VM.new` with the recorded
+    # options, polyfill loads included, then the recorded data globals.
+    # `overrides` replace recorded constructor options (e.g. a tighter
+    # `timeout_msec:` for workers). The block, if given, runs on the new VM
+    # before the globals are loaded — bridges aren't part of a snapshot, so
+    # this is where to register them.
+    def self.restore(path, **overrides)
+      reader = SnapshotReader.new(::File.binread(path), path)
+      unless reader.magic?(SNAPSHOT_MAGIC) && reader.read_u32 == SNAPSHOT_FORMAT
+        raise Quickjs::RuntimeError.new("#{path} is not a Quickjs::VM snapshot", nil)
+      end
+
+      built_by = Array.new(3) { reader.read_bytes.force_encoding(Encoding::UTF_8) }
+      running = [Quickjs::VERSION, Quickjs::QUICKJS_VERSION, RUBY_PLATFORM]
+      if built_by != running
+        raise Quickjs::RuntimeError.new(
+          "#{path} was written by quickjs #{built_by[0]} (QuickJS #{built_by[1]}, #{built_by[2]}); " \
+          "this process runs quickjs #{running[0]} (QuickJS #{running[1]}, #{running[2]})",
+          nil
+        )
+      end
+
+      options = SnapshotReader.new(reader.read_bytes, path)
+      recorded = options.read_value
+      options.malformed! unless recorded.is_a?(Hash) && recorded.keys.all?(Symbol) && options.at_end?
+      globals = reader.read_bytes
+      reader.malformed! unless reader.at_end?
+
+      vm = new(**recorded, **overrides)
+      yield vm if block_given?
+      vm.send(:_load_globals, globals) unless globals.empty?
+      vm
+    rescue
+      vm&.dispose!
+      raise
+    end
+
+    # Option values are what VM.new takes: nil, booleans, Integers,
+    # Floats, Symbols, Strings, and Arrays / Hashes of them.
+    def self._encode_snapshot_value(out, value)
+      case value
+      when nil then out << 'n'
+      when true then out << 't'
+      when false then out << 'f'
+      when Integer then out << 'i' << [value].pack('q<')
+      when Float then out << 'd' << [value].pack('E')
+      when Symbol then _write_snapshot_bytes(out << 'y', value.name)
+      when String then _write_snapshot_bytes(out << 's', value)
+      when Array
+        out << 'a' << [value.size].pack('L<')
+        value.each { |item| _encode_snapshot_value(out, item) }
+      when Hash
+        out << 'h' << [value.size].pack('L<')
+        value.each do |key, item|
+          _encode_snapshot_value(out, key)
+          _encode_snapshot_value(out, item)
+        end
+      else
+        raise ArgumentError, "can't snapshot a VM built with a #{value.class} option"
+      end
+      out
+    end
+
+    def self._write_snapshot_bytes(out, bytes)
+      out << [bytes.bytesize].pack('L<') << bytes.b
+    end
+
+    # Bounds-checked reads over a snapshot, or one of its fields; anything
+    # short or malformed raises Quickjs::RuntimeError.
+    class SnapshotReader
+      def initialize(data, path)
+        @data = data.b
+        @path = path
+        @pos = 0
+      end
+
+      def magic?(magic)
+        return false unless @data.start_with?(magic)
+
+        @pos += magic.bytesize
+        true
+      end
+
+      def read_u32
+        read_fixed(4, 'L<')
+      end
+
+      def read_bytes
+        length = read_u32
+        malformed! if @data.bytesize - @pos < length
+        bytes = @data.byteslice(@pos, length)
+        @pos += length
+        bytes
+      end
+
+      def read_value
+        case read_fixed(1, 'a')
+        when 'n' then nil
+        when 't' then true
+        when 'f' then false
+        when 'i' then read_fixed(8, 'q<')
+        when 'd' then read_fixed(8, 'E')
+        when 'y' then read_bytes.force_encoding(Encoding::UTF_8).to_sym
+        when 's' then read_bytes.force_encoding(Encoding::UTF_8)
+        when 'a' then Array.new(read_count) { read_value }
+        when 'h' then Array.new(read_count) { [read_value, read_value] }.to_h
+        else malformed!
+        end
+      end
+
+      def at_end?
+        @pos == @data.bytesize
+      end
+
+      def malformed!
+        raise Quickjs::RuntimeError.new("#{@path} is a truncated or corrupt Quickjs::VM snapshot", nil)
+      end
+
+      private
+
+      # Every value takes at least one byte, so a count larger than what's
+      # left is forged; checking keeps it from sizing a huge Array.
+      def read_count
+        count = read_u32
+        malformed! if count > @data.bytesize - @pos
+        count
+      end
+
+      def read_fixed(size, format)
+        malformed! if @data.bytesize - @pos < size
+        value = @data.unpack1(format, offset: @pos)
+        @pos += size
+        value
+      end
+    end
+    private_constant :SnapshotReader
+  end
+end
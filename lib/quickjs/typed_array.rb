@@ -0,0 +1,41 @@
+# frozen_string_literal: true
+
+module Quickjs
+  # Numbers packed in one binary String, crossing into JS as a typed array
+  # with a single copy instead of one value per element.
+  module TypedArray
+    include Enumerable
+
+    def each(&block)
+      return enum_for(:each) { size } unless block
+
+      to_a.each(&block)
+      self
+    end
+
+    def length
+      size
+    end
+
+    def ==(other)
+      other.instance_of?(self.class) && other.bytes == bytes
+    end
+    alias eql? ==
+
+    def hash
+      [self.class, bytes].hash
+    end
+
+    def inspect
+      "#<#{self.class.name} #{to_a.inspect}>"
+    end
+  end
+
+  class Float64Array
+    include TypedArray
+  end
+
+  class Int32Array
+    include TypedArray
+  end
+end
@@ -0,0 +1,211 @@
+# frozen_string_literal: true
+
+module Quickjs
+  # A fixed-size set of ready-to-use VMs. Construction (`JS_NewRuntime` +
+  # `JS_NewContext` + polyfill loads) happens on warmer threads so the
+  # caller of `checkout` only ever pays for a queue pop. VMs that come back
+  # unhealthy — OOM-poisoned, interrupted mid-eval, or grown past
+  # `max_heap_growth` bytes since they were built — are disposed and
+  # replaced in the background instead of being handed to the next caller.
+  #
+  # `vm_opts` are passed verbatim to `Quickjs::VM.new`. The optional block
+  # runs once per freshly built VM (on the warmer thread) and is the place
+  # to register bridges with `define_function` / `module_loader=`.
+  class VMPool
+    attr_reader :size
+
+    def initialize(size:, warmers: nil, max_heap_growth: nil, checkout_timeout: nil, **vm_opts, &setup)
+      raise ArgumentError, "size: must be a positive Integer, got #{size.inspect}" unless size.is_a?(Integer) && size > 0
+
+      @size = size
+      @vm_opts = vm_opts
+      @setup = setup
+      @max_heap_growth = max_heap_growth
+      @checkout_timeout = checkout_timeout
+
+      @mutex = Mutex.new
+      @available = ConditionVariable.new
+      @idle = []
+      @baselines = {}.compare_by_identity
+      # Idle + checked out + under construction. Never exceeds `size`.
+      @live = 0
+      @warming = 0
+      @build_error = nil
+      @shutdown = false
+
+      @checkouts = 0
+      @recycled = 0
+      @wait_total = 0.0
+      @wait_max = 0.0
+
+      # Each ticket is either nil (build one VM) or a VM to dispose before
+      # building its replacement. Teardown can take tens of milliseconds;
+      # warmers hand it to the reaper thread (`dispose_later`) so neither
+      # the checking-in thread nor the next build waits on it.
+      @tickets = Thread::Queue.new
+      @warmers = Array.new(warmers || [size, 4].min) { Thread.new { warm_loop } }
+      @mutex.synchronize { size.times { request_build } }
+    end
+
+    # Yields an idle VM and takes it back when the block returns. Blocks
+    # while every VM is checked out or still warming; raises
+    # `Timeout::Error` after `timeout` seconds (nil waits indefinitely).
+    def checkout(timeout: @checkout_timeout)
+      vm = acquire(timeout)
+      begin
+        yield vm
+      ensure
+        release(vm)
+      end
+    end
+
+    def idle_count
+      @mutex.synchronize { @idle.size }
+    end
+
+    def recycled_count
+      @mutex.synchronize { @recycled }
+    end
+
+    # `wait_time_*` are seconds spent inside `checkout` before a VM was
+    # handed out, across every checkout so far.
+    def metrics
+      @mutex.synchronize do
+        {
+          size: @size,
+          idle: @idle.size,
+          checked_out: @live - @idle.size - @warming,
+          warming: @warming,
+          recycled: @recycled,
+          checkouts: @checkouts,
+          wait_time_total: @wait_total,
+          wait_time_max: @wait_max,
+          wait_time_avg: @checkouts.zero? ? 0.0 : @wait_total / @checkouts,
+        }
+      end
+    end
+
+    # Disposes every idle VM and stops the warmers. VMs still checked out
+    # are disposed when they come back; further checkouts raise.
+    def shutdown
+      idle = @mutex.synchronize do
+        @shutdown = true
+        @available.broadcast
+        @idle.slice!(0..)
+      end
+      @tickets.close
+      @warmers.each(&:join)
+      idle.each(&:dispose_later)
+      nil
+    end
+
+    def shutdown?
+      @mutex.synchronize { @shutdown }
+    end
+
+    private
+
+    def acquire(timeout)
+      started = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+      deadline = timeout && started + timeout
+
+      @mutex.synchronize do
+        loop do
+          raise Quickjs::RuntimeError.new('VMPool has been shut down', nil) if @shutdown
+
+          if (vm = @idle.pop)
+            waited = Process.clock_gettime(Process::CLOCK_MONOTONIC) - started
+            @checkouts += 1
+            @wait_total += waited
+            @wait_max = waited if waited > @wait_max
+            return vm
+          end
+
+          if (error = @build_error)
+            # Surface a construction failure (bad vm_opts, a raising setup
+            # block) to one waiter instead of retrying it forever.
+            @build_error = nil
+            raise error
+          end
+          request_build if @live < @size
+
+          remaining = deadline && deadline - Process.clock_gettime(Process::CLOCK_MONOTONIC)
+          raise ::Timeout::Error, "no VM available within #{timeout}s" if remaining && remaining <= 0
+          @available.wait(@mutex, remaining)
+        end
+      end
+    end
+
+    # `interrupted?` rather than a rescue around the block: a block that
+    # rescues the InterruptedError itself still hands back a VM stopped
+    # mid-eval.
+    def release(vm)
+      recycle = vm.disposed? || vm.interrupted? || vm.memory_poisoned? || grown_too_much?(vm)
+
+      @mutex.synchronize do
+        if @shutdown
+          @live -= 1
+          @baselines.delete(vm)
+          vm.dispose_later
+        elsif recycle
+          @recycled += 1
+          @warming += 1
+          @baselines.delete(vm)
+          @tickets << (vm.disposed? ? nil : vm)
+        else
+          @idle.push(vm)
+          @available.signal
+        end
+      end
+    end
+
+    def grown_too_much?(vm)
+      return false unless @max_heap_growth
+
+      vm.heap_bytes - @baselines.fetch(vm, 0) > @max_heap_growth
+    end
+
+    # Caller holds @mutex.
+    def request_build
+      @live += 1
+      @warming += 1
+      @tickets << nil
+    end
+
+    # A closed, drained queue pops nil too; that's the signal to exit.
+    def warm_loop
+      while (ticket = @tickets.pop) || !@tickets.closed?
+        ticket&.dispose_later
+        next unless (vm = build_vm)
+
+        @mutex.synchronize do
+          @warming -= 1
+          if @shutdown
+            @live -= 1
+            vm.dispose_later
+          else
+            @idle.push(vm)
+            @available.signal
+          end
+        end
+      end
+    end
+
+    def build_vm
+      vm = Quickjs::VM.new(**@vm_opts)
+      @setup&.call(vm)
+      baseline = @max_heap_growth ? vm.heap_bytes : 0
+      @mutex.synchronize { @baselines[vm] = baseline }
+      vm
+    rescue => e
+      vm&.dispose!
+      @mutex.synchronize do
+        @live -= 1
+        @warming -= 1
+        @build_error = e
+        @available.broadcast
+      end
+      nil
+    end
+  end
+end
@@ -0,0 +1,75 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+
+describe Quickjs::Bytes do
+  before do
+    @vm = Quickjs::VM.new
+    @vm.eval_code(<<~JS)
+      globalThis.inspect = (b) => [b instanceof ArrayBuffer, b.byteLength, new Uint8Array(b)[1]];
+      globalThis.keep = (b) => { globalThis.kept = b; return b.byteLength; };
+    JS
+  end
+
+  after { @vm.dispose! }
+
+  it "reaches JS as an ArrayBuffer over the String's bytes" do
+    _(@vm.call('inspect', Quickjs::Bytes.new("\x01\x02\x03".b))).must_equal [true, 3, 2]
+  end
+
+  it "holds its own copy without freezing the caller's String" do
+    input = +"abc"
+    bytes = Quickjs::Bytes.new(input)
+    _(bytes.string).must_be :frozen?
+    _(input).wont_be :frozen?
+    _(bytes.bytesize).must_equal 3
+
+    input << "d"
+    _(bytes.string).must_equal "abc"
+  end
+
+  it "keeps JS writes in its own buffer" do
+    input = +"abc"
+    bytes = Quickjs::Bytes.new(input)
+    @vm.eval_code('globalThis.poke = (b) => { new Uint8Array(b)[0] = 122; return new Uint8Array(b)[0]; }')
+    _(@vm.call('poke', bytes)).must_equal 122
+
+    _(input).must_equal "abc"
+    _(bytes.string).must_equal "zbc"
+    _(@vm.call('inspect', bytes)).must_equal [true, 3, 98]
+  end
+
+  it "keeps the String alive for as long as JS holds the buffer" do
+    _(@vm.call('keep', Quickjs::Bytes.new(Random.bytes(1024 * 1024)))).must_equal 1024 * 1024
+    GC.start
+    GC.compact if GC.respond_to?(:compact)
+    _(@vm.eval_code('new Uint8Array(kept).length')).must_equal 1024 * 1024
+
+    @vm.eval_code('kept = null')
+    @vm.gc!
+  end
+
+  it "converts inside Arrays and Hashes" do
+    @vm.eval_code('globalThis.firstLength = (o) => o.files[0].byteLength')
+    _(@vm.call('firstLength', {files: [Quickjs::Bytes.new("xyz")]})).must_equal 3
+  end
+
+  it "survives the VM being disposed while JS still holds it" do
+    bytes = Quickjs::Bytes.new("held")
+    [{}, { allocator: :arena }].each do |options|
+      vm = Quickjs::VM.new(**options)
+      vm.eval_code('globalThis.keep = (b) => { globalThis.kept = b; }')
+      vm.call('keep', bytes)
+      vm.dispose!
+      _(vm).must_be :disposed?
+    end
+    GC.start
+    GC.compact if GC.respond_to?(:compact)
+    _(bytes.string).must_equal "held"
+    _(@vm.call('keep', bytes)).must_equal 4
+  end
+
+  it "rejects non-Strings" do
+    _ { Quickjs::Bytes.new(42) }.must_raise TypeError
+  end
+end
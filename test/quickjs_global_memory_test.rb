@@ -0,0 +1,112 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+
+describe "Quickjs.global_memory_limit" do
+  before do
+    # Limits below are set relative to current usage; settle it first.
+    Quickjs.reaper_flush
+    @wait = Quickjs.global_memory_wait
+  end
+  after do
+    Quickjs.global_memory_limit = nil
+    Quickjs.global_memory_wait = @wait
+  end
+
+  it "is unset by default and rejects negative limits" do
+    _(Quickjs.global_memory_limit).must_be_nil
+    _ { Quickjs.global_memory_limit = -1 }.must_raise ArgumentError
+    _ { Quickjs.global_memory_wait = -1 }.must_raise ArgumentError
+
+    Quickjs.global_memory_limit = 512 * 1024 * 1024
+    _(Quickjs.global_memory_limit).must_equal 512 * 1024 * 1024
+  end
+
+  it "counts every VM's heap, and gives it back on dispose!" do
+    before = Quickjs.global_memory_used
+    vm = Quickjs::VM.new
+    vm.eval_code('globalThis.big = new Array(500_000).fill(0); 1')
+    _(Quickjs.global_memory_used).must_be :>=, before + vm.heap_bytes
+
+    vm.dispose!
+    _(Quickjs.global_memory_used).must_be :<=, before
+  end
+
+  it "fails allocations past the budget with an out-of-memory error" do
+    vm = Quickjs::VM.new(memory_limit: 256 * 1024 * 1024)
+    Quickjs.global_memory_limit = Quickjs.global_memory_used + 4 * 1024 * 1024
+
+    err = _ { vm.eval_code('new Array(2_000_000).fill(0); void 0') }.must_raise Quickjs::GlobalMemoryLimitError
+    _(err.message).must_match(/out of memory/)
+  ensure
+    vm&.dispose!
+  end
+
+  it "poisons a VM refused by the budget, which recycle: rebuilds" do
+    vm = Quickjs::VM.new(memory_limit: 256 * 1024 * 1024, recycle: { on_poison: :rebuild })
+    Quickjs.global_memory_limit = Quickjs.global_memory_used + 4 * 1024 * 1024
+
+    _ { vm.eval_code('globalThis.big = new Array(2_000_000).fill(0); void 0') }.must_raise Quickjs::GlobalMemoryLimitError
+    _(vm.memory_poisoned?).must_equal true
+
+    Quickjs.global_memory_limit = nil
+    _(vm.eval_code('new Array(2_000_000).fill(0).length')).must_equal 2_000_000
+    _(vm.memory_poisoned?).must_equal false
+  ensure
+    vm&.dispose!
+  end
+
+  it "lets JS catch the out-of-memory error" do
+    vm = Quickjs::VM.new(memory_limit: 256 * 1024 * 1024)
+    Quickjs.global_memory_limit = Quickjs.global_memory_used + 4 * 1024 * 1024
+
+    _(vm.eval_code('try { new Array(2_000_000).fill(0); "no" } catch (e) { e instanceof InternalError }')).must_equal true
+  ensure
+    vm&.dispose!
+  end
+
+  it "doesn't blame the budget for a later out-of-memory after JS caught its refusal" do
+    vm = Quickjs::VM.new(memory_limit: 8 * 1024 * 1024)
+    Quickjs.global_memory_limit = Quickjs.global_memory_used + 2 * 1024 * 1024
+    _(vm.eval_code('try { new Array(2_000_000).fill(0); "no" } catch (e) { "caught" }')).must_equal 'caught'
+
+    Quickjs.global_memory_limit = nil
+    err = _ { vm.eval_code('new Array(2_000_000).fill(0); void 0') }.must_raise Quickjs::RuntimeError
+    _(err).wont_be_kind_of Quickjs::GlobalMemoryLimitError
+  ensure
+    vm&.dispose!
+  end
+
+  it "keeps the per-VM memory_limit underneath" do
+    Quickjs.global_memory_limit = Quickjs.global_memory_used + 512 * 1024 * 1024
+    vm = Quickjs::VM.new(memory_limit: 1024 * 1024)
+
+    _ { vm.eval_code('new Array(2_000_000).fill(0); void 0') }.must_raise Quickjs::RuntimeError
+    _(vm.memory_poisoned?).must_equal true
+  ensure
+    vm&.dispose!
+  end
+
+  it "raises from VM.new when there is no headroom" do
+    Quickjs.global_memory_wait = 0
+    Quickjs.global_memory_limit = Quickjs.global_memory_used + 1024
+
+    err = _ { Quickjs::VM.new }.must_raise Quickjs::GlobalMemoryLimitError
+    _(err.message).must_match(/global_memory_limit/)
+  end
+
+  it "blocks VM.new until another VM frees its heap" do
+    hog = Quickjs::VM.new
+    hog.eval_code('globalThis.big = new Array(1_000_000).fill(0); 1')
+    Quickjs.global_memory_wait = 5
+    Quickjs.global_memory_limit = Quickjs.global_memory_used + 512 * 1024
+
+    releaser = Thread.new { sleep 0.1; hog.dispose! }
+    vm = Quickjs::VM.new
+    _(vm.eval_code('1 + 1')).must_equal 2
+  ensure
+    releaser&.join
+    hog&.dispose!
+    vm&.dispose!
+  end
+end
@@ -0,0 +1,87 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+
+describe Quickjs::ObjectRef do
+  before do
+    @vm = Quickjs::VM.new
+    @vm.eval_code(<<~JS)
+      globalThis.page = {
+        title: 'Home',
+        meta: { og: { image: '/cover.png' } },
+        sections: [{ id: 1 }, { id: 2 }, { id: 3 }],
+        count: 3,
+      };
+    JS
+  end
+
+  after { @vm.dispose! unless @vm.disposed? }
+
+  it "returns an ObjectRef for object results and plain values otherwise" do
+    _(@vm.eval_handle('page')).must_be_instance_of Quickjs::ObjectRef
+    _(@vm.eval_code('page', materialize: :lazy)).must_be_instance_of Quickjs::ObjectRef
+    _(@vm.eval_handle('page.title')).must_equal 'Home'
+    _(@vm.eval_handle('1 + 1')).must_equal 2
+  end
+
+  it "reads properties and elements on demand" do
+    page = @vm.eval_handle('page')
+    _(page['title']).must_equal 'Home'
+    _(page[:count]).must_equal 3
+    _(page['sections']).must_be_instance_of Quickjs::ObjectRef
+    _(page['sections'][1]['id']).must_equal 2
+    _(page.dig('meta', 'og', 'image')).must_equal '/cover.png'
+    _(page.dig('sections', 0, 'id')).must_equal 1
+  end
+
+  it "sizes, enumerates and materializes" do
+    page = @vm.eval_handle('page')
+    _(page.keys).must_equal %w[title meta sections count]
+    _(page.size).must_equal 4
+    _(page.array?).must_equal false
+
+    sections = page['sections']
+    _(sections.array?).must_equal true
+    _(sections.size).must_equal 3
+    _(sections.map { |s| s['id'] }).must_equal [1, 2, 3]
+    _(page.each.to_a.map(&:first)).must_equal %w[title meta sections count]
+
+    _(page['meta'].to_h).must_equal({'og' => {'image' => '/cover.png'}})
+    _(sections.materialize).must_equal [{'id' => 1}, {'id' => 2}, {'id' => 3}]
+    _ { sections.to_h }.must_raise TypeError
+  end
+
+  it "sees the live object, not a snapshot" do
+    page = @vm.eval_handle('page')
+    @vm.eval_code("page.title = 'Changed'")
+    _(page['title']).must_equal 'Changed'
+  end
+
+  it "raises JS exceptions from getters" do
+    ref = @vm.eval_handle("({ get boom() { throw new TypeError('bang'); } })")
+    _ { ref['boom'] }.must_raise Quickjs::TypeError
+  end
+
+  it "is released by dispose! and reset!" do
+    page = @vm.eval_handle('page')
+    @vm.reset!
+    _(page.released?).must_equal true
+    _ { page['title'] }.must_raise Quickjs::RuntimeError
+
+    page = @vm.eval_handle('({ a: 1 })')
+    @vm.dispose!
+    _(page.released?).must_equal true
+    _ { page['a'] }.must_raise Quickjs::RuntimeError
+  end
+
+  it "frees its value when collected" do
+    50.times { @vm.eval_handle('({ big: new Array(10000).fill(1) })') }
+    GC.start
+    @vm.gc!
+    _(@vm.eval_code('page.count')).must_equal 3
+  end
+
+  it "rejects unknown materialize: values" do
+    _ { @vm.eval_code('page', materialize: :sometimes) }.must_raise ArgumentError
+  end
+end
@@ -678,3 +678,54 @@ describe "bundled polyfill load failure" do
     _(err.message).must_match(/out of memory/)
   end
 end
+
+describe "lazy_polyfills: true" do
+  it "defers bundled polyfills until a global is touched" do
+    vm = ::Quickjs::VM.new(features: [::Quickjs::POLYFILL_URL, ::Quickjs::POLYFILL_ENCODING], lazy_polyfills: true)
+
+    _(vm.eval_code('typeof Object.getOwnPropertyDescriptor(globalThis, "URL").get')).must_equal 'function'
+    _(vm.eval_code('new URL("https://example.com/a?b=1").searchParams.get("b")')).must_equal '1'
+    _(vm.eval_code('typeof Object.getOwnPropertyDescriptor(globalThis, "URLSearchParams").get')).must_equal 'undefined'
+    _(vm.eval_code('typeof Object.getOwnPropertyDescriptor(globalThis, "TextEncoder").get')).must_equal 'function'
+    _(vm.eval_code('new TextEncoder().encode("hi").length')).must_equal 2
+  end
+
+  it "loads on assignment, then keeps the assigned value" do
+    vm = ::Quickjs::VM.new(features: [::Quickjs::POLYFILL_URL], lazy_polyfills: true)
+
+    _(vm.eval_code('globalThis.URL = "mine"; [URL, typeof URLSearchParams].join()')).must_equal 'mine,function'
+  end
+
+  it "converts a Ruby File through a lazily loaded File polyfill" do
+    vm = ::Quickjs::VM.new(features: [::Quickjs::POLYFILL_FILE], lazy_polyfills: true)
+    vm.define_function(:rubyFile) { ::File.open(__FILE__) }
+
+    _(vm.eval_code('rubyFile() instanceof File')).must_equal true
+  end
+
+  it "converts object results without loading the File polyfill" do
+    vm = ::Quickjs::VM.new(features: [::Quickjs::POLYFILL_FILE], lazy_polyfills: true)
+
+    _(vm.eval_code('({ a: [{ b: 1 }] })')).must_equal({'a' => [{'b' => 1}]})
+    _(vm.eval_code('typeof Object.getOwnPropertyDescriptor(globalThis, "File").get')).must_equal 'function'
+    file = vm.eval_code('new File(["hi"], "a.txt")')
+    _(file).must_be_instance_of ::Quickjs::File
+    _(file.name).must_equal 'a.txt'
+  end
+
+  it "does not load anything when no stub is touched" do
+    eager = ::Quickjs::VM.new(features: [::Quickjs::POLYFILL_URL, ::Quickjs::POLYFILL_ENCODING, ::Quickjs::POLYFILL_FILE])
+    lazy = ::Quickjs::VM.new(features: [::Quickjs::POLYFILL_URL, ::Quickjs::POLYFILL_ENCODING, ::Quickjs::POLYFILL_FILE], lazy_polyfills: true)
+
+    _(lazy.memory_usage[:obj_count]).must_be :<, eager.memory_usage[:obj_count]
+  end
+
+  it "is kept by reset!" do
+    vm = ::Quickjs::VM.new(features: [::Quickjs::POLYFILL_URL], lazy_polyfills: true)
+    vm.eval_code('new URL("https://example.com")')
+    vm.reset!
+
+    _(vm.eval_code('typeof Object.getOwnPropertyDescriptor(globalThis, "URL").get')).must_equal 'function'
+    _(vm.eval_code('new URL("https://example.com/x").pathname')).must_equal '/x'
+  end
+end
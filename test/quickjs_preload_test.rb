@@ -0,0 +1,87 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+
+describe "Quickjs.preload_for_fork" do
+  before { @feature = :"_test_preload_#{object_id}" }
+  after  { Quickjs._unregister_polyfill(@feature) }
+
+  it "compiles sources into Runnables over sealed, frozen bytecode" do
+    bundles = Quickjs.preload_for_fork(sources: {answer: 'globalThis.answer = 6 * 7; answer'})
+
+    bytecode = bundles[:answer].to_s
+    _(bytecode).must_be :frozen?
+    _(Quickjs._sealed?(bytecode)).must_equal true
+    _(bundles[:answer].run).must_equal 42
+  end
+
+  it "seals an already compiled Runnable" do
+    runnable = Quickjs.compile('[1, 2, 3].length')
+    bundles = Quickjs.preload_for_fork(sources: {'len' => runnable})
+
+    _(Quickjs._sealed?(runnable.to_s)).must_equal false
+    _(Quickjs._sealed?(bundles['len'].to_s)).must_equal true
+    _(bundles['len'].run).must_equal 3
+  end
+
+  it "runs sealed bytecode with the GVL released and on several VMs" do
+    bundle = Quickjs.preload_for_fork(sources: {x: '"sealed:" + (1 + 1)'})[:x]
+    vms = Array.new(3) { Quickjs::VM.new }
+
+    _(vms.map { |vm| bundle.run(on: vm) }).must_equal ['sealed:2'] * 3
+  ensure
+    vms&.each(&:dispose!)
+  end
+
+  it "compiles and seals registered polyfills named in features:" do
+    Quickjs.register_polyfill(@feature, source: 'globalThis.preloaded = "yes";')
+    Quickjs.preload_for_fork(features: [@feature])
+
+    entry = Quickjs._polyfill_for(@feature)
+    _(entry[:source]).must_be_nil
+    _(Quickjs._sealed?(entry[:bytecode])).must_equal true
+
+    vm = Quickjs::VM.new(features: [@feature])
+    _(vm.eval_code('preloaded')).must_equal 'yes'
+  ensure
+    vm&.dispose!
+  end
+
+  it "installs sealed lazy polyfills without copying their bytecode into each VM" do
+    Quickjs.register_polyfill(@feature, source: "globalThis.big = '#{'x' * 256 * 1024}';", globals: [:big])
+    copied = Quickjs::VM.new(features: [@feature], lazy_polyfills: true)
+    Quickjs.preload_for_fork(features: [@feature])
+    shared = Quickjs::VM.new(features: [@feature], lazy_polyfills: true)
+
+    bytecode_size = Quickjs._polyfill_for(@feature)[:bytecode].bytesize
+    _(copied.heap_bytes - shared.heap_bytes).must_be :>=, bytecode_size * 9 / 10
+    _(shared.eval_code('big.length')).must_equal 256 * 1024
+  ensure
+    copied&.dispose!
+    shared&.dispose!
+  end
+
+  it "leaves sealed bytecode as it is when preloaded twice" do
+    Quickjs.register_polyfill(@feature, source: 'globalThis.preloaded = 1;')
+    Quickjs.preload_for_fork(features: [@feature])
+    sealed = Quickjs._polyfill_for(@feature)[:bytecode]
+    Quickjs.preload_for_fork(features: [@feature])
+
+    _(Quickjs._polyfill_for(@feature)[:bytecode]).must_be_same_as sealed
+  end
+
+  it "ignores features without a registration" do
+    _(Quickjs.preload_for_fork(features: [::Quickjs::POLYFILL_URL, :_never_registered])).must_equal({})
+  end
+
+  it "counts sealed bytes in preload_stats" do
+    before = Quickjs.preload_stats[:sealed_bytes]
+    bundle = Quickjs.preload_for_fork(sources: {big: "globalThis.s = '#{'x' * 4096}';"})[:big]
+
+    _(Quickjs.preload_stats[:sealed_bytes]).must_equal before + bundle.to_s.bytesize
+  end
+
+  it "rejects sources that are neither Strings nor Runnables" do
+    _ { Quickjs.preload_for_fork(sources: {bad: 42}) }.must_raise TypeError
+  end
+end
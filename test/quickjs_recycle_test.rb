@@ -0,0 +1,96 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+
+describe "Quickjs::VM recycle:" do
+  it "rebuilds after max_evals, discarding globals and keeping features and bridges" do
+    vm = Quickjs::VM.new(features: [::Quickjs::POLYFILL_URL], recycle: {max_evals: 2})
+    vm.define_function(:greet) { |name| "hi #{name}" }
+    vm.eval_code('globalThis.leaked = 1')
+    _(vm.eval_code('typeof leaked')).must_equal 'number'
+    _(vm.recycle_count).must_equal 0
+
+    _(vm.eval_code('typeof leaked')).must_equal 'undefined'
+    _(vm.recycle_count).must_equal 1
+    _(vm.eval_code('greet(new URL("https://example.com/a").pathname)')).must_equal 'hi /a'
+  ensure
+    vm&.dispose!
+  end
+
+  it "counts call, import and Runnable#run as evals" do
+    vm = Quickjs::VM.new(recycle: {max_evals: 3})
+    vm.eval_code('globalThis.id = (x) => x')
+    vm.call(:id, 1)
+    Quickjs.compile('1').run(on: vm)
+    _(vm.recycle_count).must_equal 0
+
+    _ { vm.call(:id, 1) }.must_raise Quickjs::RuntimeError
+    _(vm.recycle_count).must_equal 1
+  ensure
+    vm&.dispose!
+  end
+
+  it "rebuilds once heap_bytes reaches max_heap_bytes" do
+    vm = Quickjs::VM.new(recycle: {max_heap_bytes: 4 * 1024 * 1024})
+    vm.eval_code('globalThis.big = new Array(1_000_000).fill(0); 1')
+    grown = vm.heap_bytes
+    vm.eval_code('1')
+
+    _(vm.recycle_count).must_equal 1
+    _(vm.heap_bytes).must_be :<, grown
+    _(vm.eval_code('typeof big')).must_equal 'undefined'
+  ensure
+    vm&.dispose!
+  end
+
+  it "rebuilds a memory-poisoned VM with on_poison: :rebuild" do
+    vm = Quickjs::VM.new(memory_limit: 1024 * 1024, recycle: {on_poison: :rebuild})
+    _ { vm.eval_code('new Array(2_000_000).fill(0); void 0') }.must_raise Quickjs::RuntimeError
+    _(vm.memory_poisoned?).must_equal true
+
+    _(vm.eval_code('1 + 1')).must_equal 2
+    _(vm.memory_poisoned?).must_equal false
+    _(vm.recycle_count).must_equal 1
+  ensure
+    vm&.dispose!
+  end
+
+  it "keeps refusing a poisoned VM by default" do
+    vm = Quickjs::VM.new(memory_limit: 1024 * 1024, recycle: {max_evals: 100})
+    _ { vm.eval_code('new Array(2_000_000).fill(0); void 0') }.must_raise Quickjs::RuntimeError
+
+    err = _ { vm.eval_code('1 + 1') }.must_raise Quickjs::RuntimeError
+    _(err.message).must_match(/poisoned/)
+    _(vm.recycle_count).must_equal 0
+  ensure
+    vm&.dispose!
+  end
+
+  it "defers the rebuild while a bridge re-enters eval" do
+    vm = Quickjs::VM.new(recycle: {max_evals: 1})
+    vm.define_function(:inner) { vm.eval_code('40 + 2') }
+    vm.eval_code('1')
+
+    _(vm.eval_code('globalThis.kept = 1; inner() + kept')).must_equal 43
+    _(vm.recycle_count).must_equal 1
+  ensure
+    vm&.dispose!
+  end
+
+  it "is 0 without a policy" do
+    vm = Quickjs::VM.new
+    3.times { vm.eval_code('1') }
+
+    _(vm.recycle_count).must_equal 0
+  ensure
+    vm&.dispose!
+  end
+
+  it "rejects malformed policies" do
+    _ { Quickjs::VM.new(recycle: 5) }.must_raise TypeError
+    _ { Quickjs::VM.new(recycle: {max_evals: 0}) }.must_raise ArgumentError
+    _ { Quickjs::VM.new(recycle: {on_poison: :ignore}) }.must_raise ArgumentError
+    _ { Quickjs::VM.new(recycle: {every: 3}) }.must_raise ArgumentError
+    _ { Quickjs::VM.new(runtime: Quickjs::Runtime.new, recycle: {max_evals: 1}) }.must_raise ArgumentError
+  end
+end
@@ -0,0 +1,99 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+
+describe Quickjs::Ref do
+  before do
+    @vm = Quickjs::VM.new
+    @vm.eval_code(<<~JS)
+      globalThis.read = (o, path) => path.split('.').reduce((v, k) => v[k], o);
+      globalThis.keep = (o) => { globalThis.kept = o; return true; };
+    JS
+  end
+
+  after { @vm.dispose! }
+
+  # Counts lookups so the tests can tell a lazy read from a copy.
+  class CountingCatalog
+    attr_reader :reads
+
+    def initialize(items)
+      @items = items
+      @reads = 0
+    end
+
+    def [](key)
+      @reads += 1
+      @items[key]
+    end
+
+    def keys
+      @items.keys
+    end
+  end
+
+  it "looks properties up only when JS reads them" do
+    catalog = CountingCatalog.new((0...10_000).to_h { |i| ["sku#{i}", { 'price' => i }] })
+    _(@vm.call('read', Quickjs::Ref.new(catalog), 'sku42.price')).must_equal 42
+    _(catalog.reads).must_equal 1
+  end
+
+  it "wraps nested Hashes and Arrays" do
+    ref = Quickjs::Ref.new({ 'user' => { 'tags' => %w[a b c] } })
+    _(@vm.call('read', ref, 'user.tags.1')).must_equal 'b'
+    @vm.eval_code('function tags(o) { return [o.user.tags.length, o.user.tags.map((t) => t.toUpperCase()), [...o.user.tags].join()]; }')
+    _(@vm.call('tags', ref)).must_equal [3, %w[A B C], 'a,b,c']
+  end
+
+  it "returns the same object for repeated reads of a nested value" do
+    @vm.eval_code('function same(o) { return [o.user === o.user, o.list === o.list, o.list[0] === o.list[0]]; }')
+    _(@vm.call('same', Quickjs::Ref.new({ 'user' => { 'id' => 1 }, 'list' => [{ 'n' => 1 }] }))).must_equal [true, true, true]
+  end
+
+  it "enumerates keys and serializes" do
+    @vm.eval_code('function dump(o) { return [Object.keys(o), JSON.stringify(o), "id" in o, "nope" in o, o.nope]; }')
+    _(@vm.call('dump', Quickjs::Ref.new({ 'id' => 1, 'name' => 'x' }))).must_equal(
+      [%w[id name], '{"id":1,"name":"x"}', true, false, Quickjs::Value::UNDEFINED]
+    )
+  end
+
+  it "reads Symbol and Integer keys" do
+    _(@vm.call('read', Quickjs::Ref.new({ name: 'sym' }), 'name')).must_equal 'sym'
+    _(@vm.call('read', Quickjs::Ref.new({ 7 => 'seven' }), '7')).must_equal 'seven'
+  end
+
+  it "is read-only" do
+    @vm.eval_code("function write(o) { 'use strict'; o.id = 2; }")
+    _ { @vm.call('write', Quickjs::Ref.new({ 'id' => 1 })) }.must_raise Quickjs::TypeError
+  end
+
+  it "raises Ruby errors from lookups as themselves" do
+    broken = Object.new
+    def broken.[](_key)
+      raise ArgumentError, 'no lookup'
+    end
+
+    def broken.keys
+      []
+    end
+    err = _ { @vm.call('read', Quickjs::Ref.new(broken), 'id') }.must_raise ArgumentError
+    _(err.message).must_equal 'no lookup'
+  end
+
+  it "comes back as the wrapped object" do
+    hash = { 'id' => 1 }
+    @vm.eval_code('function same(o) { return o; }')
+    _(@vm.call('same', Quickjs::Ref.new(hash))).must_be_same_as hash
+  end
+
+  it "keeps the wrapped object alive while JS holds it" do
+    @vm.call('keep', Quickjs::Ref.new({ 'items' => Array.new(100) { |i| { 'n' => i } } }))
+    GC.start
+    GC.compact if GC.respond_to?(:compact)
+    _(@vm.eval_code('kept.items[99].n + kept.items.length')).must_equal 199
+  end
+
+  it "rejects objects it can't read" do
+    _ { Quickjs::Ref.new(42) }.must_raise TypeError
+  end
+end
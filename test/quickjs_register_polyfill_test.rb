@@ -26,6 +26,35 @@ describe "Quickjs.register_polyfill" do
     }.must_raise TypeError
   end
 
+  it "rejects malformed globals:" do
+    _ {
+      Quickjs.register_polyfill(@feature, source: 'globalThis.x = 1;', globals: [])
+    }.must_raise TypeError
+  end
+
+  it "loads on first touch of a declared global with lazy_polyfills: true" do
+    Quickjs.register_polyfill(@feature, source: 'globalThis.lazyThing = { loads: (globalThis.loads || 0) + 1 };', globals: [:lazyThing])
+    vm = Quickjs::VM.new(features: [@feature], lazy_polyfills: true)
+
+    _(vm.eval_code('typeof globalThis.loads')).must_equal 'undefined'
+    _(vm.eval_code('lazyThing.loads + lazyThing.loads')).must_equal 2
+  end
+
+  it "loads eagerly under lazy_polyfills: true when no globals: were declared" do
+    Quickjs.register_polyfill(@feature, source: 'globalThis.eagerThing = 1;')
+    vm = Quickjs::VM.new(features: [@feature], lazy_polyfills: true)
+
+    _(vm.eval_code('Object.getOwnPropertyDescriptor(globalThis, "eagerThing").value')).must_equal 1
+  end
+
+  it "surfaces a lazy load's throw from the eval that triggered it" do
+    Quickjs.register_polyfill(@feature, source: 'throw new RangeError("lazy-boom");', globals: ['Boom'])
+    vm = Quickjs::VM.new(features: [@feature], lazy_polyfills: true)
+
+    err = _ { vm.eval_code('Boom') }.must_raise Quickjs::RangeError
+    _(err.message).must_match(/lazy-boom/)
+  end
+
   it "is applied when the feature is enabled on a VM" do
     Quickjs.register_polyfill(@feature, source: 'globalThis.myPolyfill = "loaded";')
     vm = Quickjs::VM.new(features: [@feature])
@@ -227,4 +256,15 @@ describe "Quickjs.register_polyfill" do
   ensure
     vm&.dispose!
   end
+
+  it "adds a VM#init_profile row named after the feature" do
+    Quickjs.register_polyfill(@feature, source: 'globalThis.fromPolyfill = [1, 2, 3];')
+    vm = Quickjs::VM.new(features: [@feature], profile_init: true)
+
+    row = vm.init_profile.find { |r| r[:phase] == @feature }
+    _(row[:allocations]).must_be :>, 0
+    _(vm.init_profile.last[:phase]).must_equal @feature
+  ensure
+    vm&.dispose!
+  end
 end
@@ -0,0 +1,116 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+
+describe "Quickjs::VM#reset!" do
+  it "discards globals, lexical bindings, and builtin changes" do
+    vm = Quickjs::VM.new
+    vm.eval_code('globalThis.a = 1; var b = 2; let c = 3; Array.prototype.evil = 4')
+    _(vm.reset!).must_be_same_as vm
+
+    _(vm.eval_code('[typeof a, typeof b, typeof c, typeof [].evil].join()')).must_equal 'undefined,undefined,undefined,undefined'
+  end
+
+  it "keeps features and re-installs bridges" do
+    vm = Quickjs::VM.new(features: [::Quickjs::POLYFILL_URL])
+    vm.define_function(:greet) { |name| "hi #{name}" }
+    vm.define_function(:later, :async) { |name| "later #{name}" }
+    vm.reset!
+
+    _(vm.eval_code('greet(new URL("https://example.com/a").pathname)')).must_equal 'hi /a'
+    _(vm.eval_code('await later("x")', async: true)).must_equal 'later x'
+    _(vm.eval_code('console.log("still there"); 1')).must_equal 1
+  end
+
+  it "brings polyfills back as stubs instead of running them again" do
+    vm = Quickjs::VM.new(features: [::Quickjs::POLYFILL_URL])
+    _(vm.eval_code('typeof Object.getOwnPropertyDescriptor(globalThis, "URL").get')).must_equal 'undefined'
+    vm.reset!
+
+    _(vm.eval_code('typeof Object.getOwnPropertyDescriptor(globalThis, "URL").get')).must_equal 'function'
+    _(vm.eval_code('new URL("https://example.com/a").pathname')).must_equal '/a'
+  end
+
+  it "runs queued jobs against the old globals before swapping" do
+    vm = Quickjs::VM.new
+    seen = []
+    vm.define_function(:record) { |value| seen << value }
+    vm.eval_code(<<~JS)
+      globalThis.x = 'old';
+      Promise.resolve().then(() => record(x));
+      Promise.resolve().then(() => { throw new Error('dropped') });
+      void 0
+    JS
+    vm.reset!
+
+    _(seen).must_equal ['old']
+    _(vm.drain_jobs!).must_equal 0
+    _(vm.eval_code('typeof x')).must_equal 'undefined'
+  end
+
+  it "keeps registered polyfills" do
+    Quickjs.register_polyfill(:reset_test_marker, source: 'globalThis.marker = 42;')
+    vm = Quickjs::VM.new(features: [:reset_test_marker])
+    vm.eval_code('marker = 0')
+    vm.reset!
+
+    _(vm.eval_code('marker')).must_equal 42
+  ensure
+    Quickjs._unregister_polyfill(:reset_test_marker)
+  end
+
+  it "forgets imported modules and asks the module_loader again" do
+    vm = Quickjs::VM.new
+    loads = 0
+    vm.module_loader = ->(name) { loads += 1; 'export const n = 1;' if name == 'n' }
+
+    vm.import(['n'], from: "import { n } from 'n'; export { n };")
+    vm.reset!
+    _(vm.eval_code('typeof n')).must_equal 'undefined'
+
+    vm.import(['n'], from: "import { n } from 'n'; export { n };")
+    _(vm.eval_code('n')).must_equal 1
+    _(loads).must_equal 2
+  end
+
+  it "keeps on_log listeners" do
+    vm = Quickjs::VM.new
+    logs = []
+    vm.on_log { |log| logs << log.to_s }
+    vm.reset!
+    vm.eval_code('console.log("after")')
+
+    _(logs).must_equal ['after']
+  end
+
+  it "does not duplicate bridges across repeated resets" do
+    vm = Quickjs::VM.new
+    vm.define_function(:one) { 1 }
+    3.times { vm.reset! }
+
+    _(vm.instance_variable_get(:@_blueprint_functions).size).must_equal 1
+    _(vm.eval_code('one()')).must_equal 1
+  end
+
+  it "resets a context on a shared runtime" do
+    rt = Quickjs::Runtime.new
+    vm = rt.new_context
+    sibling = rt.new_context
+    vm.eval_code('globalThis.x = 1')
+    sibling.eval_code('globalThis.y = 2')
+    vm.reset!
+
+    _(vm.eval_code('typeof x')).must_equal 'undefined'
+    _(sibling.eval_code('y')).must_equal 2
+    _(rt.context_count).must_equal 2
+  ensure
+    rt&.dispose!
+  end
+
+  it "refuses a disposed VM" do
+    vm = Quickjs::VM.new
+    vm.dispose!
+
+    _ { vm.reset! }.must_raise Quickjs::RuntimeError
+  end
+end
@@ -0,0 +1,95 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+
+describe Quickjs::Runtime do
+  before { @rt = Quickjs::Runtime.new }
+  after { @rt.dispose! }
+
+  it "keeps globals separate between its contexts" do
+    a = @rt.new_context
+    b = Quickjs::VM.new(runtime: @rt)
+
+    a.eval_code('globalThis.x = 1')
+    _(b.eval_code('typeof x')).must_equal 'undefined'
+    _(a.runtime).must_be_same_as @rt
+    _(b.runtime).must_be_same_as @rt
+    _(@rt.context_count).must_equal 2
+  end
+
+  it "leaves a standalone VM without a runtime" do
+    _(Quickjs::VM.new.runtime).must_be_nil
+  end
+
+  it "reports runtime-wide memory through every context" do
+    a = @rt.new_context
+    b = @rt.new_context
+    a.eval_code('globalThis.big = "x".repeat(1024 * 1024); 0')
+
+    _(b.memory_usage[:malloc_size]).must_equal @rt.memory_usage[:malloc_size]
+    _(b.heap_bytes).must_equal @rt.heap_bytes
+    _(@rt.heap_bytes).must_equal @rt.memory_usage[:malloc_size]
+  end
+
+  it "applies per-context features and bridges" do
+    a = @rt.new_context(features: [::Quickjs::POLYFILL_URL])
+    b = @rt.new_context
+    a.define_function(:greet) { |name| "hi #{name}" }
+
+    _(a.eval_code('greet(new URL("https://example.com/a").pathname)')).must_equal 'hi /a'
+    _(b.eval_code('typeof URL + typeof greet')).must_equal 'undefinedundefined'
+  end
+
+  it "runs a Runnable compiled on a sibling context" do
+    a = @rt.new_context
+    b = @rt.new_context
+    runnable = a.compile('1 + 2')
+
+    _(runnable.run(on: b)).must_equal 3
+  end
+
+  it "interrupts only the context whose timeout lapsed" do
+    slow = @rt.new_context(timeout_msec: 50)
+    other = @rt.new_context
+
+    _ { slow.eval_code('while(true) {}') }.must_raise Quickjs::InterruptedError
+    _(other.eval_code('1 + 1')).must_equal 2
+  end
+
+  it "rejects per-VM limits and MODULE_OS" do
+    _ { Quickjs::VM.new(runtime: @rt, memory_limit: 1024) }.must_raise ArgumentError
+    _ { Quickjs::VM.new(runtime: @rt, features: [::Quickjs::MODULE_OS]) }.must_raise ArgumentError
+  end
+
+  it "raises ThreadError when another thread enters while a context evaluates" do
+    a = @rt.new_context
+    b = @rt.new_context
+    error = nil
+    a.define_function(:poke) do
+      Thread.new { b.eval_code('1') rescue error = $! }.join
+      nil
+    end
+
+    a.eval_code('poke()')
+    _(error).must_be_instance_of ThreadError
+  end
+
+  it "lets a context be disposed on its own" do
+    a = @rt.new_context
+    b = @rt.new_context
+    a.dispose!
+
+    _(a.disposed?).must_equal true
+    _(@rt.context_count).must_equal 1
+    _(b.eval_code('1 + 1')).must_equal 2
+  end
+
+  it "disposes every context with the runtime" do
+    a = @rt.new_context
+    @rt.dispose!
+
+    _(@rt.disposed?).must_equal true
+    _(a.disposed?).must_equal true
+    _ { @rt.new_context }.must_raise Quickjs::RuntimeError
+  end
+end
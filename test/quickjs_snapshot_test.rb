@@ -0,0 +1,91 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+require "tmpdir"
+
+describe "Quickjs::VM snapshots" do
+  before do
+    @dir = Dir.mktmpdir
+    @path = File.join(@dir, 'vm.qjsnap')
+  end
+  after { FileUtils.remove_entry(@dir) }
+
+  it "restores data globals and constructor options" do
+    vm = Quickjs::VM.new(features: [::Quickjs::POLYFILL_URL])
+    vm.eval_code('globalThis.routes = [{ path: "/a" }, { path: "/b" }]; var version = 3;')
+    _(vm.snapshot_to(@path)).must_equal @path
+
+    restored = Quickjs::VM.restore(@path)
+    _(restored.eval_code('routes.map(r => r.path)')).must_equal ['/a', '/b']
+    _(restored.eval_code('version')).must_equal 3
+    _(restored.eval_code('new URL("https://example.com/c").pathname')).must_equal '/c'
+  end
+
+  it "applies option overrides and runs the block before loading globals" do
+    vm = Quickjs::VM.new
+    vm.eval_code('globalThis.n = 20')
+    vm.snapshot_to(@path)
+
+    restored = Quickjs::VM.restore(@path, timeout_msec: 50) do |v|
+      v.define_function(:plus_one) { |x| x + 1 }
+    end
+    _(restored.eval_code('plus_one(n)')).must_equal 21
+    _ { restored.eval_code('while(true) {}') }.must_raise Quickjs::InterruptedError
+  end
+
+  it "does not store builtins or polyfill globals" do
+    vm = Quickjs::VM.new(features: [::Quickjs::POLYFILL_ENCODING])
+    vm.snapshot_to(@path)
+
+    # The globals blob is the last field; its length prefix is zero.
+    _(File.binread(@path).end_with?("\0\0\0\0".b)).must_equal true
+  end
+
+  it "restores Symbol-valued options as Symbols" do
+    vm = Quickjs::VM.new(features: [::Quickjs::POLYFILL_URL], timeout_msec: 100)
+    vm.snapshot_to(@path)
+
+    restored = Quickjs::VM.restore(@path)
+    _(restored.instance_variable_get(:@_blueprint_opts)).must_equal(
+      { features: [::Quickjs::POLYFILL_URL], timeout_msec: 100 }
+    )
+  end
+
+  it "builds the baseline global list once per option set" do
+    opts = { features: [::Quickjs::POLYFILL_URL], timeout_msec: 500 }
+    names = Quickjs._baseline_global_names(opts)
+
+    _(names).must_include 'URL'
+    _(Quickjs._baseline_global_names(opts)).must_be_same_as names
+    Quickjs.register_polyfill(:snapshot_test_marker, source: 'globalThis.marker = 1;')
+    _(Quickjs._baseline_global_names(opts)).wont_be_same_as names
+  ensure
+    Quickjs._unregister_polyfill(:snapshot_test_marker)
+  end
+
+  it "refuses snapshots from a different build" do
+    Quickjs::VM.new.snapshot_to(@path)
+    other = Quickjs::QUICKJS_VERSION.tr('0-9', '9')
+    File.binwrite(@path, File.binread(@path).sub(Quickjs::QUICKJS_VERSION, other))
+
+    err = _ { Quickjs::VM.restore(@path) }.must_raise Quickjs::RuntimeError
+    _(err.message).must_include other
+  end
+
+  it "refuses files that aren't snapshots without unmarshaling them" do
+    File.binwrite(@path, Marshal.dump([1, 2, 3]))
+
+    err = _ { Quickjs::VM.restore(@path) }.must_raise Quickjs::RuntimeError
+    _(err.message).must_match(/not a Quickjs::VM snapshot/)
+  end
+
+  it "refuses truncated snapshots" do
+    vm = Quickjs::VM.new
+    vm.eval_code('globalThis.n = 1')
+    vm.snapshot_to(@path)
+    File.binwrite(@path, File.binread(@path)[0...-2])
+
+    err = _ { Quickjs::VM.restore(@path) }.must_raise Quickjs::RuntimeError
+    _(err.message).must_match(/truncated or corrupt/)
+  end
+end
@@ -81,6 +81,28 @@ describe Quickjs do
       assert_code("[1, 2, { 'third': 'sad' }]", [1, 2, { 'third' => 'sad' }])
     end
 
+    it "array elements of every primitive kind convert like top-level values" do
+      assert_code("[0, -1, 2 ** 31, 1.5, NaN, true, false, null, undefined, 'x']",
+                  [0, -1, 2**31, 1.5, Quickjs::Value::NAN, true, false, nil, Quickjs::Value::UNDEFINED, 'x'])
+      assert_code("const a = [1, 2]; a[4] = 5; a", [1, 2, Quickjs::Value::UNDEFINED, Quickjs::Value::UNDEFINED, 5])
+    end
+
+    it "converts with the context's own builtins even after globals are shadowed" do
+      @vm.eval_code('globalThis.Object = function() {}; globalThis.Number = () => 0; globalThis.Uint8Array = null')
+      _(@vm.eval_code('({ a: [1, { b: 2 }] })')).must_equal({ 'a' => [1, { 'b' => 2 }] })
+
+      @vm.eval_code('function echo(v) { return String(v); }')
+      _(@vm.call('echo', 2**70)).must_equal '1.1805916207174113e+21'
+      _(@vm.call('echo', Quickjs::Value::NAN)).must_equal 'NaN'
+    end
+
+    it "large arrays convert whole" do
+      result = @vm.eval_code("Array.from({ length: 100000 }, (_, i) => i % 2 ? i : 'n' + i)")
+      _(result.length).must_equal 100_000
+      _(result[99_999]).must_equal 99_999
+      _(result[99_998]).must_equal 'n99998'
+    end
+
     it "undefined nested in plain object or array is preserved" do
       assert_code("({ a: undefined, b: 1 })", { 'a' => Quickjs::Value::UNDEFINED, 'b' => 1 })
       assert_code("({ a: { b: undefined } })", { 'a' => { 'b' => Quickjs::Value::UNDEFINED } })
@@ -96,8 +118,12 @@ describe Quickjs do
       assert_code("new Date('2024-01-01T00:00:00.000Z').toISOString()", "2024-01-01T00:00:00.000Z")
     end
 
-    it "Date object becomes its ISO string via toJSON" do
-      assert_code("new Date('2024-01-01T00:00:00.000Z')", "2024-01-01T00:00:00.000Z")
+    it "Date object becomes a UTC Time" do
+      time = ::Quickjs.eval_code("new Date('2024-01-01T00:00:00.123Z')")
+      _(time).must_equal Time.utc(2024, 1, 1, 0, 0, Rational(123, 1000))
+      _(time).must_be :utc?
+      assert_code("new Date(-1)", Time.utc(1969, 12, 31, 23, 59, Rational(59_999, 1000)))
+      assert_code("({ at: new Date(NaN) })", {'at' => nil})
     end
 
     it "object with toJSON honours its custom representation" do
@@ -119,11 +145,54 @@ describe Quickjs do
       JS
     end
 
-    it "Map and RegExp without enumerable own properties become {}" do
-      assert_code("new Map([['a', 1]])", {})
+    it "RegExp without enumerable own properties becomes {}" do
       assert_code("/abc/g", {})
     end
 
+    it "Map becomes a Hash with converted keys" do
+      assert_code("new Map([['a', 1], [2, { b: [3] }]])", {'a' => 1, 2 => {'b' => [3]}})
+      assert_code("class Registry extends Map {}; new Registry([['k', 'v']])", {'k' => 'v'})
+      assert_code("const m = new Map(); m.set('self', m); m", {'self' => nil})
+    end
+
+    it "Map keeps an entry's value alive while a getter on its key empties the entry" do
+      assert_code(<<~JS, {{'k' => 1} => {'n' => [1, 2]}})
+        class Draining extends Map {
+          *[Symbol.iterator]() {
+            const entry = [{ get k() { entry.length = 0; return 1; } }, { n: [1, 2] }];
+            yield entry;
+          }
+        }
+        new Draining()
+      JS
+    end
+
+    it "Set becomes a Set" do
+      assert_code("new Set([1, 'two', 1])", Set[1, 'two'])
+      assert_code("({ tags: new Set(['a']) })", {'tags' => Set['a']})
+    end
+
+    it "Date, Map and Set are recognised without running Symbol.hasInstance" do
+      vm = Quickjs::VM.new
+      vm.eval_code(<<~JS)
+        for (const C of [Date, Map, Set]) {
+          Object.defineProperty(C, Symbol.hasInstance, { value() { throw new Error('hasInstance ran'); } });
+        }
+      JS
+      _(vm.eval_code("[new Date(0), new Map([['a', 1]]), new Set([2])]")).must_equal [Time.at(0).utc, {'a' => 1}, Set[2]]
+    end
+
+    it "converts deeply nested results" do
+      result = ::Quickjs.eval_code(<<~JS)
+        let node = { depth: 0 };
+        for (let i = 1; i < 2000; i++) node = { depth: i, child: node, list: [i] };
+        node
+      JS
+      depth = 0
+      depth += 1 while (result = result['child'])
+      _(depth).must_equal 1999
+    end
+
     it "circular plain object converts cycle entry to nil" do
       assert_code("const o = {a: 1}; o.self = o; o", {'a' => 1, 'self' => nil})
     end
@@ -160,6 +229,55 @@ describe Quickjs do
       result = ::Quickjs.eval_code("() => 'hi'")
       _(result).must_be_instance_of Quickjs::Function
     end
+
+    it "object keys are frozen UTF-8 Strings shared across records" do
+      rows = ::Quickjs.eval_code("[{ id: 1, 'ñ': 2 }, { id: 3, 'ñ': 4 }]")
+      _(rows).must_equal [{'id' => 1, 'ñ' => 2}, {'id' => 3, 'ñ' => 4}]
+      first, second = rows.map(&:keys)
+      _(first.all?(&:frozen?)).must_equal true
+      _(first.map(&:encoding).uniq).must_equal [Encoding::UTF_8]
+      _(first[0]).must_be_same_as second[0]
+      _(first[1]).must_be_same_as second[1]
+    end
+
+    it "ArrayBuffer and typed arrays become binary Strings" do
+      _(::Quickjs.eval_code("new Uint8Array([0, 1, 255]).buffer")).must_equal "\x00\x01\xFF".b
+      view = ::Quickjs.eval_code("new Uint8Array([9, 8, 7, 6]).subarray(1, 3)")
+      _(view).must_equal "\x08\x07".b
+      _(view.encoding).must_equal Encoding::BINARY
+      _(::Quickjs.eval_code("new Uint16Array([1])")).must_equal "\x01\x00".b
+      _(::Quickjs.eval_code("({ png: new Uint8Array([137, 80]) })")).must_equal({'png' => "\x89P".b})
+    end
+
+    it "recognises objects by prototype without running instanceof hooks" do
+      vm = Quickjs::VM.new
+      vm.eval_code(<<~JS)
+        for (const C of [ArrayBuffer, Uint8Array.__proto__]) {
+          Object.defineProperty(C, Symbol.hasInstance, { value() { throw new Error('hasInstance ran'); } });
+        }
+      JS
+      _(vm.eval_code("({ buf: new Uint8Array([1, 2]).buffer, view: new Uint8Array([3]), n: 1 })")).must_equal(
+        {'buf' => "\x01\x02".b, 'view' => "\x03".b, 'n' => 1}
+      )
+      _(vm.eval_code("new Proxy({ x: 1 }, { getPrototypeOf() { throw new Error('trap ran'); } })")).must_equal({'x' => 1})
+      _(vm.eval_code("1 + 1")).must_equal 2
+    end
+
+    it "result: :json returns the value as JSON text" do
+      vm = Quickjs::VM.new
+      _(vm.eval_code("({ a: [1, 2.5, 'ü'], b: null })", result: :json)).must_equal '{"a":[1,2.5,"ü"],"b":null}'
+      _(vm.eval_code("await Promise.resolve({ ok: true })", result: :json)).must_equal '{"ok":true}'
+      _(vm.eval_code("undefined", result: :json)).must_be_nil
+      _ { vm.eval_code("const c = {}; c.c = c; c", result: :json) }.must_raise Quickjs::TypeError
+      _ { vm.eval_code("1", result: :yaml) }.must_raise ArgumentError
+    end
+
+    it "symbolize_names: true converts object keys to Symbols" do
+      vm = Quickjs::VM.new
+      result = vm.eval_code("({ a: 1, nested: [{ b: { c: 2 } }] })", symbolize_names: true)
+      _(result).must_equal({a: 1, nested: [{b: {c: 2}}]})
+      _(vm.eval_code("({ a: 1 })")).must_equal({'a' => 1})
+    end
   end
 
   describe "Exceptions" do
@@ -361,6 +479,26 @@ describe Quickjs::VM do
       _(@vm.gc!).must_be_nil
     end
 
+    it "heap_bytes matches memory_usage's malloc_size" do
+      @vm.eval_code('globalThis.big = "x".repeat(1024 * 1024); 0')
+      _(@vm.heap_bytes).must_equal @vm.memory_usage[:malloc_size]
+      _(@vm.heap_bytes).must_be :>, 1024 * 1024
+    end
+
+    it "heap_bytes shrinks once JS garbage is collected" do
+      @vm.eval_code('globalThis.big = "x".repeat(1024 * 1024); 0')
+      grown = @vm.heap_bytes
+      @vm.eval_code('globalThis.big = null; 0')
+      @vm.gc!
+      _(@vm.heap_bytes).must_be :<, grown
+    end
+
+    it "counts the JS heap in ObjectSpace.memsize_of" do
+      require 'objspace'
+      @vm.eval_code('globalThis.big = "x".repeat(1024 * 1024); 0')
+      _(ObjectSpace.memsize_of(@vm)).must_be :>, 1024 * 1024
+    end
+
     it "does not enable std/os module as default" do
       _(@vm.eval_code("typeof std === 'undefined'")).must_equal true
       _(@vm.eval_code("typeof os === 'undefined'")).must_equal true
@@ -406,7 +544,8 @@ describe Quickjs::VM do
       import:          ->(vm) { vm.import('x', from: 'export default 1') },
       drain_jobs!:     ->(vm) { vm.drain_jobs! },
       memory_usage:    ->(vm) { vm.memory_usage },
-      gc!:             ->(vm) { vm.gc! }
+      gc!:             ->(vm) { vm.gc! },
+      heap_bytes:      ->(vm) { vm.heap_bytes }
     }.each do |method, invoke|
       it "#{method} on a disposed VM raises Quickjs::RuntimeError" do
         vm = Quickjs::VM.new
@@ -517,6 +656,68 @@ describe Quickjs::VM do
     end
   end
 
+  describe "DisposeLater" do
+    after { Quickjs.reaper_capacity = 64 }
+
+    it "disposes on return and frees the runtime on the reaper thread" do
+      before = Quickjs.reaper_metrics
+      vm = Quickjs::VM.new(features: [::Quickjs::POLYFILL_URL, ::Quickjs::MODULE_STD])
+      vm.eval_code('globalThis.big = "x".repeat(1024 * 1024); 0')
+
+      _(vm.dispose_later).must_be_nil
+      _(vm.disposed?).must_equal true
+      _ { vm.eval_code('1') }.must_raise Quickjs::RuntimeError
+      _(vm.dispose_later).must_be_nil
+
+      Quickjs.reaper_flush
+      after = Quickjs.reaper_metrics
+      _(after[:backlog]).must_equal 0
+      _(after[:enqueued] - before[:enqueued]).must_equal 1
+      _(after[:reaped] - before[:reaped]).must_equal 1
+      _(after[:teardown_time_total]).must_be :>, before[:teardown_time_total]
+    end
+
+    it "reaps arena VMs" do
+      vms = Array.new(4) { Quickjs::VM.new(allocator: :arena) }
+      vms.each(&:dispose_later)
+      Quickjs.reaper_flush
+      _(Quickjs.reaper_metrics[:backlog]).must_equal 0
+    end
+
+    it "tears down on the caller when the queue is full" do
+      Quickjs.reaper_capacity = 0
+      before = Quickjs.reaper_metrics[:inline]
+      Quickjs::VM.new.dispose_later
+      _(Quickjs.reaper_metrics[:inline] - before).must_equal 1
+    end
+
+    it "frees a shared-runtime context immediately" do
+      rt = Quickjs::Runtime.new
+      vm = rt.new_context
+      vm.dispose_later
+      _(vm.disposed?).must_equal true
+      _(rt.context_count).must_equal 0
+    ensure
+      rt&.dispose!
+    end
+
+    it "refuses while the VM is evaluating" do
+      vm = Quickjs::VM.new
+      vm.define_function(:later) do
+        vm.dispose_later
+        'disposed'
+      rescue ThreadError
+        'refused'
+      end
+      _(vm.eval_code('later()')).must_equal 'refused'
+      _(vm.disposed?).must_equal false
+    end
+
+    it "rejects a negative capacity" do
+      _ { Quickjs.reaper_capacity = -1 }.must_raise ArgumentError
+    end
+  end
+
   it "accepts some options to constrain its resource" do
     vm = Quickjs::VM.new(
       memory_limit: 1024 * 1024,
@@ -542,7 +743,13 @@ describe Quickjs::VM do
   it "gets timeout from evaluation" do
     vm = Quickjs::VM.new
 
+    _(vm.interrupted?).must_equal false
     _ { vm.eval_code("while(1) {}") }.must_raise Quickjs::InterruptedError
+    _(vm.interrupted?).must_equal true
+    # Sticks after later evals succeed: the interrupted one may have left
+    # globals half-updated.
+    _(vm.eval_code("1 + 1")).must_equal 2
+    _(vm.interrupted?).must_equal true
   end
 
   it "accepts timeout_msec option to control maximum evaluation time" do
@@ -888,11 +1095,41 @@ describe Quickjs::VM do
       _(@vm.call('getName', { name: 'Alice' })).must_equal 'Alice'
     end
 
+    it "passes many uniformly keyed hashes, across a reset!" do
+      @vm.eval_code("function total(rows) { return rows.reduce((s, r) => s + r.qty * r['price'], 0); }")
+      rows = Array.new(5000) { |i| { qty: 1, 'price' => i % 3, 'note' => 'x', 1 => 'one' } }
+      _(@vm.call('total', rows)).must_equal 4999
+      @vm.reset!
+      @vm.eval_code("function keys(row) { return Object.keys(row); }")
+      _(@vm.call('keys', rows.first)).must_equal %w[1 qty price note]
+    end
+
+    it "defines a __proto__ key as an own property" do
+      @vm.eval_code("function own(o) { return [Object.getPrototypeOf(o) === Object.prototype, o.__proto__]; }")
+      _(@vm.call('own', { '__proto__' => 'x' })).must_equal [true, 'x']
+    end
+
     it "passes array arg" do
       @vm.eval_code("function sum(arr) { return arr.reduce((a, b) => a + b, 0); }")
       _(@vm.call('sum', [1, 2, 3])).must_equal 6
     end
 
+    it "passes large and nested arrays" do
+      @vm.eval_code("function shape(arr) { return [arr.length, Array.isArray(arr[1]), arr[1][1], arr[arr.length - 1]]; }")
+      input = [0, [1, 'two', nil]] + Array.new(100_000) { |i| i * 0.5 }
+      _(@vm.call('shape', input)).must_equal [100_002, true, 'two', 49_999.5]
+    end
+
+    it "passes an array that shrinks while it is converted" do
+      @vm.eval_code("function len(arr) { return arr.length; }")
+      arr = [1, 2, 3, 4]
+      shrinker = Object.new
+      shrinker.define_singleton_method(:inspect) { arr.pop(2); 'shrinker' }
+      arr[1] = shrinker
+
+      _(@vm.call('len', arr)).must_equal 2
+    end
+
     it "passes mixed args" do
       @vm.eval_code("function format(tmpl, data) { return tmpl.replace('{name}', data.name); }")
       _(@vm.call('format', 'Hello, {name}!', { name: 'Bob' })).must_equal 'Hello, Bob!'
@@ -963,6 +1200,61 @@ describe Quickjs::VM do
       _(@vm.call('a.b["c-d"]')).must_equal 'mixed'
     end
 
+    it "converts the result with symbolize_names: true" do
+      @vm.eval_code("function pair(x) { return { value: x, tags: [{ name: 'n' }] }; }")
+      _(@vm.call('pair', 1, symbolize_names: true)).must_equal({value: 1, tags: [{name: 'n'}]})
+      _(@vm.call('pair', 1)).must_equal({'value' => 1, 'tags' => [{'name' => 'n'}]})
+    end
+
+    it "call_json passes JSON text in and returns JSON text" do
+      @vm.eval_code("function render(props) { return { html: '<h1>' + props.title + '</h1>', size: props.items.length }; }")
+      json = @vm.call_json('render', '{"title":"Hi","items":[1,2,3]}')
+      _(json).must_equal '{"html":"<h1>Hi</h1>","size":3}'
+      _(json.encoding).must_equal Encoding::UTF_8
+    end
+
+    it "call_json awaits async functions and maps undefined to nil" do
+      @vm.eval_code("async function echo(v) { return v; } function nothing() {}")
+      _(@vm.call_json('echo', '[1,"two",null]')).must_equal '[1,"two",null]'
+      _(@vm.call_json('nothing')).must_be_nil
+    end
+
+    it "call_json raises SyntaxError for malformed JSON" do
+      @vm.eval_code("function id(v) { return v; }")
+      _ { @vm.call_json('id', '{nope') }.must_raise Quickjs::SyntaxError
+      _(@vm.call_json('id', '"still usable"')).must_equal '"still usable"'
+    end
+
+    it "passes a binary String as a Uint8Array" do
+      @vm.eval_code("function describe(b) { return [b instanceof Uint8Array, b.length, b[2]]; }")
+      _(@vm.call('describe', "\x00\x01\xFF".b)).must_equal [true, 3, 255]
+      _(@vm.call('describe', 'abc')).must_equal [false, 3, 'c']
+    end
+
+    it "round-trips binary payloads" do
+      payload = Random.bytes(4096)
+      @vm.eval_code("function reverse(b) { return b.slice().reverse(); }")
+      _(@vm.call('reverse', payload)).must_equal payload.reverse
+    end
+
+    it "still passes other keywords to the function as one object" do
+      @vm.eval_code("function echo(...args) { return args; }")
+      _(@vm.call('echo', name: 'x')).must_equal [{'name' => 'x'}]
+    end
+
+    it "passes a braced Hash with a symbolize_names key to the function intact" do
+      @vm.eval_code("function echo(...args) { return args; }")
+      _(@vm.call('echo', {symbolize_names: true, name: 'x'})).must_equal [{'symbolize_names' => true, 'name' => 'x'}]
+      _(@vm.call('echo', 1, {symbolize_names: true})).must_equal [1, {'symbolize_names' => true}]
+      _(@vm.call('echo', {symbolize_names: true}, symbolize_names: true)).must_equal [{symbolize_names: true}]
+    end
+
+    it "refuses symbolize_names: mixed with other keywords" do
+      @vm.eval_code("function echo(...args) { return args; }")
+      err = _ { @vm.call('echo', 1, name: 'x', symbolize_names: true) }.must_raise ArgumentError
+      _(err.message).must_include 'symbolize_names'
+    end
+
   end
 
   describe "Function" do
@@ -1840,6 +2132,154 @@ describe Quickjs::VM do
       _(trace[3]).must_equal '    at <eval> (<code>:1:10)'
     end
   end
+
+  describe "ArenaAllocator" do
+    it "rejects an unknown allocator" do
+      _ { Quickjs::VM.new(allocator: :jemalloc) }.must_raise ArgumentError
+    end
+
+    it "evaluates, grows, and shrinks on an arena" do
+      vm = Quickjs::VM.new(allocator: :arena, features: [::Quickjs::POLYFILL_URL])
+
+      _(vm.eval_code('new URL("https://example.com/a").pathname')).must_equal '/a'
+      _(vm.eval_code('globalThis.big = "x".repeat(4 * 1024 * 1024); big.length')).must_equal 4 * 1024 * 1024
+      _(vm.eval_code('Array.from({ length: 10000 }, (_, i) => ({ i })).reduce((a, o) => a + o.i, 0)')).must_equal 49995000
+      _(vm.eval_code('new SharedArrayBuffer(1024).byteLength')).must_equal 1024
+      before = vm.memory_usage[:malloc_size]
+      vm.eval_code('globalThis.big = undefined')
+      vm.gc!
+      _(vm.memory_usage[:malloc_size]).must_be :<=, before
+      _(vm.heap_bytes).must_equal vm.memory_usage[:malloc_size]
+      _(vm.dispose!).must_be_nil
+    end
+
+    it "enforces memory_limit" do
+      vm = Quickjs::VM.new(allocator: :arena, memory_limit: 1024 * 1024)
+
+      _ { vm.eval_code('new Array(2_000_000).fill(0); void 0') }.must_raise Quickjs::RuntimeError
+      _(vm.memory_poisoned?).must_equal true
+    end
+
+    it "charges the global budget for the chunks it keeps mapped" do
+      Quickjs.reaper_flush
+      vm = Quickjs::VM.new(allocator: :arena)
+      # Small objects only, so everything freed below sits in chunks.
+      vm.eval_code('let list = null; for (let i = 0; i < 100000; i++) list = { i, next: list }; globalThis.list = list; 1')
+      held = Quickjs.global_memory_used
+      live = vm.heap_bytes
+      vm.eval_code('globalThis.list = undefined')
+      vm.gc!
+
+      freed = live - vm.heap_bytes
+      _(freed).must_be :>, 1024 * 1024
+      _(held - Quickjs.global_memory_used).must_be :<, freed / 4
+      vm.dispose!
+      _(Quickjs.global_memory_used).must_be :<, held - freed
+    end
+
+    it "tears down through JS_FreeRuntime when std is loaded" do
+      vm = Quickjs::VM.new(allocator: :arena, features: [::Quickjs::MODULE_STD])
+
+      _(vm.eval_code('typeof std.open')).must_equal 'function'
+      _(vm.dispose!).must_be_nil
+    end
+
+    it "cannot be combined with a shared runtime" do
+      rt = Quickjs::Runtime.new
+      _ { Quickjs::VM.new(runtime: rt, allocator: :arena) }.must_raise ArgumentError
+    ensure
+      rt&.dispose!
+    end
+  end
+
+  describe "Intrinsics" do
+    it "installs only the listed intrinsics" do
+      vm = Quickjs::VM.new(intrinsics: [:json])
+      _(vm.eval_code('JSON.stringify({ a: [1, 2] })')).must_equal '{"a":[1,2]}'
+      _(vm.eval_code('[typeof Date, typeof RegExp, typeof Map, typeof Proxy, typeof Uint8Array].join()')).must_equal(
+        'undefined,undefined,undefined,undefined,undefined'
+      )
+      _(vm.eval_code('typeof Promise + typeof Math.max + typeof Symbol')).must_equal 'functionfunctionfunction'
+    end
+
+    it "still evaluates async code and imports" do
+      vm = Quickjs::VM.new(intrinsics: [])
+      _(vm.eval_code('await Promise.resolve(41) + 1', async: true)).must_equal 42
+      vm.import(['answer'], from: 'export const answer = 42;')
+      _(vm.eval_code('answer')).must_equal 42
+    end
+
+    it "adds what bundled features use" do
+      vm = Quickjs::VM.new(intrinsics: [], features: [::Quickjs::POLYFILL_URL, ::Quickjs::POLYFILL_ENCODING])
+      _(vm.eval_code('new URL("https://example.com/a?b=1").searchParams.get("b")')).must_equal '1'
+      _(vm.eval_code('new TextEncoder().encode("hé").length')).must_equal 3
+      _(vm.eval_code('typeof Map')).must_equal 'undefined'
+    end
+
+    it "uses less memory than a full context" do
+      full = Quickjs::VM.new
+      minimal = Quickjs::VM.new(intrinsics: [:json])
+      _(minimal.heap_bytes).must_be :<, full.heap_bytes
+    end
+
+    it "keeps the same intrinsics across reset!" do
+      vm = Quickjs::VM.new(intrinsics: [:date])
+      vm.reset!
+      _(vm.eval_code('typeof Date + typeof Map')).must_equal 'functionundefined'
+    end
+
+    it "applies to contexts on a shared runtime" do
+      rt = Quickjs::Runtime.new
+      vm = rt.new_context(intrinsics: [:map_set])
+      _(vm.eval_code('typeof Map + typeof Date')).must_equal 'functionundefined'
+    ensure
+      rt&.dispose!
+    end
+
+    it "rejects unknown names" do
+      _ { Quickjs::VM.new(intrinsics: [:bigfloat]) }.must_raise ArgumentError
+      _ { Quickjs::VM.new(intrinsics: ['json']) }.must_raise ArgumentError
+      _ { Quickjs::VM.new(intrinsics: :json) }.must_raise TypeError
+    end
+  end
+
+  describe "InitProfile" do
+    it "is nil unless profile_init: is given" do
+      _(Quickjs::VM.new.init_profile).must_be_nil
+    end
+
+    it "records each construction phase in order" do
+      vm = Quickjs::VM.new(features: [::Quickjs::POLYFILL_FILE, ::Quickjs::POLYFILL_URL], profile_init: true)
+      profile = vm.init_profile
+
+      _(profile.map { |row| row[:phase] }).must_equal [
+        :runtime, :runtime_hooks, ::Quickjs::POLYFILL_FILE, :file_proxy, ::Quickjs::POLYFILL_URL, :console,
+      ]
+      profile.each do |row|
+        _(row[:msec]).must_be_kind_of Float
+        _(row[:msec]).must_be :>=, 0
+        _(row[:allocations]).must_be :>=, 0
+      end
+      _(profile.first[:allocations]).must_be :>, 0
+      _(profile.find { |row| row[:phase] == ::Quickjs::POLYFILL_URL }[:bytes]).must_be :>, 0
+      _(profile).must_be :frozen?
+    end
+
+    it "stops recording once construction is done" do
+      vm = Quickjs::VM.new(features: [::Quickjs::POLYFILL_URL], profile_init: true)
+      rows = vm.init_profile.size
+      vm.reset!
+      _(vm.init_profile.size).must_equal rows
+    end
+
+    it "times the context rather than the runtime on a shared runtime" do
+      rt = Quickjs::Runtime.new
+      vm = Quickjs::VM.new(runtime: rt, profile_init: true)
+      _(vm.init_profile.map { |row| row[:phase] }).must_equal [:context, :console]
+    ensure
+      rt&.dispose!
+    end
+  end
 end
 
 describe "Quickjs::Blocking" do
@@ -0,0 +1,64 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+
+describe Quickjs::Float64Array do
+  before do
+    @vm = Quickjs::VM.new
+    @vm.eval_code(<<~JS)
+      globalThis.describe = (a) => [a.constructor.name, a.length, a[1]];
+      globalThis.double = (a) => a.map((x) => x * 2);
+    JS
+  end
+
+  after { @vm.dispose! }
+
+  it "packs numbers and reads them back" do
+    floats = Quickjs::Float64Array.new([1.5, 2, -0.25])
+    _(floats.size).must_equal 3
+    _(floats[1]).must_equal 2.0
+    _(floats[-1]).must_equal(-0.25)
+    _(floats[3]).must_be_nil
+    _(floats.to_a).must_equal [1.5, 2.0, -0.25]
+    _(floats.map { |x| x * 2 }).must_equal [3.0, 4.0, -0.5]
+    _(floats.bytes).must_equal [1.5, 2, -0.25].pack('d*')
+    _(floats.bytes).must_be :frozen?
+
+    ints = Quickjs::Int32Array.new([1, -2, 2**31 - 1])
+    _(ints.to_a).must_equal [1, -2, 2**31 - 1]
+    _ { Quickjs::Int32Array.new([2**31]) }.must_raise RangeError
+    _ { Quickjs::Float64Array.new(['1']) }.must_raise TypeError
+  end
+
+  it "reaches JS as the matching typed array" do
+    _(@vm.call('describe', Quickjs::Float64Array.new([0.5, 1.5]))).must_equal ['Float64Array', 2, 1.5]
+    _(@vm.call('describe', Quickjs::Int32Array.new([7, 8, 9]))).must_equal ['Int32Array', 3, 8]
+  end
+
+  it "comes back from JS packed" do
+    doubled = @vm.call('double', Quickjs::Float64Array.new([1.25, 3]))
+    _(doubled).must_equal Quickjs::Float64Array.new([2.5, 6.0])
+
+    ints = @vm.eval_code('new Int32Array([4, 5, 6]).subarray(1)')
+    _(ints).must_be_instance_of Quickjs::Int32Array
+    _(ints.to_a).must_equal [5, 6]
+
+    _(@vm.eval_code('new Uint16Array([1])')).must_equal "\x01\x00".b
+  end
+
+  it "recognises subclasses without running Symbol.hasInstance" do
+    @vm.eval_code(<<~JS)
+      Object.defineProperty(Float64Array, Symbol.hasInstance, { value() { throw new Error('hasInstance ran'); } });
+      globalThis.Samples = class extends Float64Array {};
+    JS
+    _(@vm.eval_code('new Samples([0.5, 2])')).must_equal Quickjs::Float64Array.new([0.5, 2.0])
+    _(@vm.eval_code('new Float64Array([1])')).must_be_instance_of Quickjs::Float64Array
+  end
+
+  it "round-trips a million elements" do
+    values = Array.new(1_000_000) { |i| i * 0.5 }
+    result = @vm.call('double', Quickjs::Float64Array.new(values))
+    _(result.size).must_equal 1_000_000
+    _(result[999_999]).must_equal 999_999.0
+  end
+end
@@ -0,0 +1,171 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+
+describe Quickjs::VMPool do
+  after { @pool&.shutdown }
+
+  # Warmers fill the pool asynchronously; wait for them instead of racing.
+  def wait_until_idle(pool, count)
+    deadline = Process.clock_gettime(Process::CLOCK_MONOTONIC) + 10
+    until pool.idle_count >= count
+      flunk "pool never reached #{count} idle VMs" if Process.clock_gettime(Process::CLOCK_MONOTONIC) > deadline
+      sleep 0.01
+    end
+  end
+
+  it "rejects a non-positive size" do
+    _ { Quickjs::VMPool.new(size: 0) }.must_raise ArgumentError
+  end
+
+  it "warms size VMs in the background" do
+    @pool = Quickjs::VMPool.new(size: 3)
+    wait_until_idle(@pool, 3)
+
+    _(@pool.metrics).must_include(idle: 3)
+    _(@pool.metrics[:warming]).must_equal 0
+  end
+
+  it "yields a VM built with vm_opts and returns the block's value" do
+    @pool = Quickjs::VMPool.new(size: 1, features: [::Quickjs::POLYFILL_URL])
+
+    _(@pool.checkout { |vm| vm.eval_code('new URL("https://example.com/a?b=1").pathname') }).must_equal '/a'
+  end
+
+  it "runs the setup block on every freshly built VM" do
+    @pool = Quickjs::VMPool.new(size: 2) do |vm|
+      vm.define_function(:greet) { |name| "hi #{name}" }
+    end
+    wait_until_idle(@pool, 2)
+
+    _(@pool.checkout { |vm| vm.eval_code('greet("pool")') }).must_equal 'hi pool'
+  end
+
+  it "reuses a healthy VM" do
+    @pool = Quickjs::VMPool.new(size: 1)
+
+    first = @pool.checkout { |vm| vm }
+    second = @pool.checkout { |vm| vm }
+    _(second).must_be_same_as first
+    _(@pool.recycled_count).must_equal 0
+  end
+
+  it "recycles a VM interrupted by its timeout" do
+    @pool = Quickjs::VMPool.new(size: 1, timeout_msec: 50)
+
+    first = nil
+    _ {
+      @pool.checkout { |vm| first = vm; vm.eval_code('while(true) {}') }
+    }.must_raise Quickjs::InterruptedError
+
+    second = @pool.checkout { |vm| vm }
+    _(second).wont_be_same_as first
+    _(@pool.recycled_count).must_equal 1
+  end
+
+  it "recycles an interrupted VM even when the block rescues the timeout" do
+    @pool = Quickjs::VMPool.new(size: 1, timeout_msec: 50)
+
+    first = @pool.checkout do |vm|
+      vm.eval_code('while(true) {}')
+    rescue Quickjs::InterruptedError
+      vm
+    end
+    _(first.interrupted?).must_equal true
+
+    second = @pool.checkout { |vm| vm }
+    _(second).wont_be_same_as first
+    _(second.interrupted?).must_equal false
+    _(@pool.recycled_count).must_equal 1
+  end
+
+  it "recycles a memory-poisoned VM" do
+    @pool = Quickjs::VMPool.new(size: 1, memory_limit: 1024 * 1024)
+
+    first = nil
+    _ {
+      @pool.checkout { |vm| first = vm; vm.eval_code('new Array(2_000_000).fill(0); void 0') }
+    }.must_raise Quickjs::RuntimeError
+    _(first.memory_poisoned?).must_equal true
+
+    _(@pool.checkout { |vm| vm.memory_poisoned? }).must_equal false
+    _(@pool.recycled_count).must_equal 1
+  end
+
+  it "recycles a VM whose heap grew past max_heap_growth" do
+    @pool = Quickjs::VMPool.new(size: 1, max_heap_growth: 64 * 1024)
+
+    first = @pool.checkout { |vm| vm.eval_code('globalThis.big = "x".repeat(1024 * 1024); 0'); vm }
+    second = @pool.checkout { |vm| vm }
+
+    _(second).wont_be_same_as first
+    _(@pool.recycled_count).must_equal 1
+  end
+
+  it "drops a VM the block disposed" do
+    @pool = Quickjs::VMPool.new(size: 1)
+
+    @pool.checkout(&:dispose!)
+    _(@pool.checkout { |vm| vm.disposed? }).must_equal false
+  end
+
+  it "raises Timeout::Error when no VM frees up in time" do
+    @pool = Quickjs::VMPool.new(size: 1)
+    held = Queue.new
+    release = Queue.new
+    holder = Thread.new { @pool.checkout { held << true; release.pop } }
+    held.pop
+
+    _ { @pool.checkout(timeout: 0.05) { } }.must_raise Timeout::Error
+  ensure
+    release << true
+    holder&.join
+  end
+
+  it "records wait time" do
+    @pool = Quickjs::VMPool.new(size: 1)
+    held = Queue.new
+    release = Queue.new
+    holder = Thread.new { @pool.checkout { held << true; release.pop } }
+    held.pop
+
+    waiter = Thread.new { @pool.checkout { } }
+    sleep 0.05
+    release << true
+    [holder, waiter].each(&:join)
+
+    metrics = @pool.metrics
+    _(metrics[:checkouts]).must_equal 2
+    _(metrics[:wait_time_max]).must_be :>=, 0.04
+  end
+
+  it "surfaces construction errors to the waiting caller" do
+    @pool = Quickjs::VMPool.new(size: 1) { |_vm| raise ArgumentError, 'bad setup' }
+
+    err = _ { @pool.checkout { } }.must_raise ArgumentError
+    _(err.message).must_equal 'bad setup'
+  end
+
+  it "refuses checkouts after shutdown" do
+    pool = Quickjs::VMPool.new(size: 1)
+    vm = pool.checkout { |v| v }
+    pool.shutdown
+
+    _(pool.shutdown?).must_equal true
+    _(vm.disposed?).must_equal true
+    _ { pool.checkout { } }.must_raise Quickjs::RuntimeError
+  end
+
+  it "checks recursion against the stack of the thread using the VM" do
+    @pool = Quickjs::VMPool.new(size: 1, max_stack_size: 512 * 1024)
+    wait_until_idle(@pool, 1)
+
+    @pool.checkout do |vm|
+      vm.eval_code('globalThis.depth = (n) => n === 0 ? 0 : 1 + depth(n - 1)')
+      _(vm.eval_code('depth(300)')).must_equal 300
+      err = _ { vm.eval_code('(function f() { return f() + 1; })()') }.must_raise Quickjs::RuntimeError
+      _(err.message).must_match(/stack overflow/)
+      _(Thread.new { vm.eval_code('depth(300)') }.value).must_equal 300
+    end
+  end
+end
@@ -21,9 +21,8 @@ module QuickjsTestHelpers
   #
   # The block receives an iteration count and is expected to do that many
   # units of the operation under test (e.g. eval_code calls, VM constructions).
-  # Each thread should create its own VM internally, because QuickJS records
-  # the runtime's stack base at construction time — using a VM from a thread
-  # other than its creator trips a (false) stack-overflow guard.
+  # Each thread should create its own VM internally: one VM evaluates on
+  # one thread at a time, so a shared VM would serialize the workload.
   def assert_run_in_parallel(trials: 5, total_iterations: 8, &workload)
     skip 'requires 2+ cores' if Etc.nprocessors < 2
 